@@ -0,0 +1,142 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "scene.h"
+
+// Parameterized workload for headless runs.
+// Bodies are spawned uniformly inside [spawn_min, spawn_max] with radii
+// drawn uniformly from [radius_min, radius_max] and m = ρ ⋅ (4/3)πr³.
+// A box_fraction of them are boxes with each half extent drawn from
+// [r/2, r] and m = ρ ⋅ 8 h_x h_y h_z.
+typedef struct {
+    const char* name;
+    int body_count;
+    float radius_min;
+    float radius_max;
+    float density;              // ρ
+    float box_fraction;         // Share of bodies that are boxes
+    Vec3 gravity;
+    float world_size;
+    Vec3 spawn_min;
+    Vec3 spawn_max;
+    float initial_speed;        // Max magnitude of random initial velocity
+    int explosion_interval;     // Steps between explosions (0 = none)
+    int explosion_particles;    // Particles per explosion
+    Vec3 explosion_origin;
+    float emitter_rate;         // Particles per second from a fountain at explosion_origin (0 = none)
+    bool trails;                // Every body gets a motion trail
+    unsigned int seed;
+} BenchSceneParams;
+
+// Result of a fixed-dt run
+typedef struct {
+    int body_count;             // Bodies actually present in the scene
+    int steps;
+    float dt;
+    double total_ns;
+    double steps_per_sec;
+    double ns_per_body_step;
+    double phase_ns[SCENE_PHASE_COUNT];
+    double stage_ns[COLLISION_STAGE_COUNT]; // Split of the collision phase
+    double pairs_per_step;      // Broad phase candidate pairs
+    double contacts_per_step;   // Narrow phase hits
+    double islands_per_step;    // Contact islands
+    int largest_island;         // Most bodies in one island over the run
+    double sleeping_per_step;   // Deactivated bodies
+    double warm_started_per_step; // Contacts that found last step's impulses
+    double swept_per_step;      // Bodies given continuous collision
+    double clamped_per_step;    // Swept bodies stopped at an impact
+    double box_pairs_per_step;  // Box-box pairs given a SAT test
+    double axis_rejects_per_step; // ... rejected by their cached axis alone
+    double particles_per_step;  // Live particles
+    double particle_tests_per_step; // Particle-body tests
+    double particle_hits_per_step;  // Particles put back on a surface
+    uint64_t allocations;       // Heap allocations inside scene_update over the run
+    int last_allocating_step;   // Last step that allocated, -1 if none
+} BenchResult;
+
+// Broad phase comparison on a raw body array (not limited by scene capacity)
+typedef struct {
+    int body_count;
+    int frames;
+    double ns_per_frame;
+    double pairs_per_frame;
+} BenchBroadphaseResult;
+
+// Integration cost of RigidBody records versus a BodyStore
+typedef struct {
+    int body_count;
+    int steps;
+    int aos_bytes_per_body;     // sizeof(RigidBody)
+    double aos_ns_per_body;
+    double soa_ns_per_body;
+    double aos_misses_per_body; // Hardware cache misses, -1 if unavailable
+    double soa_misses_per_body;
+} BenchLayoutResult;
+
+// Batched kernel (vec3_batch.h) against its scalar reference
+typedef struct {
+    const char* name;
+    double max_error;           // Largest |batch - scalar| / max(1, |scalar|)
+    double scalar_ns;           // Per element
+    double batch_ns;
+} BenchSimdKernel;
+
+#define BENCH_SIMD_KERNEL_COUNT 7
+
+typedef struct {
+    int count;                  // Elements per kernel call
+    const char* backend;
+    int width;
+    BenchSimdKernel kernels[BENCH_SIMD_KERNEL_COUNT];
+} BenchSimdResult;
+
+// Bullets fired through a wall of static spheres
+typedef struct {
+    float dt;
+    bool ccd;
+    int steps;
+    int bullets;
+    int tunneled;               // Bullets that ended up behind the wall
+    double ns_per_step;
+} BenchTunnelingResult;
+
+// A workload stepped on a SimThread while this thread consumes its render
+// snapshots, as the viewer's display thread would (without a GL context)
+typedef struct {
+    int steps;
+    uint64_t published;         // Snapshots the simulation thread published
+    uint64_t acquired;          // ... that the consumer took (the rest were superseded)
+    int torn;                   // Acquired snapshots whose checksum did not match
+    int out_of_order;           // Acquired snapshots older than the one before
+    bool final_matches;         // Last snapshot equals the scene after the last step
+    double ns_per_step;         // Simulation thread, including capture
+    double consume_ns;          // Consumer time per acquired snapshot
+} BenchSnapshotResult;
+
+// Standard workloads (sparse rain, dense pile, explosion heavy)
+int bench_standard_scene_count();
+const BenchSceneParams* bench_standard_scene(int index);
+const BenchSceneParams* bench_find_scene(const char* name);
+
+// Workload construction and execution
+void bench_build_scene(Scene* scene, const BenchSceneParams* params);
+// Clears a built scene, keeping its storage and settings, and adds the
+// workload's bodies again
+void bench_reset_scene(Scene* scene, const BenchSceneParams* params);
+void bench_run(Scene* scene, const BenchSceneParams* params, int steps, float dt, BenchResult* result);
+void bench_broadphase(BroadphaseType type, int body_count, int frames, BenchBroadphaseResult* result);
+void bench_layout(int body_count, int steps, BenchLayoutResult* result);
+void bench_simd(int count, BenchSimdResult* result);
+void bench_tunneling(float dt, bool ccd, BenchTunnelingResult* result);
+void bench_snapshots(const BenchSceneParams* params, int steps, float dt, BenchSnapshotResult* result);
+
+// FNV-1a over the dynamic state of every body and particle; equal hashes
+// mean bitwise equal runs
+uint64_t bench_state_hash(const Scene* scene);
+
+// Baseline files: one line per scene, "name steps_per_sec ns_per_body_step"
+bool bench_save_baseline(const char* path, const BenchSceneParams* const* scenes, const BenchResult* results, int count);
+bool bench_load_baseline(const char* path, const char* scene_name, BenchResult* result);
+
+#endif // BENCH_H
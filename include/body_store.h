@@ -0,0 +1,127 @@
+#ifndef BODY_STORE_H
+#define BODY_STORE_H
+
+#include "physics.h"
+#include <stdint.h>
+
+// Body flags
+#define BODY_FLAG_STATIC   0x01  // Infinite mass
+#define BODY_FLAG_SLEEPING 0x02  // Optimization flag
+#define BODY_FLAG_CCD      0x04  // Swept every step, whatever its speed
+#define BODY_FLAG_TRAIL    0x08  // Has a trail in the scene's TrailStore
+
+#define BODY_SLOT_PAGE_SIZE 4096  // Handle slots per page
+
+// Stable reference to a body. Indices move when other bodies are removed;
+// a handle keeps resolving to the same body until that body is removed,
+// after which its generation no longer matches.
+typedef struct {
+    uint32_t slot;
+    uint32_t generation;
+} BodyHandle;
+
+#define BODY_HANDLE_NULL ((BodyHandle){ UINT32_MAX, 0 })
+
+// Handle slot: where the body currently lives in the dense arrays
+typedef struct {
+    int index;                  // Dense index, or next free slot when unused
+    uint32_t generation;        // Bumped on every removal
+} BodySlot;
+
+// Cold per-body data, only read by the renderer
+typedef struct {
+    Vec3 color;
+} BodyVisual;
+
+// Body Store
+// Structure-of-arrays storage for the bodies of a scene. Each field lives in
+// its own contiguous array indexed by body index, so the integration and
+// broad phase loops stream only the fields they use instead of dragging
+// whole RigidBody records (materials, colors) through the cache.
+//
+// RigidBody remains the description type: bodies are built with
+// physics_init_body and copied in with body_store_add.
+//
+// The arrays grow geometrically and stay dense: removal moves the last body
+// into the hole. Code that needs to hold on to a body across removals keeps
+// a BodyHandle; handle slots live in fixed-size pages that never move.
+//
+// Bodies are kept grouped by ShapeType, so the integration sees whole SIMD
+// blocks of one shape. Adds, removals and shape changes that break the
+// grouping set shape_unsorted; body_store_sort_by_shape restores it (the
+// scene does before each step).
+typedef struct BodyStore {
+    int count;
+    int capacity;
+    bool shape_unsorted;        // Some body precedes one of a lower ShapeType
+
+    // --- Hot: forces, integration, broad phase ---
+    Vec3* position;             // x⃗(t)
+    Vec3* velocity;             // v⃗(t)
+    Vec3* force_accumulator;    // F⃗_net
+    Quat* orientation;          // q(t)
+    Vec3* angular_velocity;     // ω⃗(t)
+    Vec3* torque_accumulator;   // τ⃗_net
+    Mat3* inv_inertia_world;    // I⁻¹(t)
+    Vec3* inv_inertia_body;     // Diagonal of I⁻¹_body (principal axes)
+    float* inv_mass;            // 1/m
+    float* radius;              // r
+    float* drag_linear;         // k_d
+    float* drag_angular;        // k_ω
+    uint8_t* flags;             // BODY_FLAG_*
+    uint8_t* shape;             // ShapeType
+
+    // --- Warm: contact resolution, sleeping ---
+    float* restitution;         // ε
+    float* friction;            // μ
+    float* sleep_timer;         // Seconds spent below the sleep thresholds
+    uint32_t* sleep_group;      // While sleeping: slot of the island it fell asleep with
+
+    // --- Cold: set up once ---
+    float* mass;                // m
+    Mat3* inertia_tensor;       // I_body
+    Vec3* half_extents;         // Box only
+    int* id;
+    BodyVisual* visuals;        // Side table
+    uint32_t* slot;             // Dense index → handle slot
+
+    // --- Handles ---
+    BodySlot** slot_pages;      // [page_count][BODY_SLOT_PAGE_SIZE]
+    int page_count;
+    int slot_count;             // Slots handed out so far
+    int free_slot;              // Head of the free slot list, -1 = none
+} BodyStore;
+
+void body_store_init(BodyStore* store, int capacity);
+void body_store_free(BodyStore* store);
+void body_store_clear(BodyStore* store);
+// False if out of memory; the store keeps its old capacity
+bool body_store_reserve(BodyStore* store, int capacity);
+
+// Appends a body, growing the arrays as needed. Returns its index, or -1 if
+// out of memory (the store is unchanged).
+int body_store_add(BodyStore* store, const RigidBody* body);
+
+// Swap-remove: the last body moves into index. Its handle stays valid.
+void body_store_remove(BodyStore* store, int index);
+
+// Regroups the bodies by ShapeType; handles follow their bodies.
+// Returns true if any index changed.
+bool body_store_sort_by_shape(BodyStore* store);
+
+// Clears BODY_FLAG_SLEEPING and restarts the body's rest timer
+void body_store_wake(BodyStore* store, int index);
+// F⃗_net += F⃗ on a stored body; wakes it
+void body_store_add_force(BodyStore* store, int index, Vec3 force);
+// τ⃗_net += τ⃗ on a stored body; wakes it
+void body_store_add_torque(BodyStore* store, int index, Vec3 torque);
+
+// Handle of the body at index / current index of a handle (-1 if stale)
+BodyHandle body_store_handle(const BodyStore* store, int index);
+int body_store_index(const BodyStore* store, BodyHandle handle);
+
+// Gather/scatter between a store slot and the RigidBody description
+void body_store_read(const BodyStore* store, int index, RigidBody* out);
+void body_store_write(BodyStore* store, int index, const RigidBody* body);
+
+#endif // BODY_STORE_H
@@ -0,0 +1,32 @@
+#ifndef BOX_COLLISION_H
+#define BOX_COLLISION_H
+
+#include "collision.h"
+
+#define BOX_SAT_AXIS_COUNT 15       // 3 faces of A, 3 faces of B, 9 edge pairs
+#define BOX_SAT_EDGE_PREFERENCE 0.95f // An edge axis must beat the best face by this factor
+
+// Box in world space
+typedef struct {
+    Vec3 center;
+    Vec3 axis[3];       // Unit; columns of R(q)
+    Vec3 half;          // Half extent along each axis
+} OrientedBox;
+
+OrientedBox oriented_box_make(Vec3 center, Quat orientation, Vec3 half_extents);
+
+// Box against box by the separating axis theorem. Axes are numbered 0-2
+// (faces of A), 3-5 (faces of B) and 6-14 (edge of A × edge of B). hint
+// (-1 = none) is tested first, so a pair still separated by last step's
+// axis costs one projection. *axis receives the separating axis, or the
+// axis of least penetration when the boxes touch. Normal from A to B.
+bool box_box_contact(const OrientedBox* a, const OrientedBox* b, int hint, Contact* contact, int* axis);
+
+// Box against sphere; normal from the box to the sphere, point on the box
+bool box_sphere_contact(const OrientedBox* box, Vec3 center, float radius, Contact* contact);
+
+// Box against the half-space n̂ ⋅ x⃗ ≥ offset; normal -n̂, point at the
+// centroid of the vertices behind the plane
+bool box_plane_contact(const OrientedBox* box, Vec3 normal, float offset, Contact* contact);
+
+#endif // BOX_COLLISION_H
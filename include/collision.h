@@ -1,11 +1,28 @@
 #ifndef COLLISION_H
 #define COLLISION_H
 
-#include "physics.h"
+#include "body_store.h"
+#include "frame_arena.h"
+#include "pair_cache.h"
+#include "particles.h"
 #include <stdbool.h>
 
 #define MAX_OCTREE_DEPTH 4
 #define OCTREE_CAPACITY 8
+#define OCTREE_POOL_SIZE (((1 << (3 * (MAX_OCTREE_DEPTH + 1))) - 1) / 7) // Σ 8^d, d ≤ MAX_OCTREE_DEPTH
+#define OCTREE_POOL_NODE_BODIES (2 * OCTREE_CAPACITY) // Initial body array of a pooled node
+#define OCTREE_FAT_MARGIN 0.25f // Proxy enlargement, as a fraction of radius
+#define COLLISION_ISLAND_GRAIN 8 // Islands per work range
+#define COLLISION_SOLVER_ITERATIONS 4 // Default velocity iterations
+#define COLLISION_RESTITUTION_THRESHOLD 0.5f // Slower approaches do not bounce (m/s)
+#define COLLISION_ROLLING_RESISTANCE 0.1f // μ_r; rolling torque ≤ μ_r r λ_n
+#define CONTACT_WORLD -1 // Contact.b of a contact with a boundary plane (static, infinite mass)
+#define COLLISION_CCD_MOTION 1.0f // Bodies moving more than this fraction of their radius per step are swept
+#define COLLISION_CCD_SKIN 0.01f // Swept bodies stop this far past first touch, so the narrow phase sees the contact
+#define COLLISION_CCD_GRAIN 16 // Swept bodies per work range
+#define COLLISION_PARTICLE_GRAIN 4096   // Particles per work range
+#define COLLISION_PARTICLE_CANDIDATES 64 // Most grid candidates per particle
+#define COLLISION_PARTICLE_MASK 32      // Cells per axis of the particle occupancy mask
 
 // A bounding box (AABB)
 typedef struct {
@@ -15,39 +32,320 @@ typedef struct {
 
 // Octree Node
 // Divides space recursively into 8 octants to optimize spatial queries.
+// Bodies are referenced from every leaf their box overlaps.
 typedef struct OctreeNode {
     AABB bounds;
     struct OctreeNode* children[8]; // Pointers to sub-octants
-    RigidBody** bodies;             // Dynamic array of pointers to bodies in this node
+    int* bodies;                    // Dynamic array of body indices in this node
     int body_count;
     int capacity;
     bool is_leaf;
 } OctreeNode;
 
+// Heap body array a crowded leaf gave back, kept for the next one
+typedef struct {
+    int* bodies;
+    int capacity;
+} OctreeSpareArray;
+
+// Octree Node Pool
+// Storage for the largest tree MAX_OCTREE_DEPTH allows, taken in one piece
+// when the collision system first builds its octree. Released nodes go on
+// a free list (linked through children[0]). Every node owns a slice of
+// body_slab; a crowded leaf moves to a larger heap array, which returns to
+// the spares when the node is emptied, so only a new high of crowded
+// leaves allocates.
+typedef struct {
+    OctreeNode* nodes;          // OCTREE_POOL_SIZE
+    int* body_slab;             // OCTREE_POOL_NODE_BODIES per node
+    int used;                   // Nodes handed out from nodes
+    OctreeNode* free_list;
+    OctreeSpareArray* spares;
+    int spare_count;
+    int spare_capacity;
+} OctreePool;
+
+// Static boundary: a half-space. Points with n̂ ⋅ x⃗ ≥ offset are inside
+// the world, so the normal points into it.
+typedef struct {
+    Vec3 normal;        // Unit
+    float offset;
+} CollisionPlane;
+
 // Contact Manifold
 // Stores details about a collision for resolution
 typedef struct {
-    RigidBody* a;
-    RigidBody* b;
+    int a;              // Body indices
+    int b;              // CONTACT_WORLD for a boundary plane
+    int plane;          // CollisionSystem.planes index when b is CONTACT_WORLD
     Vec3 normal;        // Points from A to B
     Vec3 point;         // Point of contact in world space
     float penetration;  // Depth of overlap
+
+    // --- Sequential impulse state (set up by the solver) ---
+    Vec3 ra;            // Contact point relative to the centers
+    Vec3 rb;
+    Vec3 tangent[2];    // Friction directions, ⊥ n̂
+    Vec3 angular_a[3];  // r⃗_A ∧ d̂ for d̂ = n̂, t̂₁, t̂₂
+    Vec3 angular_b[3];
+    Vec3 response_a[3]; // I⁻¹_A (r⃗_A ∧ d̂), spin per unit impulse
+    Vec3 response_b[3];
+    float inv_mass_a;   // 0 for static bodies and boundaries
+    float inv_mass_b;
+    float normal_mass;  // 1 / (n̂ ⋅ K n̂)
+    float tangent_mass[2];
+    float velocity_bias; // Restitution target for v⃗ᵣₑₗ ⋅ n̂
+    float friction;     // μ
+    float normal_impulse; // Accumulated λ_n ≥ 0
+    float tangent_impulse[2]; // Accumulated, |λ_t| ≤ μλ_n
+    float rolling;      // μ_r r
+    Vec3 rolling_impulse; // Accumulated angular impulse, ‖λ⃗_r‖ ≤ μ_r r λ_n
 } Contact;
 
+// Impulses a body pair ended the last step with (CollisionSystem.cache)
+typedef struct {
+    float normal_impulse;       // Accumulated λ_n
+    Vec3 friction_impulse;      // Accumulated tangential impulse, world space
+} ContactImpulse;
+
+// Sequential impulse settings
+typedef struct {
+    int iterations;     // Velocity passes over each island's contacts
+    bool warm_start;    // Start from the impulses cached last step
+} ContactSolverSettings;
+
+// Continuous collision settings
+typedef struct {
+    bool enabled;
+    float motion_threshold;     // Sweep bodies whose step exceeds this fraction of their radius
+} ContinuousSettings;
+
+// Box around a body's step; continuous collision keeps these sorted by min x
+typedef struct {
+    AABB box;
+    int body;
+} SweepKey;
+
+// Candidate pair produced by the broad phase (indices into the body array, a < b)
+typedef struct {
+    int a;
+    int b;
+} BodyPair;
+
+// Growable pair buffer; storage is reused across frames
+typedef struct {
+    BodyPair* pairs;
+    int count;
+    int capacity;
+} PairList;
+
+// Contact Island
+// Dynamic bodies connected through contacts. Static bodies do not join
+// islands, so two piles resting on the same floor stay independent.
+typedef struct {
+    int first_contact;  // Range in CollisionSystem.island_contacts
+    int contact_count;
+    int body_count;     // Dynamic bodies
+    int awake_count;    // Bodies not flagged sleeping
+    float rest_time;    // Shortest sleep timer among its bodies
+    uint32_t sleep_group; // Group id its bodies get when it falls asleep
+} ContactIsland;
+
+// Broad phase algorithm used by collision_system_update
+typedef enum {
+    BROADPHASE_BRUTE_FORCE, // All pairs, O(N²); reference
+    BROADPHASE_OCTREE,      // Persistent octree with fat proxies
+    BROADPHASE_GRID,        // Spatial hash over a uniform grid
+    BROADPHASE_SAP,         // Incremental sweep and prune
+    BROADPHASE_COUNT
+} BroadphaseType;
+
+// Stages of collision_system_update, run in this order. Each reads the
+// buffer the previous one filled:
+//   ccd           bodies   → fast bodies moved back to their first impact
+//   broad phase   bodies   → pairs
+//   narrow phase  pairs    → contacts (plus boundary plane contacts)
+//   islands       contacts → islands; wakes sleepers that are touched
+//   solve         islands  → velocities and positions; caches impulses
+typedef enum {
+    COLLISION_STAGE_CCD,
+    COLLISION_STAGE_BROADPHASE,
+    COLLISION_STAGE_NARROWPHASE,
+    COLLISION_STAGE_ISLANDS,
+    COLLISION_STAGE_SOLVE,
+    COLLISION_STAGE_COUNT
+} CollisionStage;
+
+struct SpatialHash;
+struct SweepPrune;
+struct ThreadPool;
+
+typedef struct CollisionSystem CollisionSystem;
+
+// A pipeline stage; replacements must fill the same buffers as the default
+typedef void (*CollisionStageFn)(CollisionSystem* sys, BodyStore* bodies);
+
+// Collision System
+// Owns the broad phase structures, the per-frame pair and contact buffers
+// and the stage table that connects them.
+typedef struct CollisionSystem {
+    BroadphaseType broadphase;
+    AABB world_bounds;
+
+    // Static boundaries; the six faces of world_bounds by default
+    CollisionPlane* planes;
+    int plane_count;
+    int plane_capacity;
+    float dt;                   // Step being resolved
+
+    // Persistent octree over the body store
+    OctreeNode* octree;
+    OctreePool octree_pool;
+    AABB* proxies;              // Fat AABB per body index
+    int proxy_capacity;
+    int tracked_count;          // Bodies currently in the octree
+
+    // Uniform grid (created on first use)
+    struct SpatialHash* grid;
+    float grid_cell_size;       // 0 = twice the largest radius
+
+    // Sweep and prune (created on first use)
+    struct SweepPrune* sap;
+
+    // Bodies swept by the last update and their time of impact (fraction
+    // of the step, 1 = none)
+    ContinuousSettings ccd;
+    int* swept;
+    float* swept_toi;
+    int swept_count;
+    int swept_capacity;
+    AABB* sweep_boxes;          // Box around each body's step (frame)
+    SweepKey* sweep_order;      // Every body by box min x, kept across steps
+    int sweep_tracked;          // Bodies in sweep_order
+    int sweep_capacity;         // Size of sweep_order
+    float sweep_width;          // Widest box in x
+
+    // Candidate pairs of the last update
+    PairList pairs;
+
+    // Contacts of the last update and the islands they form
+    Contact* contacts;
+    int contact_count;
+    int contact_capacity;
+    int* island_contacts;       // Contact indices grouped by island
+    int* contact_island;        // Island per contact (frame)
+    uint8_t* pair_hit;          // Bounding-sphere overlap per pair (frame)
+    ContactIsland* islands;
+    int island_count;
+    int* body_island;           // Island per body index, -1 = no contacts
+    int island_body_count;      // Bodies covered by body_island
+    int* island_parent;         // Union-find forest (frame)
+    int island_capacity;        // Size of the per-body arrays
+    uint8_t* wake_mark;         // Sleep groups to wake, by handle slot (frame)
+    int wake_mark_capacity;
+
+    // Scratch buffers marked (frame) above live here until the next update
+    FrameArena frame;
+
+    // Separating axis of each box pair (int), carried between steps. Pairs
+    // that stay apart are usually separated by the same axis as last step,
+    // so testing it first rejects them after one axis instead of fifteen.
+    PairCache axes;
+
+    // Impulses carried between steps (ContactImpulse), and how they are used
+    PairCache cache;
+    ContactSolverSettings solver;
+
+    // Islands are resolved concurrently when set (not owned)
+    struct ThreadPool* pool;
+
+    // Pipeline; defaults are the collision_stage_* functions
+    CollisionStageFn stages[COLLISION_STAGE_COUNT];
+
+    // Statistics of the last update
+    int reinserted;             // Proxies that left their fat box
+    int largest_island;         // Bodies in the biggest island
+    int warm_started;           // Contacts that found cached impulses
+    int ccd_clamped;            // Swept bodies stopped at an impact
+    int box_pairs;              // Box-box pairs past the bounding-sphere test
+    int axis_rejects;           // ... rejected by their cached separating axis
+    // Cells of world_bounds touched by a body; bit x of row [z][y]
+    uint32_t particle_mask[COLLISION_PARTICLE_MASK][COLLISION_PARTICLE_MASK];
+    int particle_tests;         // Particle-body tests of the last particle pass
+    int particle_hits;          // Particles put back on a surface
+    uint64_t stage_ns[COLLISION_STAGE_COUNT]; // Wall time per stage
+} CollisionSystem;
+
 // --- Collision System ---
-void collision_system_init(float world_size);
-void collision_system_update(RigidBody* bodies, int count);
-void collision_system_cleanup();
+void collision_system_init(CollisionSystem* sys, float world_size);
+void collision_system_set_world_size(CollisionSystem* sys, float world_size);
+// Resolves the step of length dt the bodies were just integrated over
+void collision_system_update(CollisionSystem* sys, BodyStore* bodies, float dt);
+void collision_system_find_pairs(CollisionSystem* sys, const BodyStore* bodies);
+// Call before body_store_remove(bodies, index): the body is dropped from the
+// broad phase and the last body is renamed to index
+void collision_system_remove_body(CollisionSystem* sys, const BodyStore* bodies, int index);
+// Call after bodies changed indices (body_store_sort_by_shape): drops the
+// broad phase state kept by index. The pair caches are keyed by handle and stay.
+void collision_system_forget_bodies(CollisionSystem* sys);
+// After an update: puts every island (and every body without contacts) whose
+// bodies have all rested for time_to_sleep to sleep, as one sleep group.
+// Returns the number of sleeping bodies.
+int collision_system_update_sleep(CollisionSystem* sys, BodyStore* bodies, float time_to_sleep);
+void collision_system_clear(CollisionSystem* sys);
+void collision_system_cleanup(CollisionSystem* sys);
+const char* collision_broadphase_name(BroadphaseType type);
+bool collision_broadphase_from_name(const char* name, BroadphaseType* type);
+// Boundaries: the six faces of world_bounds (also set by set_world_size),
+// none, or an extra half-space n̂ ⋅ x⃗ ≥ offset
+void collision_system_reset_planes(CollisionSystem* sys);
+void collision_system_clear_planes(CollisionSystem* sys);
+// False if the plane list could not grow; the plane is not added
+bool collision_system_add_plane(CollisionSystem* sys, Vec3 normal, float offset);
+// Grows the contact buffer to hold count contacts; false leaves it as it was
+bool collision_system_reserve_contacts(CollisionSystem* sys, int count);
+// Pushes particles out of bodies and boundary planes after an update. Bodies
+// near each particle come from the broad phase structure: the leaf of the
+// octree, otherwise the uniform grid (built here for brute force and SAP).
+void collision_system_collide_particles(CollisionSystem* sys, const BodyStore* bodies, ParticleStore* particles,
+                                        const ParticleCollisionSettings* settings);
+
+// --- Pipeline Stages ---
+void collision_stage_ccd(CollisionSystem* sys, BodyStore* bodies);
+void collision_stage_broadphase(CollisionSystem* sys, BodyStore* bodies);
+void collision_stage_narrowphase(CollisionSystem* sys, BodyStore* bodies);
+void collision_stage_islands(CollisionSystem* sys, BodyStore* bodies);
+void collision_stage_solve(CollisionSystem* sys, BodyStore* bodies);
+const char* collision_stage_name(CollisionStage stage);
+
+// --- Pair Lists ---
+// False if the list could not grow; the pair is dropped
+bool pair_list_push(PairList* list, int a, int b);
+void pair_list_free(PairList* list);
+
+// --- Bounding Volumes ---
+AABB aabb_from_sphere(Vec3 center, float radius);
+bool aabb_overlap(AABB a, AABB b);
+bool aabb_contains(AABB outer, AABB inner);
 
 // --- Octree Methods ---
-OctreeNode* octree_build(AABB bounds, RigidBody** bodies, int count, int depth);
+// NULL if a node could not be allocated
+OctreeNode* octree_build(AABB bounds, const AABB* boxes, int count, int depth);
 void octree_destroy(OctreeNode* node);
-void octree_query(OctreeNode* node, RigidBody* body, RigidBody** results, int* count);
+// At most max_results bodies; mark has one entry per body (see collision.c)
+int octree_query(const OctreeNode* node, AABB box, uint32_t* mark, uint32_t stamp, int* results, int max_results);
+void octree_for_each_leaf(OctreeNode* node, void (*visit)(OctreeNode* leaf, void* user), void* user);
+// Leaf whose bounds contain p, NULL outside the tree
+const OctreeNode* octree_find_leaf(const OctreeNode* node, Vec3 p);
 
 // --- Narrow Phase ---
-bool collision_detect_sphere_sphere(RigidBody* a, RigidBody* b, Contact* contact);
+bool collision_detect_sphere_sphere(const BodyStore* bodies, int a, int b, Contact* contact);
+// Earliest t ∈ [0, 1] at which spheres starting at pa, pb and moving by
+// da, db first touch; false if they start overlapped or never touch
+bool collision_sphere_toi(Vec3 pa, Vec3 da, Vec3 pb, Vec3 db, float radius_sum, float* toi);
 
 // --- Resolution ---
-void collision_resolve(Contact* c);
+void collision_project(BodyStore* bodies, const Contact* c);
+void collision_resolve(BodyStore* bodies, const Contact* c);
 
-#endif // COLLISION_H
\ No newline at end of file
+#endif // COLLISION_H
@@ -0,0 +1,36 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stddef.h>
+
+#define FRAME_ARENA_ALIGN 32            // Fits any lane type in simd.h
+#define FRAME_ARENA_MIN_SIZE (64 * 1024)
+
+// Overflow block, freed at the next reset
+typedef struct FrameArenaBlock {
+    struct FrameArenaBlock* next;
+} FrameArenaBlock;
+
+// Frame Arena
+// Bump allocator for scratch memory that lives for one step. Reset is
+// O(1) and frees nothing individually. A step that needs more than the
+// arena holds gets heap blocks for the excess; the next reset replaces the
+// arena with one at least twice that step's total, so a workload stops
+// allocating once it no longer doubles its largest step.
+typedef struct {
+    unsigned char* base;
+    size_t capacity;
+    size_t used;
+    size_t step_total;          // Bytes requested since the last reset
+    size_t peak;                // Largest step_total seen
+    FrameArenaBlock* overflow;
+} FrameArena;
+
+void frame_arena_init(FrameArena* arena);
+void frame_arena_free(FrameArena* arena);
+void frame_arena_reset(FrameArena* arena);
+
+// FRAME_ARENA_ALIGN-aligned, uninitialized, valid until the next reset
+void* frame_arena_alloc(FrameArena* arena, size_t size);
+
+#endif // FRAME_ARENA_H
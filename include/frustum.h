@@ -0,0 +1,33 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "collision.h"
+
+// View Frustum
+// Six planes n⃗ · x⃗ + d ≥ 0 (inside) taken from the clip matrix M = P V
+// (Gribb–Hartmann): with rᵢ the rows of M, left = r₃ + r₀, right = r₃ − r₀,
+// bottom = r₃ + r₁, top = r₃ − r₁, near = r₃ + r₂, far = r₃ − r₂.
+// Planes are normalized, so n⃗ · x⃗ + d is a signed distance.
+typedef struct {
+    Vec3 normal;
+    float d;
+} FrustumPlane;
+
+typedef struct {
+    FrustumPlane planes[6];
+} Frustum;
+
+typedef enum {
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECT,
+    FRUSTUM_INSIDE,             // Everything in the box is visible
+} FrustumResult;
+
+// clip is column-major, as glGetFloatv returns it
+void frustum_from_matrix(Frustum* frustum, const float clip[16]);
+
+bool frustum_test_sphere(const Frustum* frustum, Vec3 center, float radius);
+bool frustum_test_point(const Frustum* frustum, Vec3 point);
+FrustumResult frustum_test_aabb(const Frustum* frustum, AABB box);
+
+#endif // FRUSTUM_H
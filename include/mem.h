@@ -0,0 +1,21 @@
+#ifndef MEM_H
+#define MEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Heap Allocation
+// Every engine module allocates through these instead of the C library
+// directly, so the number of heap allocations can be watched: a steady
+// scene_update makes none (scene->stats.allocations, bench --alloc-check).
+// mem_realloc counts when it is asked for memory; shrinking to zero and
+// mem_free do not count.
+void* mem_malloc(size_t size);
+void* mem_calloc(size_t count, size_t size);
+void* mem_realloc(void* ptr, size_t size);
+void mem_free(void* ptr);
+
+// Allocations since startup, across all threads
+uint64_t mem_allocation_count();
+
+#endif // MEM_H
@@ -0,0 +1,44 @@
+#ifndef PAIR_CACHE_H
+#define PAIR_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Pair Cache
+// Per-pair state carried from one step to the next, keyed by the pair's
+// handle slots so entries survive index changes from removals. Each cache
+// holds one fixed-size payload per pair (warm-start impulses, the last
+// separating axis). Two open-addressing tables alternate: lookups read the
+// previous step's table while the current step's payloads are written to
+// the other, so pairs that stop being stored drop out after one step.
+typedef struct {
+    unsigned char* current;     // entry_size bytes per slot: key, generations, payload
+    unsigned char* previous;
+    size_t entry_size;
+    size_t payload_size;
+    int current_capacity;       // Power of two
+    int previous_capacity;
+    int current_count;
+    int previous_count;
+} PairCache;
+
+// key = slot_a << 32 | slot_b with slot_a < slot_b (never 0); generations
+// holds the handle generations in the same order
+void pair_cache_init(PairCache* cache, size_t payload_size);
+void pair_cache_free(PairCache* cache);
+void pair_cache_clear(PairCache* cache);
+
+// Makes the current table the previous one and empties a table with room
+// for count pairs. False if that table could not be allocated; stores are
+// then dropped until the next begin.
+bool pair_cache_begin(PairCache* cache, int count);
+
+// Payload from the previous step, NULL if the pair was not stored (or one
+// of its bodies has been replaced since)
+const void* pair_cache_find(const PairCache* cache, uint64_t key, uint64_t generations);
+
+// Records a pair's payload for the next step
+void pair_cache_store(PairCache* cache, uint64_t key, uint64_t generations, const void* payload);
+
+#endif // PAIR_CACHE_H
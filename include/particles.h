@@ -0,0 +1,79 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "vec3.h"
+#include "thread_pool.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PARTICLE_PARALLEL_GRAIN 8192  // Particles per work range
+#define PARTICLE_GRAVITY_SCALE 0.5f   // Particles fall under light gravity
+
+// How new particles are drawn: speed, life and each color channel
+// uniform in [min, max], direction from uniform spherical angles
+typedef struct {
+    float speed_min, speed_max; // m/s
+    float life_min, life_max;   // s
+    Vec3 color_min, color_max;
+} ParticleSpawn;
+
+// Particle Emitter
+// Emits rate particles per second at position; fractions of a particle
+// carry over to the next step. Each emitter draws from its own xorshift32
+// state, so emitters do not disturb each other's sequences.
+typedef struct {
+    Vec3 position;
+    float rate;                 // Particles per second
+    ParticleSpawn spawn;
+    bool active;
+    float owed;                 // Particles due but not yet emitted
+    uint32_t rng;               // 0: scene_add_emitter picks a seed per emitter
+} Emitter;
+
+// Particle response to bodies and boundary planes (collision.h). A
+// particle found inside is put back on the surface, keeps restitution of
+// its approach speed and loses friction of its sliding speed; bodies are
+// not pushed back.
+typedef struct {
+    bool enabled;
+    float restitution;
+    float friction;
+} ParticleCollisionSettings;
+
+// Particle Storage (structure of arrays)
+// Live particles occupy [0, count); expired ones are swap-removed after
+// each update, so every loop runs over a dense range and spawning appends
+// at count. Storage only grows.
+typedef struct {
+    Vec3* position;
+    Vec3* velocity;
+    float* life;                // Seconds left
+    float* max_life;
+    Vec3* color;
+
+    int count;
+    int capacity;
+} ParticleStore;
+
+void particle_store_init(ParticleStore* store);
+void particle_store_free(ParticleStore* store);
+void particle_store_clear(ParticleStore* store);
+// False if an array could not grow; capacity is then unchanged
+bool particle_store_reserve(ParticleStore* store, int capacity);
+
+// count particles at origin drawn from spawn with the given PRNG state;
+// fewer when the storage cannot grow
+void particle_store_emit(ParticleStore* store, Vec3 origin, int count, const ParticleSpawn* spawn, uint32_t* rng);
+
+// Ages and moves every particle, then removes the expired ones. The
+// per-particle pass runs on pool (NULL = inline); the result does not
+// depend on the thread count.
+void particle_store_update(ParticleStore* store, ThreadPool* pool, Vec3 gravity, float dt);
+
+// Owed particles for this step, emitted into store
+void emitter_update(Emitter* emitter, ParticleStore* store, float dt);
+
+// The orange burst of scene_spawn_explosion
+ParticleSpawn particle_spawn_explosion();
+
+#endif // PARTICLES_H
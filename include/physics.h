@@ -3,12 +3,11 @@
 
 #include "vec3.h"
 
-#define TRAIL_LENGTH 50
-
 // Type of collider shape
 typedef enum {
-    SHAPE_SPHERE,
-    SHAPE_BOX       // Placeholder for future expansion
+    SHAPE_SPHERE,   // Isotropic inertia: I⁻¹_world = I⁻¹_body
+    SHAPE_BOX,      // Diagonal inertia; oriented-box contacts (box_collision.h)
+    SHAPE_COUNT
 } ShapeType;
 
 // Rigid Body State
@@ -27,8 +26,13 @@ typedef struct {
     float mass;             // m
     float inv_mass;         // 1/m
     Mat3 inertia_tensor;    // I_body (Constant in local frame)
+    Mat3 inv_inertia_body;  // I⁻¹_body (Cached at init, diagonal)
     Mat3 inv_inertia_world; // I⁻¹(t) (Varies in world frame)
 
+    // --- Shape ---
+    ShapeType shape;
+    Vec3 half_extents;      // Box only
+
     // --- Material Properties ---
     float radius;           // r (for bounding sphere)
     float restitution;      // ε (Bounciness)
@@ -38,17 +42,19 @@ typedef struct {
     
     // --- Visuals ---
     Vec3 color;
-    Vec3 trail[TRAIL_LENGTH];
-    int trail_head;
+    bool trail;             // Opt in to a motion trail (trail_store.h)
     
     // --- Flags ---
     bool is_static;         // Infinite mass
     bool is_sleeping;       // Optimization flag
+    bool is_bullet;         // Continuous collision at any speed
     int id;                 // Unique identifier
 } RigidBody;
 
 // Initialization
 void physics_init_body(RigidBody* body, Vec3 pos, float mass, float radius, int id);
+// Solid box; radius becomes the bounding sphere ‖h⃗‖
+void physics_init_box(RigidBody* body, Vec3 pos, float mass, Vec3 half_extents, int id);
 
 // Force Application
 void physics_add_force(RigidBody* body, Vec3 force);
@@ -58,6 +64,12 @@ void physics_add_torque(RigidBody* body, Vec3 torque);
 // Integration Step
 void physics_integrate(RigidBody* body, float dt);
 
+// Streaming integration of bodies [begin, end) of a BodyStore.
+// Same dynamics as physics_integrate; motion trails are sampled separately.
+// Runs of bodies with the same shape take that shape's kernel.
+struct BodyStore;
+void physics_integrate_store(struct BodyStore* store, int begin, int end, float dt);
+
 // Utility
 void physics_update_inertia(RigidBody* body);
 
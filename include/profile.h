@@ -0,0 +1,88 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Step Profiling
+// Timed zones and counters recorded by scene_update and the collision
+// stages. Build with -DPHYSICS_PROFILE to record; otherwise the PROFILE_*
+// macros expand to nothing and the engine carries no instrumentation.
+// Nothing is recorded until profile_start. Zones and counters are named by
+// string literals, compared by address, and recorded from the stepping
+// thread.
+//
+// Captured events go to a fixed buffer (further events are counted as
+// dropped) and are written as a Chrome trace_event file, viewable in
+// chrome://tracing or Perfetto. Independently, the totals of each frame
+// (one profile_frame_end per scene_update) are kept for the last
+// PROFILE_HISTORY frames as a rolling summary.
+
+#define PROFILE_MAX_ZONES 32        // Distinct zone names in the summary
+#define PROFILE_MAX_COUNTERS 16     // Distinct counter names in the summary
+#define PROFILE_HISTORY 120         // Frames in the rolling summary
+
+#ifdef PHYSICS_PROFILE
+#define PROFILE_ZONE(var) uint64_t var = profile_zone_begin()
+#define PROFILE_ZONE_END(var, name) profile_span((name), (var), profile_zone_begin())
+#define PROFILE_SPAN(name, start_ns, end_ns) profile_span((name), (start_ns), (end_ns))
+#define PROFILE_COUNTER(name, value) profile_counter((name), (int64_t)(value))
+#define PROFILE_FRAME_END() profile_frame_end()
+#else
+#define PROFILE_ZONE(var) ((void)0)
+#define PROFILE_ZONE_END(var, name) ((void)0)
+#define PROFILE_SPAN(name, start_ns, end_ns) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_FRAME_END() ((void)0)
+#endif
+
+// Mean and worst over the frames in the summary window
+typedef struct {
+    const char* name;
+    double mean_ns;
+    uint64_t max_ns;
+    int calls;                  // Zone ends in the window
+} ProfileZoneSummary;
+
+typedef struct {
+    const char* name;
+    double mean;
+    int64_t max;
+    int64_t last;
+} ProfileCounterSummary;
+
+typedef struct {
+    int frames;                 // Frames in the window (≤ PROFILE_HISTORY)
+    int zone_count;
+    int counter_count;
+    ProfileZoneSummary zones[PROFILE_MAX_ZONES];
+    ProfileCounterSummary counters[PROFILE_MAX_COUNTERS];
+} ProfileSummary;
+
+// Starts recording with room for event_capacity trace events (0 = summary
+// only) and clears the summary. Allocates; call outside the step.
+bool profile_start(int event_capacity);
+void profile_stop();
+bool profile_active();
+
+// Later events appear as a separate process row named name in the trace;
+// the summary restarts
+void profile_begin_track(const char* name);
+
+// Called through the PROFILE_* macros. A span records a zone from
+// timestamps the caller already took; zone_begin is 0 while not recording.
+uint64_t profile_zone_begin();
+void profile_span(const char* name, uint64_t start_ns, uint64_t end_ns);
+void profile_counter(const char* name, int64_t value);
+void profile_frame_end();
+
+void profile_summary(ProfileSummary* out);
+void profile_print_summary(FILE* out);
+
+// Events captured since profile_start, and how many did not fit
+int profile_event_count();
+int profile_dropped_count();
+bool profile_write_chrome_trace(const char* path);
+
+#endif // PROFILE_H
@@ -0,0 +1,116 @@
+#ifndef RENDER_SNAPSHOT_H
+#define RENDER_SNAPSHOT_H
+
+#include "scene.h"
+#include "stepper.h"
+#include <stdatomic.h>
+
+#define RENDER_AXIS_SCALE 1.5f      // Body axes are drawn this many radii long
+
+// Node of the snapshot's culling hierarchy
+typedef struct {
+    AABB bounds;                // Everything drawn for the subtree's bodies
+    int next;                   // Node after this subtree (pre-order)
+    int body_first;             // Subtree's bodies: cull_bodies[body_first, body_end)
+    int body_end;
+    bool leaf;
+} RenderCullNode;
+
+// Render Snapshot
+// Everything the renderer draws, copied out of a Scene after a step: body
+// transforms before and after the step, colors, shapes, the trails of
+// bodies that have one and the live particles. A snapshot never points into the scene, so it can be drawn
+// while the next step runs.
+//
+// Bodies are drawn at x⃗ = lerp(x⃗_prev, x⃗, α) with α advancing in wall
+// time from the stepper's leftover at publication (render_snapshot_alpha),
+// i.e. one step behind the simulation.
+//
+// With the octree broad phase, the snapshot also carries the octree as a
+// culling hierarchy: its non-empty nodes in pre-order, each body listed
+// under the first leaf that holds it, with bounds fitted to the bodies'
+// spheres (axes included) before and after the step. The renderer tests
+// nodes against the view frustum and skips or accepts whole subtrees.
+typedef struct {
+    uint64_t sequence;          // Steps taken when captured
+    uint64_t published_ns;      // timer_now_ns at capture, 0 = never written
+    float step_dt;              // Seconds per step, 0 = no interpolation
+    float alpha;                // Stepper's α at capture
+    float world_size;
+
+    int body_count;
+    int body_capacity;
+    Vec3* prev_position;        // Before the last step
+    Quat* prev_orientation;
+    Vec3* position;
+    Quat* orientation;
+    Vec3* color;
+    float* radius;
+    uint8_t* shape;             // ShapeType
+    Vec3* half_extents;
+
+    int trail_count;            // Empty unless bodies opted in to trails
+    int trail_capacity;
+    int* trail_body;            // Body index of each trail
+    Vec3* trail;                // TRAIL_LENGTH points per trail, oldest first
+    AABB* trail_bounds;
+
+    RenderCullNode* cull_nodes; // Empty without an octree
+    int cull_node_count;
+    int cull_node_capacity;
+    int* cull_bodies;           // Body indices grouped by node (body_capacity)
+    uint8_t* cull_taken;        // Capture scratch: body already listed
+
+    int particle_count;
+    int particle_capacity;
+    Vec3* particle_position;
+    Vec3* particle_color;
+    float* particle_alpha;      // life / max_life
+
+    uint64_t checksum;          // render_snapshot_checksum if the producer set it, else 0
+} RenderSnapshot;
+
+void render_snapshot_free(RenderSnapshot* snap);
+
+// Copies the scene's drawable state. stepper may be NULL (no interpolation).
+void render_snapshot_capture(RenderSnapshot* snap, const Scene* scene, const SceneStepper* stepper);
+
+// FNV-1a over every field but published_ns and checksum
+uint64_t render_snapshot_checksum(const RenderSnapshot* snap);
+
+// Interpolation weight at wall time now_ns, clamped to 1
+float render_snapshot_alpha(const RenderSnapshot* snap, uint64_t now_ns);
+void render_snapshot_body_transform(const RenderSnapshot* snap, int index, float alpha, Vec3* position, Quat* orientation);
+
+// Triple Buffer
+// One producer and one consumer exchange snapshots without locks. The
+// producer fills `back` and swaps it into `middle`; the consumer swaps
+// `middle` into `front` when it holds a newer snapshot. Each side only ever
+// touches the slot it owns, so neither waits for the other, and the
+// consumer always gets the latest complete snapshot (older unread ones are
+// overwritten).
+#define RENDER_BUFFER_FRESH 4u      // Set in middle when it holds an unread snapshot
+
+typedef struct {
+    RenderSnapshot slots[3];
+    int back;                   // Producer's slot
+    int front;                  // Consumer's slot
+    atomic_uint middle;         // Slot index | RENDER_BUFFER_FRESH
+
+    // Owned by their side
+    uint64_t published;
+    uint64_t acquired;
+} RenderTripleBuffer;
+
+void render_buffer_init(RenderTripleBuffer* buffer);
+void render_buffer_free(RenderTripleBuffer* buffer);
+
+// Producer: fill back, then publish it
+RenderSnapshot* render_buffer_back(RenderTripleBuffer* buffer);
+void render_buffer_publish(RenderTripleBuffer* buffer);
+
+// Consumer: the newest published snapshot, NULL before the first. Valid
+// until the next acquire.
+const RenderSnapshot* render_buffer_acquire(RenderTripleBuffer* buffer);
+
+#endif // RENDER_SNAPSHOT_H
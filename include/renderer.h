@@ -1,7 +1,8 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
-#include "scene.h"
+#include "frustum.h"
+#include "render_snapshot.h"
 
 // Camera System
 typedef struct {
@@ -15,9 +16,70 @@ typedef struct {
 
 extern Camera g_camera;
 
+#define RENDERER_FOV_Y 45.0f          // Degrees
+#define RENDERER_NEAR 0.1f
+#define RENDERER_FAR 500.0f
+
+// Sphere LODs: level l has renderer_sphere_segments(l) slices and as many
+// stacks. A sphere takes the finest level whose pixel threshold its
+// projected radius r_px = r (h / 2) / (tan(fov_y / 2) d) reaches, d being
+// its distance from the camera and h the viewport height.
+#define RENDERER_SPHERE_LODS 4
+#define RENDERER_LOD_PIXELS { 24.0f, 8.0f, 3.0f, 0.0f }
+
+// Immediate: glBegin blocks and a GLU sphere per body. Instanced: buffers
+// and instanced draws (renderer_instanced.h); the default where supported.
+typedef enum {
+    RENDER_PATH_IMMEDIATE,
+    RENDER_PATH_INSTANCED,
+} RenderPath;
+
+// Last renderer_render_snapshot
+typedef struct {
+    int draw_calls;             // glBegin blocks plus glDraw* calls
+    int bodies;                 // Drawn
+    int bodies_culled;
+    int particles;
+    int particles_culled;
+    int trail_vertices;
+    int trails_culled;
+    int cull_nodes_tested;      // Snapshot hierarchy nodes tested against the frustum
+    int lod_spheres[RENDERER_SPHERE_LODS];
+    long triangles;             // Bodies only
+    uint64_t submit_ns;         // CPU time to issue the frame (no glFinish)
+} RenderStats;
+
+// What survives culling in a frame: visible bodies with their interpolated
+// transforms and sphere LOD, visible trails (snapshot trail indices), and
+// visible particles. Built by renderer_render_snapshot for both paths.
+typedef struct {
+    int body_count;
+    int* bodies;
+    Vec3* position;
+    Quat* orientation;
+    uint8_t* lod;
+    int trail_count;
+    int* trails;
+    int particle_count;
+    int* particles;
+} RenderVisibility;
+
+// Needs a current GL context; no GLUT calls, so it also runs offscreen
 void renderer_init();
 void renderer_resize(int w, int h);
-void renderer_render_scene(const Scene* scene);
+// Bodies are drawn interpolated to the current wall time; NULL draws an empty
+// frame (nothing published yet). The caller presents the frame.
+void renderer_render_snapshot(const RenderSnapshot* snap);
+// False if the path is not available in this context
+bool renderer_set_path(RenderPath path);
+RenderPath renderer_path();
+const char* renderer_path_name(RenderPath path);
+const RenderStats* renderer_stats();
+// Frustum culling and sphere LODs, on by default. Off draws everything at
+// the finest level.
+void renderer_set_culling(bool enabled);
+bool renderer_culling();
+int renderer_sphere_segments(int lod);
 void renderer_update_camera_mouse(float x, float y);
 void renderer_update_camera_keyboard(bool* keys, float dt);
 void renderer_debug_octree(struct OctreeNode* node);
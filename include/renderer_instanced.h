@@ -0,0 +1,25 @@
+#ifndef RENDERER_INSTANCED_H
+#define RENDERER_INSTANCED_H
+
+#include "renderer.h"
+
+// Instanced Renderer
+// Retained-mode path behind renderer_render_snapshot. The sphere, cube and
+// axis meshes are built into vertex buffers once. Each frame the body
+// transforms and colors go into one instance buffer and the trail and
+// particle vertices into one stream buffer, then everything is drawn with
+// one instanced draw per sphere LOD in use, one for the boxes and one for
+// the axes, one multi-draw for the trails and one point draw for the
+// particles. Only what survived culling is uploaded.
+//
+// Needs OpenGL 3.3 (instanced arrays) with GLSL 1.20 in a compatibility
+// context; Mesa's llvmpipe qualifies.
+
+// False if the context cannot run this path
+bool renderer_instanced_init();
+void renderer_instanced_free();
+
+// Adds its draw calls to stats
+void renderer_instanced_draw(const RenderSnapshot* snap, const RenderVisibility* vis, RenderStats* stats);
+
+#endif // RENDERER_INSTANCED_H
@@ -2,35 +2,57 @@
 #define SCENE_H
 
 #include "physics.h"
+#include "collision.h"
+#include "particles.h"
+#include "thread_pool.h"
+#include "trail_store.h"
 #include <stdbool.h>
+#include <stdint.h>
 
-#define MAX_BODIES 64
-#define MAX_PARTICLES 512
+#define SCENE_PARALLEL_GRAIN 1024 // Bodies per work range
+#define EXPLOSION_WAKE_RADIUS 10.0f // Sleeping bodies this close to an explosion wake
 
-// Particle for effects
+// Body deactivation
+// A body rests while |v⃗| and |ω⃗| stay below the thresholds; after
+// time_to_sleep seconds of rest (for every body of its contact island) it
+// is skipped by forces, integration and the octree refit until woken.
 typedef struct {
-    Vec3 position;
-    Vec3 velocity;
-    float life;
-    float max_life;
-    Vec3 color;
-    bool active;
-} Particle;
-
-// Particle Emitter
+    bool enabled;
+    float linear_threshold;     // m/s
+    float angular_threshold;    // rad/s
+    float time_to_sleep;        // s
+} SleepSettings;
+
+// Phases of a single scene_update step
+typedef enum {
+    SCENE_PHASE_FORCES,
+    SCENE_PHASE_INTEGRATE,
+    SCENE_PHASE_COLLISION,
+    SCENE_PHASE_PARTICLES,
+    SCENE_PHASE_PARTICLE_COLLISION,
+    SCENE_PHASE_COUNT
+} ScenePhase;
+
+// Accumulated step timings (cleared by scene_reset_stats)
 typedef struct {
-    Vec3 position;
-    int rate;
-    bool active;
-} Emitter;
+    uint64_t phase_ns[SCENE_PHASE_COUNT];
+    uint64_t steps;
+    uint64_t allocations;       // Heap allocations made inside scene_update (mem.h)
+    uint64_t last_allocations;  // ... by the latest step; 0 once storage has grown to the workload
+} SceneStats;
 
 // Scene definition
 typedef struct {
-    RigidBody bodies[MAX_BODIES];
-    int body_count;
+    BodyStore bodies;           // SoA storage, indexed 0..bodies.count-1
+    TrailStore trails;          // Bodies with BODY_FLAG_TRAIL; trails.interval sets the schedule
     
-    Particle particles[MAX_PARTICLES];
-    int particle_count;
+    ParticleStore particles;    // Live particles, dense; expired ones are swap-removed
+    uint32_t particle_rng;      // Draws for scene_spawn_explosion
+    ParticleCollisionSettings particle_collision;
+
+    Emitter* emitters;          // Continuous sources, updated before the particles
+    int emitter_count;
+    int emitter_capacity;
     
     // Forces
     Vec3 gravity;
@@ -39,13 +61,42 @@ typedef struct {
     
     // World Properties
     float world_size;
+    
+    // Broad phase and narrow phase state
+    CollisionSystem collision;
+    
+    // Workers for the per-body phases (NULL = single-threaded)
+    ThreadPool* pool;
+    
+    // Deactivation
+    SleepSettings sleep;
+    int sleeping_count;         // Sleeping bodies after the last step
+    
+    // Instrumentation
+    SceneStats stats;
 } Scene;
 
 void scene_init(Scene* scene);
 void scene_reset(Scene* scene);
-void scene_add_body(Scene* scene, RigidBody body);
+void scene_destroy(Scene* scene);
+// BODY_HANDLE_NULL if out of memory
+BodyHandle scene_add_body(Scene* scene, RigidBody body);
+bool scene_remove_body(Scene* scene, BodyHandle handle);
+int scene_body_index(const Scene* scene, BodyHandle handle);
+// Accumulate until the next step and wake the body; false for a stale handle
+bool scene_add_force(Scene* scene, BodyHandle handle, Vec3 force);
+bool scene_add_force_at_point(Scene* scene, BodyHandle handle, Vec3 force, Vec3 point);
+bool scene_add_torque(Scene* scene, BodyHandle handle, Vec3 torque);
 void scene_update(Scene* scene, float dt);
 void scene_spawn_explosion(Scene* scene, Vec3 pos, int count);
-RigidBody* scene_get_body(Scene* scene, int index);
+int scene_add_emitter(Scene* scene, Emitter emitter);
+bool scene_get_body(const Scene* scene, int index, RigidBody* out);
+void scene_set_body(Scene* scene, int index, const RigidBody* body);
+// Starts a trail collapsed at the body or drops its trail; false for a stale handle
+bool scene_set_trail(Scene* scene, BodyHandle handle, bool enabled);
+void scene_set_thread_count(Scene* scene, int threads);
+void scene_wake_all(Scene* scene);
+void scene_reset_stats(Scene* scene);
+const char* scene_phase_name(ScenePhase phase);
 
 #endif // SCENE_H
\ No newline at end of file
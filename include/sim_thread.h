@@ -0,0 +1,39 @@
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include "render_snapshot.h"
+
+#define SIM_THREAD_MAX_COMMANDS 64  // Posted but not yet run
+
+// Runs on the simulation thread between steps, with exclusive access
+typedef void (*SimCommandFn)(Scene* scene, void* user);
+
+typedef struct {
+    bool free_run;              // Step back to back instead of at step_hz in wall time
+    uint64_t step_limit;        // Stop after this many steps (0 = until sim_thread_stop)
+    bool checksum;              // Fill RenderSnapshot.checksum
+} SimThreadSettings;
+
+// Simulation Thread
+// Owns a scene and its stepper while running: advances the stepper by
+// wall-clock time and sleeps until the next step is due, then publishes a
+// RenderSnapshot through a triple buffer. The display thread reads only
+// snapshots, so neither side waits for the other. Changes to the scene
+// are posted as commands and run before the next step.
+typedef struct SimThread SimThread;
+
+// settings may be NULL (wall-clock pacing, no limit, no checksum)
+SimThread* sim_thread_start(Scene* scene, SceneStepper* stepper, const SimThreadSettings* settings);
+// Stops and joins the thread; the scene is the caller's again
+void sim_thread_stop(SimThread* sim);
+
+// Display thread side
+const RenderSnapshot* sim_thread_acquire(SimThread* sim);
+bool sim_thread_post(SimThread* sim, SimCommandFn fn, void* user);
+bool sim_thread_finished(const SimThread* sim);
+
+// Snapshots published and taken so far
+uint64_t sim_thread_published(const SimThread* sim);
+uint64_t sim_thread_acquired(const SimThread* sim);
+
+#endif // SIM_THREAD_H
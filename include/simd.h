@@ -0,0 +1,285 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "vec3.h"
+
+// ============================================================================
+// LANES
+// ============================================================================
+// A Lanes value holds one float per body for SIMD_WIDTH bodies. The width
+// is fixed at build time: AVX2 (8), SSE2 (4) or a portable scalar fallback
+// (4, left to the compiler). Define PHYSICS_SIMD_SCALAR to force the
+// fallback. Division and square roots are exact in every backend so the
+// batched kernels track the scalar reference in vec3.c closely.
+
+#if !defined(PHYSICS_SIMD_SCALAR) && defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 8
+#define SIMD_BACKEND "avx2"
+typedef __m256 Lanes;
+
+static inline Lanes lanes_set1(float s)             { return _mm256_set1_ps(s); }
+static inline Lanes lanes_load(const float* p)      { return _mm256_loadu_ps(p); }
+static inline void lanes_store(float* p, Lanes a)   { _mm256_storeu_ps(p, a); }
+static inline Lanes lanes_add(Lanes a, Lanes b)     { return _mm256_add_ps(a, b); }
+static inline Lanes lanes_sub(Lanes a, Lanes b)     { return _mm256_sub_ps(a, b); }
+static inline Lanes lanes_mul(Lanes a, Lanes b)     { return _mm256_mul_ps(a, b); }
+static inline Lanes lanes_div(Lanes a, Lanes b)     { return _mm256_div_ps(a, b); }
+static inline Lanes lanes_sqrt(Lanes a)             { return _mm256_sqrt_ps(a); }
+static inline Lanes lanes_abs(Lanes a)              { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+// Masks are all-ones / all-zero per lane
+static inline Lanes lanes_lt(Lanes a, Lanes b)      { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline Lanes lanes_select(Lanes mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); }
+static inline int lanes_movemask(Lanes mask)        { return _mm256_movemask_ps(mask); }
+
+#elif !defined(PHYSICS_SIMD_SCALAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 4
+#define SIMD_BACKEND "sse2"
+typedef __m128 Lanes;
+
+static inline Lanes lanes_set1(float s)             { return _mm_set1_ps(s); }
+static inline Lanes lanes_load(const float* p)      { return _mm_loadu_ps(p); }
+static inline void lanes_store(float* p, Lanes a)   { _mm_storeu_ps(p, a); }
+static inline Lanes lanes_add(Lanes a, Lanes b)     { return _mm_add_ps(a, b); }
+static inline Lanes lanes_sub(Lanes a, Lanes b)     { return _mm_sub_ps(a, b); }
+static inline Lanes lanes_mul(Lanes a, Lanes b)     { return _mm_mul_ps(a, b); }
+static inline Lanes lanes_div(Lanes a, Lanes b)     { return _mm_div_ps(a, b); }
+static inline Lanes lanes_sqrt(Lanes a)             { return _mm_sqrt_ps(a); }
+static inline Lanes lanes_abs(Lanes a)              { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline Lanes lanes_lt(Lanes a, Lanes b)      { return _mm_cmplt_ps(a, b); }
+static inline Lanes lanes_select(Lanes mask, Lanes a, Lanes b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+static inline int lanes_movemask(Lanes mask)        { return _mm_movemask_ps(mask); }
+
+#else
+#define SIMD_WIDTH 4
+#define SIMD_BACKEND "scalar"
+typedef struct { float v[SIMD_WIDTH]; } Lanes;
+
+#define LANES_MAP(expr) Lanes r; for (int l = 0; l < SIMD_WIDTH; l++) r.v[l] = (expr); return r
+
+static inline Lanes lanes_set1(float s)             { LANES_MAP(s); }
+static inline Lanes lanes_load(const float* p)      { LANES_MAP(p[l]); }
+static inline void lanes_store(float* p, Lanes a)   { for (int l = 0; l < SIMD_WIDTH; l++) p[l] = a.v[l]; }
+static inline Lanes lanes_add(Lanes a, Lanes b)     { LANES_MAP(a.v[l] + b.v[l]); }
+static inline Lanes lanes_sub(Lanes a, Lanes b)     { LANES_MAP(a.v[l] - b.v[l]); }
+static inline Lanes lanes_mul(Lanes a, Lanes b)     { LANES_MAP(a.v[l] * b.v[l]); }
+static inline Lanes lanes_div(Lanes a, Lanes b)     { LANES_MAP(a.v[l] / b.v[l]); }
+static inline Lanes lanes_sqrt(Lanes a)             { LANES_MAP(sqrtf(a.v[l])); }
+static inline Lanes lanes_abs(Lanes a)              { LANES_MAP(fabsf(a.v[l])); }
+// Masks hold 1 / 0 per lane
+static inline Lanes lanes_lt(Lanes a, Lanes b)      { LANES_MAP(a.v[l] < b.v[l] ? 1.0f : 0.0f); }
+static inline Lanes lanes_select(Lanes mask, Lanes a, Lanes b) { LANES_MAP(mask.v[l] != 0.0f ? a.v[l] : b.v[l]); }
+static inline int lanes_movemask(Lanes mask) {
+    int bits = 0;
+    for (int l = 0; l < SIMD_WIDTH; l++) bits |= (mask.v[l] != 0.0f) << l;
+    return bits;
+}
+
+#undef LANES_MAP
+#endif
+
+// ============================================================================
+// VECTOR TYPES
+// ============================================================================
+// Component-wise SoA views of SIMD_WIDTH vectors, quaternions and matrices.
+
+typedef struct { Lanes x, y, z; } Vec3Lanes;
+typedef struct { Lanes w, x, y, z; } QuatLanes;
+typedef struct { Lanes m[3][3]; } Mat3Lanes;
+
+// --- Transposition to and from array-of-structs storage ---
+static inline Vec3Lanes vec3_lanes_load(const Vec3* v) {
+    float t[3][SIMD_WIDTH];
+    for (int l = 0; l < SIMD_WIDTH; l++) { t[0][l] = v[l].x; t[1][l] = v[l].y; t[2][l] = v[l].z; }
+    return (Vec3Lanes){ lanes_load(t[0]), lanes_load(t[1]), lanes_load(t[2]) };
+}
+
+static inline void vec3_lanes_store(Vec3* v, Vec3Lanes a) {
+    float t[3][SIMD_WIDTH];
+    lanes_store(t[0], a.x); lanes_store(t[1], a.y); lanes_store(t[2], a.z);
+    for (int l = 0; l < SIMD_WIDTH; l++) v[l] = (Vec3){ t[0][l], t[1][l], t[2][l] };
+}
+
+static inline QuatLanes quat_lanes_load(const Quat* q) {
+    float t[4][SIMD_WIDTH];
+    for (int l = 0; l < SIMD_WIDTH; l++) { t[0][l] = q[l].w; t[1][l] = q[l].x; t[2][l] = q[l].y; t[3][l] = q[l].z; }
+    return (QuatLanes){ lanes_load(t[0]), lanes_load(t[1]), lanes_load(t[2]), lanes_load(t[3]) };
+}
+
+static inline void quat_lanes_store(Quat* q, QuatLanes a) {
+    float t[4][SIMD_WIDTH];
+    lanes_store(t[0], a.w); lanes_store(t[1], a.x); lanes_store(t[2], a.y); lanes_store(t[3], a.z);
+    for (int l = 0; l < SIMD_WIDTH; l++) q[l] = (Quat){ t[0][l], t[1][l], t[2][l], t[3][l] };
+}
+
+// Spelled out per element: -O2 does not unroll the 9-element loops, and
+// the indexed version spends more time addressing than computing
+static inline Mat3Lanes mat3_lanes_load(const Mat3* m) {
+    float t[3][3][SIMD_WIDTH];
+    for (int l = 0; l < SIMD_WIDTH; l++) {
+        t[0][0][l] = m[l].m[0][0]; t[0][1][l] = m[l].m[0][1]; t[0][2][l] = m[l].m[0][2];
+        t[1][0][l] = m[l].m[1][0]; t[1][1][l] = m[l].m[1][1]; t[1][2][l] = m[l].m[1][2];
+        t[2][0][l] = m[l].m[2][0]; t[2][1][l] = m[l].m[2][1]; t[2][2][l] = m[l].m[2][2];
+    }
+    Mat3Lanes r;
+    r.m[0][0] = lanes_load(t[0][0]); r.m[0][1] = lanes_load(t[0][1]); r.m[0][2] = lanes_load(t[0][2]);
+    r.m[1][0] = lanes_load(t[1][0]); r.m[1][1] = lanes_load(t[1][1]); r.m[1][2] = lanes_load(t[1][2]);
+    r.m[2][0] = lanes_load(t[2][0]); r.m[2][1] = lanes_load(t[2][1]); r.m[2][2] = lanes_load(t[2][2]);
+    return r;
+}
+
+static inline void mat3_lanes_store(Mat3* m, Mat3Lanes a) {
+    float t[3][3][SIMD_WIDTH];
+    lanes_store(t[0][0], a.m[0][0]); lanes_store(t[0][1], a.m[0][1]); lanes_store(t[0][2], a.m[0][2]);
+    lanes_store(t[1][0], a.m[1][0]); lanes_store(t[1][1], a.m[1][1]); lanes_store(t[1][2], a.m[1][2]);
+    lanes_store(t[2][0], a.m[2][0]); lanes_store(t[2][1], a.m[2][1]); lanes_store(t[2][2], a.m[2][2]);
+    for (int l = 0; l < SIMD_WIDTH; l++) {
+        m[l].m[0][0] = t[0][0][l]; m[l].m[0][1] = t[0][1][l]; m[l].m[0][2] = t[0][2][l];
+        m[l].m[1][0] = t[1][0][l]; m[l].m[1][1] = t[1][1][l]; m[l].m[1][2] = t[1][2][l];
+        m[l].m[2][0] = t[2][0][l]; m[l].m[2][1] = t[2][1][l]; m[l].m[2][2] = t[2][2][l];
+    }
+}
+
+static inline Lanes lanes_gather(const float* p, const int* index) {
+    float t[SIMD_WIDTH];
+    for (int l = 0; l < SIMD_WIDTH; l++) t[l] = p[index[l]];
+    return lanes_load(t);
+}
+
+// ============================================================================
+// LANE MATH (same formulas as the scalar functions in vec3.c)
+// ============================================================================
+
+static inline Vec3Lanes vec3_lanes_add(Vec3Lanes a, Vec3Lanes b) {
+    return (Vec3Lanes){ lanes_add(a.x, b.x), lanes_add(a.y, b.y), lanes_add(a.z, b.z) };
+}
+
+static inline Vec3Lanes vec3_lanes_scale(Vec3Lanes v, Lanes s) {
+    return (Vec3Lanes){ lanes_mul(v.x, s), lanes_mul(v.y, s), lanes_mul(v.z, s) };
+}
+
+// Component-wise a⃗ ⊙ b⃗
+static inline Vec3Lanes vec3_lanes_mul(Vec3Lanes a, Vec3Lanes b) {
+    return (Vec3Lanes){ lanes_mul(a.x, b.x), lanes_mul(a.y, b.y), lanes_mul(a.z, b.z) };
+}
+
+// q₁ ⊗ q₂
+static inline QuatLanes quat_lanes_mul(QuatLanes a, QuatLanes b) {
+    QuatLanes r;
+    r.w = lanes_sub(lanes_sub(lanes_sub(lanes_mul(a.w, b.w), lanes_mul(a.x, b.x)), lanes_mul(a.y, b.y)), lanes_mul(a.z, b.z));
+    r.x = lanes_sub(lanes_add(lanes_add(lanes_mul(a.w, b.x), lanes_mul(a.x, b.w)), lanes_mul(a.y, b.z)), lanes_mul(a.z, b.y));
+    r.y = lanes_add(lanes_add(lanes_sub(lanes_mul(a.w, b.y), lanes_mul(a.x, b.z)), lanes_mul(a.y, b.w)), lanes_mul(a.z, b.x));
+    r.z = lanes_add(lanes_sub(lanes_add(lanes_mul(a.w, b.z), lanes_mul(a.x, b.y)), lanes_mul(a.y, b.x)), lanes_mul(a.z, b.w));
+    return r;
+}
+
+// q̂; lanes with ‖q‖ ≤ 1e-9 become the identity
+static inline QuatLanes quat_lanes_normalize(QuatLanes q) {
+    Lanes mag = lanes_sqrt(lanes_add(lanes_add(lanes_mul(q.w, q.w), lanes_mul(q.x, q.x)),
+                                     lanes_add(lanes_mul(q.y, q.y), lanes_mul(q.z, q.z))));
+    Lanes valid = lanes_lt(lanes_set1(1e-9f), mag);
+    Lanes inv = lanes_div(lanes_set1(1.0f), mag);
+    Lanes zero = lanes_set1(0.0f);
+    return (QuatLanes){
+        lanes_select(valid, lanes_mul(q.w, inv), lanes_set1(1.0f)),
+        lanes_select(valid, lanes_mul(q.x, inv), zero),
+        lanes_select(valid, lanes_mul(q.y, inv), zero),
+        lanes_select(valid, lanes_mul(q.z, inv), zero)
+    };
+}
+
+// R(q)
+static inline Mat3Lanes quat_lanes_to_mat3(QuatLanes q) {
+    Lanes one = lanes_set1(1.0f), two = lanes_set1(2.0f);
+    Lanes xx = lanes_mul(q.x, q.x), yy = lanes_mul(q.y, q.y), zz = lanes_mul(q.z, q.z);
+    Lanes xy = lanes_mul(q.x, q.y), xz = lanes_mul(q.x, q.z), yz = lanes_mul(q.y, q.z);
+    Lanes wx = lanes_mul(q.w, q.x), wy = lanes_mul(q.w, q.y), wz = lanes_mul(q.w, q.z);
+    Mat3Lanes m;
+    m.m[0][0] = lanes_sub(one, lanes_mul(two, lanes_add(yy, zz)));
+    m.m[0][1] = lanes_mul(two, lanes_sub(xy, wz));
+    m.m[0][2] = lanes_mul(two, lanes_add(xz, wy));
+    m.m[1][0] = lanes_mul(two, lanes_add(xy, wz));
+    m.m[1][1] = lanes_sub(one, lanes_mul(two, lanes_add(xx, zz)));
+    m.m[1][2] = lanes_mul(two, lanes_sub(yz, wx));
+    m.m[2][0] = lanes_mul(two, lanes_sub(xz, wy));
+    m.m[2][1] = lanes_mul(two, lanes_add(yz, wx));
+    m.m[2][2] = lanes_sub(one, lanes_mul(two, lanes_add(xx, yy)));
+    return m;
+}
+
+// u⃗ = M v⃗
+static inline Vec3Lanes mat3_lanes_mul_vec(const Mat3Lanes* m, Vec3Lanes v) {
+    Vec3Lanes r;
+    r.x = lanes_add(lanes_add(lanes_mul(m->m[0][0], v.x), lanes_mul(m->m[0][1], v.y)), lanes_mul(m->m[0][2], v.z));
+    r.y = lanes_add(lanes_add(lanes_mul(m->m[1][0], v.x), lanes_mul(m->m[1][1], v.y)), lanes_mul(m->m[1][2], v.z));
+    r.z = lanes_add(lanes_add(lanes_mul(m->m[2][0], v.x), lanes_mul(m->m[2][1], v.y)), lanes_mul(m->m[2][2], v.z));
+    return r;
+}
+
+// M⁻¹ by cofactors; lanes with |det| < 1e-6 become the identity
+static inline Mat3Lanes mat3_lanes_inverse(const Mat3Lanes* a) {
+    #define M(i, j) a->m[i][j]
+    #define CROSS(p, q, r, s) lanes_sub(lanes_mul(p, q), lanes_mul(r, s))
+    Lanes c00 = CROSS(M(1,1), M(2,2), M(2,1), M(1,2));
+    Lanes c01 = CROSS(M(1,0), M(2,2), M(1,2), M(2,0));
+    Lanes c02 = CROSS(M(1,0), M(2,1), M(1,1), M(2,0));
+    Lanes det = lanes_add(lanes_sub(lanes_mul(M(0,0), c00), lanes_mul(M(0,1), c01)), lanes_mul(M(0,2), c02));
+    Lanes valid = lanes_lt(lanes_set1(1e-6f), lanes_abs(det));
+    Lanes inv_det = lanes_div(lanes_set1(1.0f), det);
+
+    Mat3Lanes r;
+    r.m[0][0] = lanes_mul(c00, inv_det);
+    r.m[0][1] = lanes_mul(CROSS(M(0,2), M(2,1), M(0,1), M(2,2)), inv_det);
+    r.m[0][2] = lanes_mul(CROSS(M(0,1), M(1,2), M(0,2), M(1,1)), inv_det);
+    r.m[1][0] = lanes_mul(CROSS(M(1,2), M(2,0), M(1,0), M(2,2)), inv_det);
+    r.m[1][1] = lanes_mul(CROSS(M(0,0), M(2,2), M(0,2), M(2,0)), inv_det);
+    r.m[1][2] = lanes_mul(CROSS(M(1,0), M(0,2), M(0,0), M(1,2)), inv_det);
+    r.m[2][0] = lanes_mul(CROSS(M(1,0), M(2,1), M(2,0), M(1,1)), inv_det);
+    r.m[2][1] = lanes_mul(CROSS(M(2,0), M(0,1), M(0,0), M(2,1)), inv_det);
+    r.m[2][2] = lanes_mul(CROSS(M(0,0), M(1,1), M(1,0), M(0,1)), inv_det);
+    #undef CROSS
+    #undef M
+
+    Lanes one = lanes_set1(1.0f), zero = lanes_set1(0.0f);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) r.m[i][j] = lanes_select(valid, r.m[i][j], i == j ? one : zero);
+    }
+    return r;
+}
+
+// R M Rᵀ, e.g. I⁻¹_world = R I⁻¹_body Rᵀ
+static inline Mat3Lanes mat3_lanes_similarity(const Mat3Lanes* r, const Mat3Lanes* m) {
+    Mat3Lanes t, out;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            t.m[i][j] = lanes_add(lanes_add(lanes_mul(r->m[i][0], m->m[0][j]), lanes_mul(r->m[i][1], m->m[1][j])),
+                                  lanes_mul(r->m[i][2], m->m[2][j]));
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            out.m[i][j] = lanes_add(lanes_add(lanes_mul(t.m[i][0], r->m[j][0]), lanes_mul(t.m[i][1], r->m[j][1])),
+                                    lanes_mul(t.m[i][2], r->m[j][2]));
+        }
+    }
+    return out;
+}
+
+// R diag(d⃗) Rᵀ; six products instead of the 54 of a full similarity
+static inline Mat3Lanes mat3_lanes_rotate_diagonal(const Mat3Lanes* r, Vec3Lanes d) {
+    Mat3Lanes out;
+    for (int i = 0; i < 3; i++) {
+        Lanes rx = lanes_mul(r->m[i][0], d.x), ry = lanes_mul(r->m[i][1], d.y), rz = lanes_mul(r->m[i][2], d.z);
+        for (int j = i; j < 3; j++) {
+            out.m[i][j] = lanes_add(lanes_add(lanes_mul(rx, r->m[j][0]), lanes_mul(ry, r->m[j][1])),
+                                    lanes_mul(rz, r->m[j][2]));
+            out.m[j][i] = out.m[i][j];
+        }
+    }
+    return out;
+}
+
+#endif // SIMD_H
@@ -0,0 +1,43 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "collision.h"
+
+// Spatial Hash
+// Uniform grid of cubic cells, hashed into a fixed table and rebuilt each
+// frame by counting sort. Each body is binned by the cell of its center, so
+// the cell size must be at least the largest diameter; overlapping pairs
+// then always lie in the same or adjacent cells.
+//
+// All arrays grow to the largest body count seen and are reused, so
+// rebuilding allocates nothing in steady state.
+typedef struct SpatialHash {
+    float cell_size;
+    float inv_cell_size;
+    int table_size;         // Power of two
+
+    int* bucket_start;      // [table_size + 1] prefix sums of bucket counts
+    int* sorted_body;       // [count] body indices grouped by bucket
+    int* sorted_cell;       // [count * 3] integer cell coordinates, same order
+    float* sorted_sphere;   // [count * 4] center and radius, same order
+    int* body_bucket;       // [count] bucket of each body
+    int body_count;
+    int body_capacity;
+    int table_capacity;
+} SpatialHash;
+
+void spatial_hash_init(SpatialHash* grid);
+void spatial_hash_free(SpatialHash* grid);
+
+// cell_size <= 0 (or smaller than the largest diameter) selects 2 ⋅ r_max.
+// False if the arrays could not grow; the grid is then left empty.
+bool spatial_hash_build(SpatialHash* grid, const Vec3* position, const float* radius, int count, float cell_size);
+
+// Appends each AABB-overlapping pair exactly once
+void spatial_hash_find_pairs(const SpatialHash* grid, PairList* out);
+
+// Bodies binned in the 8 cells nearest p whose center is within 2r of p
+// on every axis; writes at most max, returns the number written
+int spatial_hash_query_point(const SpatialHash* grid, Vec3 p, int* results, int max);
+
+#endif // SPATIAL_HASH_H
@@ -0,0 +1,57 @@
+#ifndef STEPPER_H
+#define STEPPER_H
+
+#include "scene.h"
+
+#define STEPPER_DEFAULT_HZ 60.0f
+#define STEPPER_DEFAULT_MAX_STEPS 5   // Per frame; the rest of a long frame is dropped
+
+// Fixed-rate stepping
+// Wall-clock frame time is accumulated and consumed in steps of 1/step_hz
+// seconds, each split into `substeps` equal scene_update calls, so the
+// simulation sees the same dt whatever the display rate. At most
+// max_steps_per_frame steps run per frame; time beyond that is dropped
+// rather than carried over, so one slow frame cannot snowball.
+//
+// The leftover time is exposed as alpha ∈ [0, 1) and the body transforms
+// from before the last step are kept, so the renderer can draw
+// x⃗ = lerp(x⃗_prev, x⃗, α) and q = nlerp(q_prev, q, α) between physics states.
+typedef struct {
+    float step_hz;              // Physics steps per second
+    int substeps;               // scene_update calls per step
+    int max_steps_per_frame;
+    
+    float accumulator;          // Unsimulated time (s)
+    float alpha;                // accumulator ⋅ step_hz after the last advance
+    
+    // Transforms before the last step, by handle slot so removals do not
+    // shift them onto another body
+    Vec3* prev_position;
+    Quat* prev_orientation;
+    uint32_t* prev_generation;  // Handle generation the entry belongs to
+    int prev_capacity;
+    
+    // Counters since init
+    uint64_t steps;
+    uint64_t dropped_steps;
+} SceneStepper;
+
+void stepper_init(SceneStepper* stepper, float step_hz, int substeps, int max_steps_per_frame);
+void stepper_free(SceneStepper* stepper);
+
+// Adds frame_dt of wall-clock time and runs the steps it pays for. Returns
+// the number of steps taken.
+int stepper_advance(SceneStepper* stepper, Scene* scene, float frame_dt);
+
+// Runs one step now, ignoring the accumulator (free-running drivers)
+void stepper_step(SceneStepper* stepper, Scene* scene);
+
+// Transform of the body at index before the last step; bodies added since
+// report their current state
+void stepper_body_previous(const SceneStepper* stepper, const Scene* scene, int index, Vec3* position, Quat* orientation);
+
+// Interpolated transform of the body at index. Bodies added since the last
+// step report their current state.
+void stepper_body_transform(const SceneStepper* stepper, const Scene* scene, int index, Vec3* position, Quat* orientation);
+
+#endif // STEPPER_H
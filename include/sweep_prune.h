@@ -0,0 +1,67 @@
+#ifndef SWEEP_PRUNE_H
+#define SWEEP_PRUNE_H
+
+#include "collision.h"
+#include <stdint.h>
+
+// Endpoint of a body's AABB projected on one axis
+typedef struct {
+    float value;
+    int body;           // Body index
+    int is_max;         // 0 = min endpoint, 1 = max endpoint
+} SapEndpoint;
+
+// Called when a pair starts (added = true) or stops overlapping
+typedef void (*SapPairCallback)(void* user, int a, int b, bool added);
+
+// Sweep and Prune
+// Keeps the endpoints of every AABB sorted on all three axes across frames.
+// Each frame the arrays are re-sorted with insertion sort, which is close to
+// O(N) when bodies move little, and every swap of a min past a max endpoint
+// updates the persistent overlap set. The set is dense, so its contents can
+// be iterated directly and stay stable while bodies keep touching.
+typedef struct SweepPrune {
+    SapEndpoint* endpoints[3];  // [2 * body_count] per axis, sorted
+    AABB* boxes;                // Current box per body
+    int body_count;
+    int body_capacity;
+    int* active;                // Sweep list of the initial build (scratch)
+
+    // Overlapping pairs: dense list plus open-addressing index
+    BodyPair* pairs;
+    int pair_count;
+    int pair_capacity;
+    int* pair_slots;            // Index into pairs, -1 = empty
+    int slot_count;             // Power of two
+    bool lost_pair;             // Out of memory for a pair: rebuilt by the next update
+
+    // Removals since the last update, applied in one pass by the next one
+    int* remap;                 // Tracked body → current index, -1 = removed
+    int* owner;                 // Current index → tracked body, -1 = none
+    int pending_removals;
+
+    SapPairCallback on_pair;    // Optional add/remove notifications
+    void* user;
+
+    int swaps;                  // Endpoint swaps during the last update
+} SweepPrune;
+
+void sweep_prune_init(SweepPrune* sap);
+void sweep_prune_free(SweepPrune* sap);
+void sweep_prune_set_callback(SweepPrune* sap, SapPairCallback callback, void* user);
+
+// Re-sorts endpoints against the current body spheres and updates the pair set.
+// A smaller count than last time without matching removals rebuilds from scratch.
+// False if the arrays could not grow; everything is dropped and rebuilt next time.
+bool sweep_prune_update(SweepPrune* sap, const Vec3* position, const float* radius, int count);
+
+// Records a swap-remove in the body array (index dies, last moves to index).
+// Pairs of the removed body are dropped and the rest renamed on the next update.
+void sweep_prune_remove(SweepPrune* sap, int index, int last);
+
+// Drops all bodies (emitting removals for every live pair)
+void sweep_prune_clear(SweepPrune* sap);
+
+bool sweep_prune_has_pair(const SweepPrune* sap, int a, int b);
+
+#endif // SWEEP_PRUNE_H
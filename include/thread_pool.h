@@ -0,0 +1,32 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#define THREAD_POOL_MAX_THREADS 64
+
+// Processes items [begin, end) of a parallel loop
+typedef void (*ThreadPoolRangeFn)(void* user, int begin, int end);
+
+// Thread Pool
+// A fixed set of worker threads, each owning a deque of index ranges.
+// thread_pool_parallel_for cuts a loop into grain-sized ranges and deals
+// them out in contiguous blocks; a worker pops from the bottom of its own
+// deque and, once empty, steals from the top of the others. The calling
+// thread takes part as worker 0.
+//
+// Ranges are disjoint and each item is processed exactly once, so loops
+// whose items are independent give identical results for any thread count.
+typedef struct ThreadPool ThreadPool;
+
+// threads counts the caller; 0 = one per online CPU
+ThreadPool* thread_pool_create(int threads);
+void thread_pool_destroy(ThreadPool* pool);
+int thread_pool_size(const ThreadPool* pool);
+int thread_pool_cpu_count();
+
+// Blocks until fn has run over all of [begin, end). A NULL pool runs inline.
+void thread_pool_parallel_for(ThreadPool* pool, int begin, int end, int grain, ThreadPoolRangeFn fn, void* user);
+
+// Ranges taken from another worker's deque since creation
+int thread_pool_steal_count(const ThreadPool* pool);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,10 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+// Monotonic wall clock in nanoseconds (arbitrary epoch).
+// Used for step timing; independent of GLUT so it works headless.
+uint64_t timer_now_ns();
+
+#endif // TIMER_H
@@ -0,0 +1,50 @@
+#ifndef TRAIL_STORE_H
+#define TRAIL_STORE_H
+
+#include "body_store.h"
+
+#define TRAIL_LENGTH 50             // Points per trail
+#define TRAIL_SAMPLE_INTERVAL 3     // Default steps between samples
+
+// Motion Trails
+// Opt-in per body (RigidBody.trail, BODY_FLAG_TRAIL). Each trail is a ring
+// of TRAIL_LENGTH positions, and all rings share one pool: trail t owns
+// points[t·TRAIL_LENGTH, (t + 1)·TRAIL_LENGTH). Trails refer to their body
+// by handle, so bodies moving in the BodyStore do not reorder them;
+// removing a trail moves the last one into its place. trail_of_slot maps a
+// handle slot back to its trail, so removal needs no search.
+//
+// The scene samples once every `interval` steps, after integration, writing
+// one point per trail. Nothing is allocated before the first trail, and a
+// store without trails costs one comparison per step.
+typedef struct {
+    BodyHandle* body;
+    int* head;                  // Next point written, i.e. the oldest
+    Vec3* points;               // TRAIL_LENGTH per trail
+
+    int count;
+    int capacity;
+
+    int* trail_of_slot;         // Handle slot → trail index, -1 = none
+    int slot_capacity;
+
+    int interval;               // Steps between samples, ≥ 1
+    int countdown;              // Steps until the next sample
+} TrailStore;
+
+void trail_store_init(TrailStore* store);
+void trail_store_free(TrailStore* store);
+void trail_store_clear(TrailStore* store);
+
+// Starts a trail collapsed at position. Returns its index, -1 if out of memory.
+int trail_store_add(TrailStore* store, BodyHandle body, Vec3 position);
+// Swap-remove; false if the body has no trail
+bool trail_store_remove(TrailStore* store, BodyHandle body);
+
+// Appends each dynamic body's position every interval-th call
+void trail_store_sample(TrailStore* store, const BodyStore* bodies);
+
+// Trail t unrolled into out[TRAIL_LENGTH], oldest first
+void trail_store_read(const TrailStore* store, int trail, Vec3* out);
+
+#endif // TRAIL_STORE_H
@@ -55,6 +55,7 @@ Quat quat_mul(Quat a, Quat b);      // q₁ ⊗ q₂
 Quat quat_conjugate(Quat q);        // q*
 Vec3 quat_rotate_vec(Quat q, Vec3 v); // v' = q v q*
 Quat quat_normalize(Quat q);
+Quat quat_nlerp(Quat a, Quat b, float t); // normalize(lerp), shortest arc
 Mat3 quat_to_mat3(Quat q);          // R(q)
 
 // --- Matrix Operations ---
@@ -63,6 +64,7 @@ Mat3 mat3_zero();
 Mat3 mat3_mul(Mat3 a, Mat3 b);      // C = AB
 Vec3 mat3_mul_vec(Mat3 m, Vec3 v);  // u⃗ = M v⃗
 Mat3 mat3_transpose(Mat3 m);        // Mᵀ
+Mat3 mat3_rotate_diagonal(Mat3 r, Vec3 d); // R diag(d) Rᵀ
 Mat3 mat3_inverse(Mat3 m);          // M⁻¹
 float mat3_det(Mat3 m);             // det(M)
 
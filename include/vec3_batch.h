@@ -0,0 +1,40 @@
+#ifndef VEC3_BATCH_H
+#define VEC3_BATCH_H
+
+#include "vec3.h"
+#include <stdint.h>
+
+// Batched Math
+// Array kernels built on the lanes in simd.h. Each processes SIMD_WIDTH
+// elements at a time and finishes the remainder with the scalar functions
+// of vec3.h, which remain the reference implementation.
+
+const char* simd_backend_name();
+int simd_width();
+
+// q̂ for n quaternions, in place
+void quat_batch_normalize(Quat* q, int n);
+
+// q ← normalize(q + ½ dt (ω ⊗ q))
+void quat_batch_integrate(Quat* q, const Vec3* w, float dt, int n);
+
+// out = M⁻¹ (identity where |det M| < 1e-6). No step inverts a matrix (the
+// body-space inverse inertia is cached), and this is no faster than the
+// scalar loop; bench --simd keeps it honest.
+void mat3_batch_inverse(Mat3* out, const Mat3* m, int n);
+
+// out = R(q) I⁻¹_body R(q)ᵀ
+void mat3_batch_rotate_inertia(Mat3* out, const Quat* q, const Mat3* inv_body, int n);
+
+// hit[k] = ‖x⃗_b - x⃗_a‖² < (r_a + r_b)² for the k-th index pair (a, b);
+// pairs holds 2n indices. Returns the number of hits. The per-lane gathers
+// make it slower than the scalar test on random pairs, so the narrow phase
+// does not use it.
+int sphere_batch_overlap(const Vec3* position, const float* radius, const int* pairs, int n, uint8_t* hit);
+
+// hit[i] = n̂ ⋅ x⃗_i - r_i < offset for n spheres: sphere i crosses the plane
+// into the half-space behind it. Returns the number of hits. A scalar loop:
+// it is cheaper than transposing the positions into lanes.
+int sphere_batch_plane(const Vec3* position, const float* radius, int n, Vec3 normal, float offset, uint8_t* hit);
+
+#endif // VEC3_BATCH_H
@@ -0,0 +1,893 @@
+#define _GNU_SOURCE // syscall()
+#include "bench.h"
+#include "sim_thread.h"
+#include "timer.h"
+#include "vec3_batch.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// STANDARD WORKLOADS
+// ============================================================================
+
+static const BenchSceneParams g_standard_scenes[] = {
+    // Few contacts: bodies rain down over a large floor
+    {
+        .name = "sparse_rain",
+        .body_count = 1000,
+        .radius_min = 0.5f, .radius_max = 1.5f,
+        .density = 2.4f,
+        .gravity = {0, -9.81f, 0},
+        .world_size = 200.0f,
+        .spawn_min = {-95.0f, -50.0f, -95.0f},
+        .spawn_max = { 95.0f,  95.0f,  95.0f},
+        .initial_speed = 2.0f,
+        .seed = 1,
+    },
+    // Many persistent contacts: a tall column collapsing onto the floor
+    {
+        .name = "dense_pile",
+        .body_count = 2000,
+        .radius_min = 0.4f, .radius_max = 0.6f,
+        .density = 2.4f,
+        .gravity = {0, -9.81f, 0},
+        .world_size = 30.0f,
+        .spawn_min = {-5.0f, -14.0f, -5.0f},
+        .spawn_max = { 5.0f,  40.0f,  5.0f},
+        .initial_speed = 0.0f,
+        .seed = 2,
+    },
+    // Moderate body count with a steady stream of particle bursts
+    {
+        .name = "explosion_heavy",
+        .body_count = 250,
+        .radius_min = 0.5f, .radius_max = 1.5f,
+        .density = 2.4f,
+        .gravity = {0, -9.81f, 0},
+        .world_size = 30.0f,
+        .spawn_min = {-10.0f, -10.0f, -10.0f},
+        .spawn_max = { 10.0f,  15.0f,  10.0f},
+        .initial_speed = 1.0f,
+        .explosion_interval = 5,
+        .explosion_particles = 200,
+        .explosion_origin = {0, 5, 0},
+        .seed = 3,
+    },
+    // Few bodies under a continuous high-rate particle fountain
+    {
+        .name = "particle_fountain",
+        .body_count = 200,
+        .radius_min = 0.5f, .radius_max = 1.5f,
+        .density = 2.4f,
+        .gravity = {0, -9.81f, 0},
+        .world_size = 30.0f,
+        .spawn_min = {-10.0f, -10.0f, -10.0f},
+        .spawn_max = { 10.0f,  15.0f,  10.0f},
+        .initial_speed = 1.0f,
+        .explosion_origin = {0, 0, 0},
+        .emitter_rate = 50000.0f,
+        .seed = 5,
+    },
+    // Mostly boxes settling into a heap: SAT pairs and the axis cache
+    {
+        .name = "crate_pile",
+        .body_count = 1000,
+        .radius_min = 0.4f, .radius_max = 0.8f,
+        .density = 2.4f,
+        .box_fraction = 0.75f,
+        .gravity = {0, -9.81f, 0},
+        .world_size = 30.0f,
+        .spawn_min = {-8.0f, -10.0f, -8.0f},
+        .spawn_max = { 8.0f,  30.0f,  8.0f},
+        .initial_speed = 0.0f,
+        .seed = 4,
+    },
+};
+
+int bench_standard_scene_count() {
+    return (int)(sizeof(g_standard_scenes) / sizeof(g_standard_scenes[0]));
+}
+
+const BenchSceneParams* bench_standard_scene(int index) {
+    if (index < 0 || index >= bench_standard_scene_count()) return NULL;
+    return &g_standard_scenes[index];
+}
+
+const BenchSceneParams* bench_find_scene(const char* name) {
+    for (int i = 0; i < bench_standard_scene_count(); i++) {
+        if (strcmp(g_standard_scenes[i].name, name) == 0) return &g_standard_scenes[i];
+    }
+    return NULL;
+}
+
+// ============================================================================
+// WORKLOAD CONSTRUCTION
+// ============================================================================
+
+// xorshift32: deterministic across platforms, unlike rand()
+static float bench_random(unsigned int* state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (float)(x >> 8) / 16777216.0f; // [0, 1)
+}
+
+static float bench_random_range(unsigned int* state, float lo, float hi) {
+    return lo + (hi - lo) * bench_random(state);
+}
+
+static void bench_add_bodies(Scene* scene, const BenchSceneParams* params) {
+    unsigned int rng = params->seed ? params->seed : 1u;
+    for (int i = 0; i < params->body_count; i++) {
+        RigidBody b;
+        float r = bench_random_range(&rng, params->radius_min, params->radius_max);
+        Vec3 pos = {
+            bench_random_range(&rng, params->spawn_min.x, params->spawn_max.x),
+            bench_random_range(&rng, params->spawn_min.y, params->spawn_max.y),
+            bench_random_range(&rng, params->spawn_min.z, params->spawn_max.z)
+        };
+        // Draws nothing extra for sphere-only scenes, so they stay reproducible
+        if (params->box_fraction > 0.0f && bench_random(&rng) < params->box_fraction) {
+            Vec3 h = {
+                bench_random_range(&rng, 0.5f * r, r),
+                bench_random_range(&rng, 0.5f * r, r),
+                bench_random_range(&rng, 0.5f * r, r)
+            };
+            physics_init_box(&b, pos, params->density * 8.0f * h.x * h.y * h.z, h, i);
+            Vec3 axis = vec3_normalize((Vec3){ bench_random_range(&rng, -1.0f, 1.0f), 1.0f,
+                                               bench_random_range(&rng, -1.0f, 1.0f) });
+            b.orientation = quat_from_axis_angle(axis, bench_random_range(&rng, 0.0f, PI));
+            physics_update_inertia(&b);
+        } else {
+            float mass = params->density * (4.0f / 3.0f) * PI * r * r * r;
+            physics_init_body(&b, pos, mass, r, i);
+        }
+
+        Vec3 dir = {
+            bench_random_range(&rng, -1.0f, 1.0f),
+            bench_random_range(&rng, -1.0f, 1.0f),
+            bench_random_range(&rng, -1.0f, 1.0f)
+        };
+        b.velocity = vec3_scale(vec3_normalize(dir), params->initial_speed * bench_random(&rng));
+        b.color = (Vec3){ bench_random(&rng), bench_random(&rng), bench_random(&rng) };
+        b.trail = params->trails;
+        scene_add_body(scene, b);
+    }
+}
+
+void bench_build_scene(Scene* scene, const BenchSceneParams* params) {
+    scene_init(scene);
+    scene->gravity = params->gravity;
+    scene->gravity_enabled = true;
+    scene->world_size = params->world_size;
+    bench_add_bodies(scene, params);
+}
+
+void bench_reset_scene(Scene* scene, const BenchSceneParams* params) {
+    scene_reset(scene);
+    bench_add_bodies(scene, params);
+}
+
+// ============================================================================
+// EXECUTION
+// ============================================================================
+
+void bench_run(Scene* scene, const BenchSceneParams* params, int steps, float dt, BenchResult* result) {
+    memset(result, 0, sizeof(BenchResult));
+    scene_reset_stats(scene);
+    scene->particle_rng = params->seed ? params->seed : 1u;
+    if (params->emitter_rate > 0.0f) {
+        scene_add_emitter(scene, (Emitter){
+            .position = params->explosion_origin,
+            .rate = params->emitter_rate,
+            .spawn = particle_spawn_explosion(),
+            .active = true,
+            .rng = params->seed + 1u,
+        });
+    }
+
+    double pairs = 0.0, contacts = 0.0, islands = 0.0, sleeping = 0.0, warm = 0.0;
+    double swept = 0.0, clamped = 0.0, box_pairs = 0.0, axis_rejects = 0.0, particles = 0.0;
+    double particle_tests = 0.0, particle_hits = 0.0;
+    result->last_allocating_step = -1;
+    uint64_t start = timer_now_ns();
+    for (int s = 0; s < steps; s++) {
+        if (params->explosion_interval > 0 && s % params->explosion_interval == 0) {
+            scene_spawn_explosion(scene, params->explosion_origin, params->explosion_particles);
+        }
+        scene_update(scene, dt);
+        pairs += scene->collision.pairs.count;
+        contacts += scene->collision.contact_count;
+        islands += scene->collision.island_count;
+        sleeping += scene->sleeping_count;
+        for (int st = 0; st < COLLISION_STAGE_COUNT; st++) result->stage_ns[st] += scene->collision.stage_ns[st];
+        warm += scene->collision.warm_started;
+        swept += scene->collision.swept_count;
+        clamped += scene->collision.ccd_clamped;
+        box_pairs += scene->collision.box_pairs;
+        particles += scene->particles.count;
+        particle_tests += scene->collision.particle_tests;
+        particle_hits += scene->collision.particle_hits;
+        axis_rejects += scene->collision.axis_rejects;
+        if (scene->stats.last_allocations > 0) result->last_allocating_step = s;
+        if (scene->collision.largest_island > result->largest_island) {
+            result->largest_island = scene->collision.largest_island;
+        }
+    }
+    uint64_t elapsed = timer_now_ns() - start;
+
+    result->body_count = scene->bodies.count;
+    result->steps = steps;
+    result->dt = dt;
+    result->total_ns = (double)elapsed;
+    result->steps_per_sec = elapsed > 0 ? steps * 1e9 / (double)elapsed : 0.0;
+    if (steps > 0) {
+        result->pairs_per_step = pairs / steps;
+        result->contacts_per_step = contacts / steps;
+        result->islands_per_step = islands / steps;
+        result->sleeping_per_step = sleeping / steps;
+        result->warm_started_per_step = warm / steps;
+        result->swept_per_step = swept / steps;
+        result->clamped_per_step = clamped / steps;
+        result->box_pairs_per_step = box_pairs / steps;
+        result->axis_rejects_per_step = axis_rejects / steps;
+        result->particles_per_step = particles / steps;
+        result->particle_tests_per_step = particle_tests / steps;
+        result->particle_hits_per_step = particle_hits / steps;
+    }
+    if (steps > 0 && scene->bodies.count > 0) {
+        result->ns_per_body_step = (double)elapsed / ((double)steps * scene->bodies.count);
+    }
+    for (int p = 0; p < SCENE_PHASE_COUNT; p++) {
+        result->phase_ns[p] = (double)scene->stats.phase_ns[p];
+    }
+    result->allocations = scene->stats.allocations;
+}
+
+static uint64_t bench_hash_bytes(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+uint64_t bench_state_hash(const Scene* scene) {
+    const BodyStore* b = &scene->bodies;
+    size_t n = (size_t)b->count;
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = bench_hash_bytes(h, b->position, n * sizeof(Vec3));
+    h = bench_hash_bytes(h, b->velocity, n * sizeof(Vec3));
+    h = bench_hash_bytes(h, b->orientation, n * sizeof(Quat));
+    h = bench_hash_bytes(h, b->angular_velocity, n * sizeof(Vec3));
+    const ParticleStore* p = &scene->particles;
+    h = bench_hash_bytes(h, p->position, (size_t)p->count * sizeof(Vec3));
+    h = bench_hash_bytes(h, p->velocity, (size_t)p->count * sizeof(Vec3));
+    return h;
+}
+
+/*
+ * bench_broadphase
+ * Spheres with r ∈ [0.5, 1.5] at constant density (≈ 40 units³ per body)
+ * drifting inside a box; only collision_system_find_pairs is timed.
+ */
+void bench_broadphase(BroadphaseType type, int body_count, int frames, BenchBroadphaseResult* result) {
+    memset(result, 0, sizeof(BenchBroadphaseResult));
+    BodyStore bodies;
+    body_store_init(&bodies, body_count);
+
+    float world = cbrtf(body_count * 40.0f);
+    float h = world / 2.0f;
+    unsigned int rng = 7;
+    for (int i = 0; i < body_count; i++) {
+        RigidBody b;
+        float r = bench_random_range(&rng, 0.5f, 1.5f);
+        Vec3 pos = { bench_random_range(&rng, -h, h), bench_random_range(&rng, -h, h), bench_random_range(&rng, -h, h) };
+        physics_init_body(&b, pos, 1.0f, r, i);
+        b.velocity = (Vec3){ bench_random_range(&rng, -2, 2), bench_random_range(&rng, -2, 2), bench_random_range(&rng, -2, 2) };
+        body_store_add(&bodies, &b);
+    }
+
+    CollisionSystem sys;
+    collision_system_init(&sys, world);
+    sys.broadphase = type;
+
+    const float dt = 1.0f / 60.0f;
+    uint64_t total = 0;
+    double pairs = 0.0;
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < body_count; i++) {
+            Vec3* p = &bodies.position[i];
+            Vec3* v = &bodies.velocity[i];
+            *p = vec3_add(*p, vec3_scale(*v, dt));
+            if (fabsf(p->x) > h) v->x = -v->x;
+            if (fabsf(p->y) > h) v->y = -v->y;
+            if (fabsf(p->z) > h) v->z = -v->z;
+        }
+        uint64_t t0 = timer_now_ns();
+        collision_system_find_pairs(&sys, &bodies);
+        total += timer_now_ns() - t0;
+        pairs += sys.pairs.count;
+    }
+
+    result->body_count = body_count;
+    result->frames = frames;
+    if (frames > 0) {
+        result->ns_per_frame = (double)total / frames;
+        result->pairs_per_frame = pairs / frames;
+    }
+
+    collision_system_cleanup(&sys);
+    body_store_free(&bodies);
+}
+
+// ============================================================================
+// MEMORY LAYOUT
+// ============================================================================
+
+// Hardware cache-miss counter for this thread; -1 where unavailable
+static int bench_cache_counter_open() {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void bench_cache_counter_start(int fd) {
+#ifdef __linux__
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#else
+    (void)fd;
+#endif
+}
+
+static double bench_cache_counter_stop(int fd) {
+#ifdef __linux__
+    if (fd < 0) return -1.0;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t misses = 0;
+    if (read(fd, &misses, sizeof(misses)) != sizeof(misses)) return -1.0;
+    return (double)misses;
+#else
+    (void)fd;
+    return -1.0;
+#endif
+}
+
+/*
+ * bench_layout
+ * Integrates the same bodies stored as RigidBody records (physics_integrate)
+ * and in a BodyStore (physics_integrate_store). The body count should exceed
+ * the last-level cache so both variants stream from memory.
+ */
+void bench_layout(int body_count, int steps, BenchLayoutResult* result) {
+    memset(result, 0, sizeof(BenchLayoutResult));
+    result->body_count = body_count;
+    result->steps = steps;
+    result->aos_bytes_per_body = (int)sizeof(RigidBody);
+
+    RigidBody* records = malloc((size_t)body_count * sizeof(RigidBody));
+    BodyStore store;
+    body_store_init(&store, body_count);
+    if (!records) return;
+
+    unsigned int rng = 11;
+    for (int i = 0; i < body_count; i++) {
+        Vec3 pos = { bench_random_range(&rng, -50, 50), bench_random_range(&rng, -50, 50), bench_random_range(&rng, -50, 50) };
+        physics_init_body(&records[i], pos, 1.0f, 0.5f, i);
+        records[i].angular_velocity = (Vec3){ bench_random(&rng), bench_random(&rng), bench_random(&rng) };
+        body_store_add(&store, &records[i]);
+    }
+
+    const float dt = 1.0f / 60.0f;
+    const Vec3 gravity = {0, -9.81f, 0};
+    int counter = bench_cache_counter_open();
+    uint64_t steps_ns[2] = {0, 0};
+    double misses[2] = {0, 0};
+
+    // Record layout
+    bench_cache_counter_start(counter);
+    uint64_t t0 = timer_now_ns();
+    for (int s = 0; s < steps; s++) {
+        for (int i = 0; i < body_count; i++) {
+            physics_add_force(&records[i], vec3_scale(gravity, records[i].mass));
+            physics_integrate(&records[i], dt);
+        }
+    }
+    steps_ns[0] = timer_now_ns() - t0;
+    misses[0] = bench_cache_counter_stop(counter);
+
+    // Structure of arrays
+    bench_cache_counter_start(counter);
+    t0 = timer_now_ns();
+    for (int s = 0; s < steps; s++) {
+        for (int i = 0; i < body_count; i++) {
+            store.force_accumulator[i] = vec3_add(store.force_accumulator[i], vec3_scale(gravity, store.mass[i]));
+        }
+        physics_integrate_store(&store, 0, body_count, dt);
+    }
+    steps_ns[1] = timer_now_ns() - t0;
+    misses[1] = bench_cache_counter_stop(counter);
+
+    double body_steps = (double)body_count * steps;
+    if (body_steps > 0) {
+        result->aos_ns_per_body = steps_ns[0] / body_steps;
+        result->soa_ns_per_body = steps_ns[1] / body_steps;
+        result->aos_misses_per_body = misses[0] < 0 ? -1.0 : misses[0] / body_steps;
+        result->soa_misses_per_body = misses[1] < 0 ? -1.0 : misses[1] / body_steps;
+    }
+
+#ifdef __linux__
+    if (counter >= 0) close(counter);
+#endif
+    body_store_free(&store);
+    free(records);
+}
+
+// ============================================================================
+// BATCHED MATH
+// ============================================================================
+
+static double bench_rel_error(float batch, float scalar) {
+    double d = fabs((double)batch - (double)scalar);
+    double s = fabs((double)scalar);
+    return d / (s > 1.0 ? s : 1.0);
+}
+
+static double bench_max_error(const float* batch, const float* scalar, int floats) {
+    double worst = 0.0;
+    for (int i = 0; i < floats; i++) {
+        double e = bench_rel_error(batch[i], scalar[i]);
+        if (e > worst) worst = e;
+    }
+    return worst;
+}
+
+// Random symmetric, diagonally dominant matrix (inertia-like, well conditioned)
+static Mat3 bench_random_inertia(unsigned int* rng) {
+    Mat3 m;
+    for (int r = 0; r < 3; r++) {
+        for (int c = r; c < 3; c++) {
+            float v = r == c ? bench_random_range(rng, 1.0f, 4.0f) : bench_random_range(rng, -0.3f, 0.3f);
+            m.m[r][c] = m.m[c][r] = v;
+        }
+    }
+    return m;
+}
+
+/*
+ * bench_simd
+ * Runs every batched kernel and the scalar loop it replaces over the same
+ * random inputs, reporting the largest disagreement and the time per
+ * element. The last kernel is a whole integration step: physics_integrate
+ * on RigidBody records against physics_integrate_store, whose full blocks
+ * go through the lanes once the store has grouped the alternating shapes.
+ */
+void bench_simd(int count, BenchSimdResult* result) {
+    enum { REPEAT = 20 };
+    memset(result, 0, sizeof(BenchSimdResult));
+    result->count = count;
+    result->backend = simd_backend_name();
+    result->width = simd_width();
+    if (count <= 0) return;
+
+    Quat* q_in = malloc(count * sizeof(Quat));
+    Quat* q_ref = malloc(count * sizeof(Quat));
+    Quat* q_out = malloc(count * sizeof(Quat));
+    Vec3* w = malloc(count * sizeof(Vec3));
+    Vec3* pos = malloc(count * sizeof(Vec3));
+    float* radius = malloc(count * sizeof(float));
+    int* pairs = malloc(2 * count * sizeof(int));
+    uint8_t* hit_ref = malloc(count);
+    uint8_t* hit_out = malloc(count);
+    Mat3* m_in = malloc(count * sizeof(Mat3));
+    Mat3* m_ref = malloc(count * sizeof(Mat3));
+    Mat3* m_out = malloc(count * sizeof(Mat3));
+    RigidBody* records = malloc(count * sizeof(RigidBody));
+    BodyStore store;
+    body_store_init(&store, count);
+
+    unsigned int rng = 23;
+    for (int i = 0; i < count; i++) {
+        q_in[i] = (Quat){ bench_random_range(&rng, -2, 2), bench_random_range(&rng, -2, 2),
+                          bench_random_range(&rng, -2, 2), bench_random_range(&rng, -2, 2) };
+        w[i] = (Vec3){ bench_random_range(&rng, -5, 5), bench_random_range(&rng, -5, 5), bench_random_range(&rng, -5, 5) };
+        pos[i] = (Vec3){ bench_random_range(&rng, -10, 10), bench_random_range(&rng, -10, 10), bench_random_range(&rng, -10, 10) };
+        radius[i] = bench_random_range(&rng, 0.5f, 2.0f);
+        pairs[2 * i] = (int)(bench_random(&rng) * count);
+        pairs[2 * i + 1] = (int)(bench_random(&rng) * count);
+        m_in[i] = bench_random_inertia(&rng);
+    }
+    const float dt = 1.0f / 60.0f;
+    BenchSimdKernel* k = result->kernels;
+    uint64_t t0;
+
+    // --- Quaternion normalization ---
+    k[0].name = "quat_normalize";
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < count; i++) q_ref[i] = quat_normalize(q_in[i]);
+    }
+    k[0].scalar_ns = (double)(timer_now_ns() - t0);
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        memcpy(q_out, q_in, count * sizeof(Quat));
+        quat_batch_normalize(q_out, count);
+    }
+    k[0].batch_ns = (double)(timer_now_ns() - t0);
+    k[0].max_error = bench_max_error((const float*)q_out, (const float*)q_ref, 4 * count);
+
+    // --- Orientation integration (inputs are unit quaternions from here on) ---
+    memcpy(q_in, q_ref, count * sizeof(Quat));
+    k[1].name = "quat_integrate";
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < count; i++) {
+            Quat spin = quat_mul((Quat){0, w[i].x, w[i].y, w[i].z}, q_in[i]);
+            Quat q = q_in[i];
+            q.w += spin.w * 0.5f * dt;
+            q.x += spin.x * 0.5f * dt;
+            q.y += spin.y * 0.5f * dt;
+            q.z += spin.z * 0.5f * dt;
+            q_ref[i] = quat_normalize(q);
+        }
+    }
+    k[1].scalar_ns = (double)(timer_now_ns() - t0);
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        memcpy(q_out, q_in, count * sizeof(Quat));
+        quat_batch_integrate(q_out, w, dt, count);
+    }
+    k[1].batch_ns = (double)(timer_now_ns() - t0);
+    k[1].max_error = bench_max_error((const float*)q_out, (const float*)q_ref, 4 * count);
+
+    // --- Matrix inverse ---
+    k[2].name = "mat3_inverse";
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < count; i++) m_ref[i] = mat3_inverse(m_in[i]);
+    }
+    k[2].scalar_ns = (double)(timer_now_ns() - t0);
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) mat3_batch_inverse(m_out, m_in, count);
+    k[2].batch_ns = (double)(timer_now_ns() - t0);
+    k[2].max_error = bench_max_error((const float*)m_out, (const float*)m_ref, 9 * count);
+
+    // --- World-space inverse inertia ---
+    k[3].name = "rotate_inertia";
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < count; i++) {
+            Mat3 R = quat_to_mat3(q_in[i]);
+            m_ref[i] = mat3_mul(mat3_mul(R, m_in[i]), mat3_transpose(R));
+        }
+    }
+    k[3].scalar_ns = (double)(timer_now_ns() - t0);
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) mat3_batch_rotate_inertia(m_out, q_in, m_in, count);
+    k[3].batch_ns = (double)(timer_now_ns() - t0);
+    k[3].max_error = bench_max_error((const float*)m_out, (const float*)m_ref, 9 * count);
+
+    // --- Sphere overlap (error = fraction of pairs that disagree) ---
+    k[4].name = "sphere_overlap";
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < count; i++) {
+            int a = pairs[2 * i], b = pairs[2 * i + 1];
+            float rr = radius[a] + radius[b];
+            hit_ref[i] = vec3_dist_sq(pos[a], pos[b]) < rr * rr;
+        }
+    }
+    k[4].scalar_ns = (double)(timer_now_ns() - t0);
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) sphere_batch_overlap(pos, radius, pairs, count, hit_out);
+    k[4].batch_ns = (double)(timer_now_ns() - t0);
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) mismatches += hit_out[i] != hit_ref[i];
+    k[4].max_error = (double)mismatches / count;
+
+    // --- Full integration step (spheres and boxes alternate until the store groups them) ---
+    k[5].name = "integrate";
+    for (int i = 0; i < count; i++) {
+        if (i % 2 == 0) {
+            physics_init_body(&records[i], pos[i], 1.0f + radius[i], radius[i], i);
+        } else {
+            Vec3 half = { radius[i], radius[(i + 1) % count], radius[(i + 2) % count] };
+            physics_init_box(&records[i], pos[i], 1.0f + radius[i], half, i);
+        }
+        records[i].orientation = q_in[i];
+        records[i].angular_velocity = w[i];
+        physics_update_inertia(&records[i]);
+        body_store_add(&store, &records[i]);
+    }
+    body_store_sort_by_shape(&store);
+    const Vec3 gravity = {0, -9.81f, 0};
+    const Vec3 torque = {0.1f, 0.0f, -0.2f};
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < count; i++) {
+            physics_add_force(&records[i], vec3_scale(gravity, records[i].mass));
+            physics_add_torque(&records[i], torque);
+            physics_integrate(&records[i], dt);
+        }
+    }
+    k[5].scalar_ns = (double)(timer_now_ns() - t0);
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < count; i++) {
+            store.force_accumulator[i] = vec3_add(store.force_accumulator[i], vec3_scale(gravity, store.mass[i]));
+            store.torque_accumulator[i] = vec3_add(store.torque_accumulator[i], torque);
+        }
+        physics_integrate_store(&store, 0, count, dt);
+    }
+    k[5].batch_ns = (double)(timer_now_ns() - t0);
+    for (int i = 0; i < count; i++) {
+        const RigidBody* ref = &records[store.id[i]];
+        const float* a[] = { &store.position[i].x, &store.velocity[i].x, &store.orientation[i].w,
+                             &store.angular_velocity[i].x, &store.inv_inertia_world[i].m[0][0] };
+        const float* b[] = { &ref->position.x, &ref->velocity.x, &ref->orientation.w,
+                             &ref->angular_velocity.x, &ref->inv_inertia_world.m[0][0] };
+        const int floats[] = { 3, 3, 4, 3, 9 };
+        for (int f = 0; f < 5; f++) {
+            double e = bench_max_error(a[f], b[f], floats[f]);
+            if (e > k[5].max_error) k[5].max_error = e;
+        }
+    }
+
+    // --- Sphere against a plane (error = fraction of spheres that disagree) ---
+    k[6].name = "sphere_plane";
+    const Vec3 plane_n = vec3_normalize((Vec3){ 0.3f, 1.0f, -0.2f });
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < count; i++) hit_ref[i] = vec3_dot(pos[i], plane_n) - radius[i] < 0.0f;
+    }
+    k[6].scalar_ns = (double)(timer_now_ns() - t0);
+    t0 = timer_now_ns();
+    for (int r = 0; r < REPEAT; r++) sphere_batch_plane(pos, radius, count, plane_n, 0.0f, hit_out);
+    k[6].batch_ns = (double)(timer_now_ns() - t0);
+    mismatches = 0;
+    for (int i = 0; i < count; i++) mismatches += hit_out[i] != hit_ref[i];
+    k[6].max_error = (double)mismatches / count;
+
+    double elements = (double)count * REPEAT;
+    for (int i = 0; i < BENCH_SIMD_KERNEL_COUNT; i++) {
+        k[i].scalar_ns /= elements;
+        k[i].batch_ns /= elements;
+    }
+
+    body_store_free(&store);
+    free(records);
+    free(m_out);
+    free(m_ref);
+    free(m_in);
+    free(hit_out);
+    free(hit_ref);
+    free(pairs);
+    free(radius);
+    free(pos);
+    free(w);
+    free(q_out);
+    free(q_ref);
+    free(q_in);
+}
+
+// ============================================================================
+// CONTINUOUS COLLISION
+// ============================================================================
+
+/*
+ * bench_tunneling
+ * Bullets (r = 0.2) fired at 60 m/s through a wall of overlapping static
+ * spheres (r = 0.5, one layer, no gaps a bullet fits through). After one
+ * simulated second every bullet should have bounced back; one found behind
+ * the wall went through it between two steps.
+ */
+void bench_tunneling(float dt, bool ccd, BenchTunnelingResult* result) {
+    memset(result, 0, sizeof(BenchTunnelingResult));
+    Scene* scene = malloc(sizeof(Scene));
+    if (!scene) return;
+    scene_init(scene);
+    scene->world_size = 200.0f;
+    scene->gravity_enabled = false;
+    scene->sleep.enabled = false;
+    scene->collision.ccd.enabled = ccd;
+
+    int id = 0;
+    for (int y = -6; y <= 6; y++) {
+        for (int z = -6; z <= 6; z++) {
+            RigidBody b;
+            physics_init_body(&b, (Vec3){ 0.0f, y * 0.8f, z * 0.8f }, 0.0f, 0.5f, id++);
+            scene_add_body(scene, b);
+        }
+    }
+    const int bullets = 100;
+    unsigned int rng = 11;
+    for (int i = 0; i < bullets; i++) {
+        RigidBody b;
+        Vec3 pos = { bench_random_range(&rng, -10.0f, -9.0f), bench_random_range(&rng, -4.0f, 4.0f), bench_random_range(&rng, -4.0f, 4.0f) };
+        physics_init_body(&b, pos, 0.1f, 0.2f, id++);
+        b.velocity = (Vec3){ 60.0f, 0.0f, 0.0f };
+        b.drag_linear = 0.0f;
+        scene_add_body(scene, b);
+    }
+
+    int steps = (int)ceilf(1.0f / dt);
+    uint64_t start = timer_now_ns();
+    for (int s = 0; s < steps; s++) scene_update(scene, dt);
+    uint64_t elapsed = timer_now_ns() - start;
+
+    result->dt = dt;
+    result->ccd = ccd;
+    result->bullets = bullets;
+    for (int i = 0; i < scene->bodies.count; i++) {
+        if (!(scene->bodies.flags[i] & BODY_FLAG_STATIC) && scene->bodies.position[i].x > 0.0f) result->tunneled++;
+    }
+    result->steps = steps;
+    result->ns_per_step = steps > 0 ? (double)elapsed / steps : 0.0;
+
+    scene_destroy(scene);
+    free(scene);
+}
+
+// ============================================================================
+// RENDER SNAPSHOTS
+// ============================================================================
+
+// Stands in for a display refresh between acquires
+#define BENCH_CONSUMER_PERIOD_NS 1000000L
+
+// Reads every body transform and particle as the renderer would
+static float bench_consume_snapshot(const RenderSnapshot* snap) {
+    float sum = 0.0f;
+    for (int i = 0; i < snap->body_count; i++) {
+        Vec3 x;
+        Quat q;
+        render_snapshot_body_transform(snap, i, 0.5f, &x, &q);
+        sum += x.x + x.y + x.z + q.w;
+    }
+    for (int i = 0; i < snap->particle_count; i++) sum += snap->particle_position[i].y * snap->particle_alpha[i];
+    return sum;
+}
+
+static bool bench_snapshot_matches(const RenderSnapshot* snap, const Scene* scene) {
+    const BodyStore* b = &scene->bodies;
+    const ParticleStore* p = &scene->particles;
+    // memcmp must not see the NULL arrays of an empty store
+    return snap->body_count == b->count && snap->particle_count == p->count &&
+           (b->count == 0 || (memcmp(snap->position, b->position, b->count * sizeof(Vec3)) == 0 &&
+                              memcmp(snap->orientation, b->orientation, b->count * sizeof(Quat)) == 0)) &&
+           (p->count == 0 || memcmp(snap->particle_position, p->position, p->count * sizeof(Vec3)) == 0);
+}
+
+/*
+ * bench_snapshots
+ * The simulation thread free-runs the workload (no explosions) publishing
+ * a checksummed snapshot after each step; this thread acquires one about
+ * every millisecond and checks it was not written while being read.
+ */
+void bench_snapshots(const BenchSceneParams* params, int steps, float dt, BenchSnapshotResult* result) {
+    memset(result, 0, sizeof(BenchSnapshotResult));
+    Scene* scene = malloc(sizeof(Scene));
+    if (!scene) return;
+    bench_build_scene(scene, params);
+    scene->particle_rng = params->seed ? params->seed : 1u;
+    if (params->emitter_rate > 0.0f) {
+        scene_add_emitter(scene, (Emitter){
+            .position = params->explosion_origin,
+            .rate = params->emitter_rate,
+            .spawn = particle_spawn_explosion(),
+            .active = true,
+            .rng = params->seed + 1u,
+        });
+    }
+    SceneStepper stepper;
+    stepper_init(&stepper, 1.0f / dt, 1, 1);
+
+    SimThreadSettings settings = { .free_run = true, .step_limit = (uint64_t)steps, .checksum = true };
+    uint64_t start = timer_now_ns();
+    SimThread* sim = sim_thread_start(scene, &stepper, &settings);
+    if (!sim) {
+        stepper_free(&stepper);
+        scene_destroy(scene);
+        free(scene);
+        return;
+    }
+
+    uint64_t last_sequence = 0;
+    uint64_t consume_ns = 0;
+    volatile float sink = 0.0f;
+    const RenderSnapshot* snap = NULL;
+    while (!sim_thread_finished(sim)) {
+        uint64_t acquired = sim_thread_acquired(sim);
+        snap = sim_thread_acquire(sim);
+        if (snap && sim_thread_acquired(sim) != acquired) {
+            uint64_t t = timer_now_ns();
+            if (render_snapshot_checksum(snap) != snap->checksum) result->torn++;
+            if (snap->sequence < last_sequence) result->out_of_order++;
+            last_sequence = snap->sequence;
+            sink += bench_consume_snapshot(snap);
+            consume_ns += timer_now_ns() - t;
+        }
+        struct timespec ts = { 0, BENCH_CONSUMER_PERIOD_NS };
+        nanosleep(&ts, NULL);
+    }
+    uint64_t elapsed = timer_now_ns() - start;
+
+    // Everything published is visible once the thread has finished
+    snap = sim_thread_acquire(sim);
+    result->final_matches = snap && snap->sequence == (uint64_t)steps && bench_snapshot_matches(snap, scene) &&
+                            render_snapshot_checksum(snap) == snap->checksum;
+    result->steps = steps;
+    result->published = sim_thread_published(sim);
+    result->acquired = sim_thread_acquired(sim);
+    result->ns_per_step = steps > 0 ? (double)elapsed / steps : 0.0;
+    result->consume_ns = result->acquired > 0 ? (double)consume_ns / result->acquired : 0.0;
+    (void)sink;
+
+    sim_thread_stop(sim);
+    stepper_free(&stepper);
+    scene_destroy(scene);
+    free(scene);
+}
+
+// ============================================================================
+// BASELINES
+// ============================================================================
+
+bool bench_save_baseline(const char* path, const BenchSceneParams* const* scenes, const BenchResult* results, int count) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# scene steps_per_sec ns_per_body_step bodies steps dt\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(f, "%s %.3f %.3f %d %d %.6f\n", scenes[i]->name,
+                results[i].steps_per_sec, results[i].ns_per_body_step,
+                results[i].body_count, results[i].steps, results[i].dt);
+    }
+    fclose(f);
+    return true;
+}
+
+bool bench_load_baseline(const char* path, const char* scene_name, BenchResult* result) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    char line[256];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') continue;
+        char name[64];
+        BenchResult r;
+        memset(&r, 0, sizeof(r));
+        if (sscanf(line, "%63s %lf %lf %d %d %f", name, &r.steps_per_sec, &r.ns_per_body_step,
+                   &r.body_count, &r.steps, &r.dt) >= 3 && strcmp(name, scene_name) == 0) {
+            *result = r;
+            found = true;
+        }
+    }
+    fclose(f);
+    return found;
+}
@@ -0,0 +1,449 @@
+/*
+ * Headless simulation driver.
+ *
+ * Runs the standard workloads (or a single named/customized one) for a fixed
+ * number of scene_update steps at a fixed dt, without GLUT or a GL context.
+ * Results can be stored as a baseline and compared against on later runs.
+ */
+#include "bench.h"
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BENCH_SCENES 16
+
+// Trace events per step: phase and stage zones plus the step counters
+#define TRACE_EVENTS_PER_STEP 24
+
+static void print_usage(const char* prog) {
+    printf("usage: %s [options]\n", prog);
+    printf("  --list                 list standard scenes\n");
+    printf("  --scene NAME           run a single standard scene (default: all)\n");
+    printf("  --steps N              steps per scene (default 600)\n");
+    printf("  --dt SECONDS           fixed timestep (default 1/60)\n");
+    printf("  --bodies N             override body count\n");
+    printf("  --radius MIN MAX       override radius distribution\n");
+    printf("  --density RHO          override density\n");
+    printf("  --boxes F              override the share of bodies that are boxes\n");
+    printf("  --gravity GY           override vertical gravity\n");
+    printf("  --world SIZE           override world size\n");
+    printf("  --seed N               override random seed\n");
+    printf("  --trails               give every body a motion trail\n");
+    printf("  --broadphase NAME      brute | octree | grid | sap (default octree)\n");
+    printf("  --broadphase-sweep     compare broad phases at 1k, 10k and 100k bodies\n");
+    printf("  --layout N             integrate N bodies as RigidBody records vs BodyStore\n");
+    printf("  --simd N               check batched math against the scalar code on N elements\n");
+    printf("  --no-sleep             keep every body active\n");
+    printf("  --iterations N         contact solver velocity iterations (default %d)\n", COLLISION_SOLVER_ITERATIONS);
+    printf("  --no-warm-start        start every contact solve from zero impulse\n");
+    printf("  --no-ccd               disable continuous collision for fast bodies\n");
+    printf("  --no-particle-hits     let particles pass through bodies and walls\n");
+    printf("  --tunneling            fire bullets through a wall at 1x, 2x and 4x dt, with and without CCD\n");
+    printf("  --threads N            worker threads for the per-body phases (0 = all CPUs)\n");
+    printf("  --thread-scaling       run each scene at 1, 2, 4 .. N threads and check results match\n");
+    printf("  --alloc-check          run each scene again on its grown storage; fail if a step allocates\n");
+    printf("  --snapshots            step on a simulation thread and check the render snapshots it publishes\n");
+    printf("  --profile              print each scene's per-frame zone and counter summary\n");
+    printf("  --trace FILE           write zones and counters as a Chrome trace (chrome://tracing)\n");
+    printf("  --save FILE            write results as a baseline\n");
+    printf("  --baseline FILE        compare against a stored baseline\n");
+}
+
+// Brute force beyond this size takes minutes per frame
+#define SWEEP_BRUTE_FORCE_LIMIT 20000
+
+static void run_broadphase_sweep(int frames) {
+    static const int sizes[] = { 1000, 10000, 100000 };
+    printf("%-8s %-8s %14s %14s\n", "bodies", "method", "ms/frame", "pairs/frame");
+    for (int s = 0; s < 3; s++) {
+        for (int t = 0; t < BROADPHASE_COUNT; t++) {
+            const char* name = collision_broadphase_name((BroadphaseType)t);
+            if (t == BROADPHASE_BRUTE_FORCE && sizes[s] > SWEEP_BRUTE_FORCE_LIMIT) {
+                printf("%-8d %-8s %14s\n", sizes[s], name, "skipped");
+                continue;
+            }
+            BenchBroadphaseResult r;
+            bench_broadphase((BroadphaseType)t, sizes[s], frames, &r);
+            printf("%-8d %-8s %14.3f %14.1f\n", sizes[s], name, r.ns_per_frame * 1e-6, r.pairs_per_frame);
+        }
+    }
+}
+
+static void print_misses(double misses) {
+    if (misses < 0) printf("%14s", "n/a");
+    else printf("%14.3f", misses);
+}
+
+static void run_layout_compare(int body_count) {
+    BenchLayoutResult r;
+    bench_layout(body_count, 60, &r);
+    printf("bodies=%d steps=%d sizeof(RigidBody)=%d\n", r.body_count, r.steps, r.aos_bytes_per_body);
+    printf("%-10s %14s %14s\n", "layout", "ns/body/step", "misses/body");
+    printf("%-10s %14.2f", "records", r.aos_ns_per_body);
+    print_misses(r.aos_misses_per_body);
+    printf("\n%-10s %14.2f", "soa", r.soa_ns_per_body);
+    print_misses(r.soa_misses_per_body);
+    printf("\n");
+}
+
+// Batched results may differ from the scalar reference by rounding only
+#define SIMD_TOLERANCE 1e-4
+
+static int run_simd_check(int count) {
+    BenchSimdResult r;
+    bench_simd(count, &r);
+    printf("backend=%s width=%d elements=%d\n", r.backend, r.width, r.count);
+    printf("%-16s %12s %12s %12s %10s\n", "kernel", "max error", "scalar ns", "batch ns", "speedup");
+    int failed = 0;
+    for (int i = 0; i < BENCH_SIMD_KERNEL_COUNT; i++) {
+        const BenchSimdKernel* k = &r.kernels[i];
+        bool ok = k->max_error <= SIMD_TOLERANCE;
+        printf("%-16s %12.2e %12.2f %12.2f %9.2fx%s\n", k->name, k->max_error, k->scalar_ns, k->batch_ns,
+               k->batch_ns > 0 ? k->scalar_ns / k->batch_ns : 0.0, ok ? "" : "  MISMATCH");
+        if (!ok) failed++;
+    }
+    return failed ? 1 : 0;
+}
+
+/*
+ * Bullets against a wall at growing timesteps. Fails if any bullet gets
+ * through with continuous collision enabled.
+ */
+static int run_tunneling_check(float dt) {
+    printf("%-10s %-6s %8s %10s %12s\n", "dt", "ccd", "steps", "tunneled", "us/step");
+    int failed = 0;
+    for (int scale = 1; scale <= 4; scale *= 2) {
+        for (int ccd = 0; ccd <= 1; ccd++) {
+            BenchTunnelingResult r;
+            bench_tunneling(dt * scale, ccd != 0, &r);
+            printf("%-10.5f %-6s %8d %5d/%-4d %12.2f%s\n", r.dt, ccd ? "on" : "off", r.steps, r.tunneled, r.bullets,
+                   r.ns_per_step * 1e-3, ccd && r.tunneled > 0 ? "  TUNNELED" : "");
+            if (ccd && r.tunneled > 0) failed++;
+        }
+    }
+    return failed ? 1 : 0;
+}
+
+/*
+ * Times the workload at 1, 2, 4 .. max_threads workers (max_threads included).
+ * Forces and integration are split by body, collision resolution by contact
+ * island; every run must end in the same state as the single-threaded one.
+ */
+static void run_thread_scaling(Scene* scene, const BenchSceneParams* p, int steps, float dt,
+                               BroadphaseType broadphase, int max_threads) {
+    printf("%s: %d bodies, %d steps\n", p->name, p->body_count, steps);
+    printf("%8s %12s %16s %10s %14s %8s\n", "threads", "total ms", "forces+integ ms", "speedup", "collision ms", "state");
+
+    double serial_ns = 0.0;
+    uint64_t serial_hash = 0;
+    for (int threads = 1; ; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        BenchResult r;
+        bench_build_scene(scene, p);
+        scene->collision.broadphase = broadphase;
+        scene_set_thread_count(scene, threads);
+        bench_run(scene, p, steps, dt, &r);
+        uint64_t hash = bench_state_hash(scene);
+        scene_destroy(scene);
+
+        double parallel_ns = r.phase_ns[SCENE_PHASE_FORCES] + r.phase_ns[SCENE_PHASE_INTEGRATE];
+        if (threads == 1) {
+            serial_ns = parallel_ns;
+            serial_hash = hash;
+        }
+        printf("%8d %12.3f %16.3f %9.2fx %14.3f %8s\n", threads, r.total_ns * 1e-6, parallel_ns * 1e-6,
+               parallel_ns > 0 ? serial_ns / parallel_ns : 0.0, r.phase_ns[SCENE_PHASE_COLLISION] * 1e-6,
+               hash == serial_hash ? "same" : "DIFFERS");
+        if (threads >= max_threads) break;
+    }
+}
+
+/*
+ * Replays the workload just run on the same scene. Storage has grown to
+ * every high the first run reached, so no step of the replay may touch the
+ * heap; a step that does allocates per step, not per workload.
+ */
+static int run_alloc_check(Scene* scene, const BenchSceneParams* p, int steps, float dt) {
+    BenchResult replay;
+    bench_reset_scene(scene, p);
+    bench_run(scene, p, steps, dt, &replay);
+    printf("  replay heap allocations %llu", (unsigned long long)replay.allocations);
+    if (replay.last_allocating_step >= 0) printf(" | last at step %d  ALLOCATES", replay.last_allocating_step);
+    printf("\n");
+    return replay.allocations > 0 ? 1 : 0;
+}
+
+/*
+ * Steps each scene on a simulation thread while this thread consumes its
+ * render snapshots. Fails on a torn or out-of-order snapshot, or if the
+ * last one differs from the scene.
+ */
+static int run_snapshot_check(const BenchSceneParams* p, int steps, float dt) {
+    BenchSnapshotResult r;
+    bench_snapshots(p, steps, dt, &r);
+    bool ok = r.torn == 0 && r.out_of_order == 0 && r.final_matches;
+    printf("%-18s steps=%d published=%llu acquired=%llu torn=%d out-of-order=%d final=%s | %.1f us/step, %.1f us/acquire (checksum included)%s\n",
+           p->name, r.steps, (unsigned long long)r.published, (unsigned long long)r.acquired, r.torn, r.out_of_order,
+           r.final_matches ? "match" : "DIFFERS", r.ns_per_step * 1e-3, r.consume_ns * 1e-3, ok ? "" : "  FAILED");
+    return ok ? 0 : 1;
+}
+
+static double percent_change(double now, double before) {
+    return before != 0.0 ? (now - before) / before * 100.0 : 0.0;
+}
+
+static void print_result(const BenchSceneParams* p, const BenchResult* r, BroadphaseType broadphase, const char* baseline_path) {
+    printf("%-18s bodies=%d", p->name, r->body_count);
+    if (r->body_count != p->body_count) printf(" (requested %d)", p->body_count);
+    printf(" steps=%d dt=%.5f broadphase=%s\n", r->steps, r->dt, collision_broadphase_name(broadphase));
+    printf("  total %10.3f ms | %10.1f steps/s | %8.1f ns/body/step\n",
+           r->total_ns * 1e-6, r->steps_per_sec, r->ns_per_body_step);
+    printf("  pairs/step %10.1f | contacts/step %8.1f | islands/step %8.1f | largest island %d\n",
+           r->pairs_per_step, r->contacts_per_step, r->islands_per_step, r->largest_island);
+    printf("  sleeping/step %7.1f | warm-started/step %8.1f | swept/step %8.1f | ccd clamped/step %6.1f\n",
+           r->sleeping_per_step, r->warm_started_per_step, r->swept_per_step, r->clamped_per_step);
+    if (r->particles_per_step > 0.0) {
+        printf("  particles/step %8.1f | particle-body tests/step %9.1f | particle hits/step %8.1f\n",
+               r->particles_per_step, r->particle_tests_per_step, r->particle_hits_per_step);
+    }
+    if (r->box_pairs_per_step > 0.0) {
+        printf("  box pairs/step %6.1f | cached-axis rejects/step %6.1f (%.1f%%)\n",
+               r->box_pairs_per_step, r->axis_rejects_per_step,
+               r->axis_rejects_per_step / r->box_pairs_per_step * 100.0);
+    }
+
+    printf("  heap allocations %llu", (unsigned long long)r->allocations);
+    if (r->last_allocating_step >= 0) printf(" | last at step %d", r->last_allocating_step);
+    printf("\n");
+
+    double accounted = 0.0;
+    for (int ph = 0; ph < SCENE_PHASE_COUNT; ph++) {
+        double share = r->total_ns > 0 ? r->phase_ns[ph] / r->total_ns * 100.0 : 0.0;
+        printf("  %-10s %10.3f ms (%5.1f%%)\n", scene_phase_name((ScenePhase)ph), r->phase_ns[ph] * 1e-6, share);
+        accounted += r->phase_ns[ph];
+        if (ph != SCENE_PHASE_COLLISION) continue;
+        for (int st = 0; st < COLLISION_STAGE_COUNT; st++) {
+            double stage_share = r->total_ns > 0 ? r->stage_ns[st] / r->total_ns * 100.0 : 0.0;
+            printf("    %-8s %10.3f ms (%5.1f%%)\n", collision_stage_name((CollisionStage)st), r->stage_ns[st] * 1e-6, stage_share);
+        }
+    }
+    printf("  %-10s %10.3f ms\n", "other", (r->total_ns - accounted) * 1e-6);
+
+    BenchResult base;
+    if (baseline_path && bench_load_baseline(baseline_path, p->name, &base)) {
+        printf("  vs baseline: steps/s %+.1f%%, ns/body/step %+.1f%%\n",
+               percent_change(r->steps_per_sec, base.steps_per_sec),
+               percent_change(r->ns_per_body_step, base.ns_per_body_step));
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* scene_name = NULL;
+    const char* save_path = NULL;
+    const char* baseline_path = NULL;
+    int steps = 600;
+    float dt = 1.0f / 60.0f;
+
+    // Overrides (negative = keep scene default)
+    int bodies = -1;
+    float radius_min = -1.0f, radius_max = -1.0f;
+    float density = -1.0f, world = -1.0f, boxes = -1.0f;
+    float gravity_y = 0.0f;
+    bool override_gravity = false;
+    long seed = -1;
+    BroadphaseType broadphase = BROADPHASE_OCTREE;
+    int threads = 1;
+    bool thread_scaling = false;
+    bool sleep = true;
+    bool ccd = true;
+    bool tunneling = false;
+    bool particle_collision = true;
+    bool alloc_check = false;
+    bool snapshots = false;
+    bool trails = false;
+    bool profile = false;
+    const char* trace_path = NULL;
+    ContactSolverSettings solver = { COLLISION_SOLVER_ITERATIONS, true };
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_next = i + 1 < argc;
+        if (strcmp(arg, "--list") == 0) {
+            for (int s = 0; s < bench_standard_scene_count(); s++) {
+                const BenchSceneParams* p = bench_standard_scene(s);
+                printf("%-18s %6d bodies, r=[%.2f, %.2f], world=%.0f\n",
+                       p->name, p->body_count, p->radius_min, p->radius_max, p->world_size);
+            }
+            return 0;
+        } else if (strcmp(arg, "--scene") == 0 && has_next) {
+            scene_name = argv[++i];
+        } else if (strcmp(arg, "--steps") == 0 && has_next) {
+            steps = atoi(argv[++i]);
+        } else if (strcmp(arg, "--dt") == 0 && has_next) {
+            dt = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--bodies") == 0 && has_next) {
+            bodies = atoi(argv[++i]);
+        } else if (strcmp(arg, "--radius") == 0 && i + 2 < argc) {
+            radius_min = (float)atof(argv[++i]);
+            radius_max = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--density") == 0 && has_next) {
+            density = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--boxes") == 0 && has_next) {
+            boxes = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--gravity") == 0 && has_next) {
+            gravity_y = (float)atof(argv[++i]);
+            override_gravity = true;
+        } else if (strcmp(arg, "--world") == 0 && has_next) {
+            world = (float)atof(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_next) {
+            seed = atol(argv[++i]);
+        } else if (strcmp(arg, "--trails") == 0) {
+            trails = true;
+        } else if (strcmp(arg, "--broadphase") == 0 && has_next) {
+            if (!collision_broadphase_from_name(argv[++i], &broadphase)) {
+                fprintf(stderr, "unknown broad phase '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(arg, "--broadphase-sweep") == 0) {
+            run_broadphase_sweep(20);
+            return 0;
+        } else if (strcmp(arg, "--layout") == 0 && has_next) {
+            run_layout_compare(atoi(argv[++i]));
+            return 0;
+        } else if (strcmp(arg, "--simd") == 0 && has_next) {
+            return run_simd_check(atoi(argv[++i]));
+        } else if (strcmp(arg, "--no-sleep") == 0) {
+            sleep = false;
+        } else if (strcmp(arg, "--iterations") == 0 && has_next) {
+            solver.iterations = atoi(argv[++i]);
+        } else if (strcmp(arg, "--no-warm-start") == 0) {
+            solver.warm_start = false;
+        } else if (strcmp(arg, "--no-ccd") == 0) {
+            ccd = false;
+        } else if (strcmp(arg, "--no-particle-hits") == 0) {
+            particle_collision = false;
+        } else if (strcmp(arg, "--tunneling") == 0) {
+            tunneling = true;
+        } else if (strcmp(arg, "--threads") == 0 && has_next) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--thread-scaling") == 0) {
+            thread_scaling = true;
+        } else if (strcmp(arg, "--alloc-check") == 0) {
+            alloc_check = true;
+        } else if (strcmp(arg, "--snapshots") == 0) {
+            snapshots = true;
+        } else if (strcmp(arg, "--profile") == 0) {
+            profile = true;
+        } else if (strcmp(arg, "--trace") == 0 && has_next) {
+            trace_path = argv[++i];
+        } else if (strcmp(arg, "--save") == 0 && has_next) {
+            save_path = argv[++i];
+        } else if (strcmp(arg, "--baseline") == 0 && has_next) {
+            baseline_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+#ifndef PHYSICS_PROFILE
+    if (profile || trace_path) {
+        fprintf(stderr, "--profile and --trace need a build with -DPHYSICS_PROFILE\n");
+        return 1;
+    }
+#endif
+
+    // After parsing, so --dt applies
+    if (tunneling) return run_tunneling_check(dt);
+
+    // Select workloads
+    BenchSceneParams params[MAX_BENCH_SCENES];
+    int count = 0;
+    if (scene_name) {
+        const BenchSceneParams* p = bench_find_scene(scene_name);
+        if (!p) {
+            fprintf(stderr, "unknown scene '%s' (see --list)\n", scene_name);
+            return 1;
+        }
+        params[count++] = *p;
+    } else {
+        for (int s = 0; s < bench_standard_scene_count() && count < MAX_BENCH_SCENES; s++) {
+            params[count++] = *bench_standard_scene(s);
+        }
+    }
+
+    for (int s = 0; s < count; s++) {
+        BenchSceneParams* p = &params[s];
+        if (bodies >= 0) p->body_count = bodies;
+        if (radius_min > 0.0f) { p->radius_min = radius_min; p->radius_max = radius_max; }
+        if (density > 0.0f) p->density = density;
+        if (boxes >= 0.0f) p->box_fraction = boxes;
+        if (override_gravity) p->gravity = (Vec3){0, gravity_y, 0};
+        if (world > 0.0f) p->world_size = world;
+        if (seed >= 0) p->seed = (unsigned int)seed;
+        if (trails) p->trails = true;
+    }
+
+    if (snapshots) {
+        int failed = 0;
+        for (int s = 0; s < count; s++) failed += run_snapshot_check(&params[s], steps, dt);
+        return failed ? 1 : 0;
+    }
+
+    Scene* scene = malloc(sizeof(Scene));
+    if (!scene) return 1;
+
+    if (thread_scaling) {
+        int max_threads = threads > 1 ? threads : thread_pool_cpu_count();
+        for (int s = 0; s < count; s++) {
+            run_thread_scaling(scene, &params[s], steps, dt, broadphase, max_threads);
+        }
+        free(scene);
+        return 0;
+    }
+
+    // The allocation check replays every scene
+    int traced_steps = count * steps * (alloc_check ? 2 : 1);
+    if ((profile || trace_path) && !profile_start(trace_path ? traced_steps * TRACE_EVENTS_PER_STEP : 0)) {
+        fprintf(stderr, "failed to allocate the trace buffer\n");
+        return 1;
+    }
+
+    BenchResult results[MAX_BENCH_SCENES];
+    int failed = 0;
+    const BenchSceneParams* ran[MAX_BENCH_SCENES];
+    for (int s = 0; s < count; s++) {
+        bench_build_scene(scene, &params[s]);
+        scene->collision.broadphase = broadphase;
+        scene_set_thread_count(scene, threads);
+        scene->sleep.enabled = sleep;
+        scene->collision.solver = solver;
+        scene->collision.ccd.enabled = ccd;
+        scene->particle_collision.enabled = particle_collision;
+        profile_begin_track(params[s].name);
+        bench_run(scene, &params[s], steps, dt, &results[s]);
+        ran[s] = &params[s];
+        print_result(&params[s], &results[s], broadphase, baseline_path);
+        if (profile) profile_print_summary(stdout);
+        if (alloc_check) failed += run_alloc_check(scene, &params[s], steps, dt);
+        scene_destroy(scene);
+    }
+
+    if (trace_path) {
+        profile_stop();
+        if (profile_write_chrome_trace(trace_path)) {
+            printf("trace: %d events written to %s", profile_event_count(), trace_path);
+            if (profile_dropped_count() > 0) printf(" (%d dropped)", profile_dropped_count());
+            printf("\n");
+        } else {
+            fprintf(stderr, "failed to write trace '%s'\n", trace_path);
+        }
+    }
+
+    if (save_path && !bench_save_baseline(save_path, ran, results, count)) {
+        fprintf(stderr, "failed to write baseline '%s'\n", save_path);
+    }
+
+    free(scene);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,368 @@
+#include "body_store.h"
+#include "mem.h"
+#include <string.h>
+
+// ============================================================================
+// STORAGE
+// ============================================================================
+
+void body_store_init(BodyStore* store, int capacity) {
+    memset(store, 0, sizeof(BodyStore));
+    store->free_slot = -1;
+    body_store_reserve(store, capacity);
+}
+
+// Realloc that leaves the old block in place (and clears ok) on failure
+static void* body_store_grow(void* array, size_t size, int capacity, bool* ok) {
+    void* grown = mem_realloc(array, (size_t)capacity * size);
+    if (grown) return grown;
+    *ok = false;
+    return array;
+}
+
+// Arrays that did grow keep their larger block; capacity only moves once all have
+bool body_store_reserve(BodyStore* store, int capacity) {
+    if (capacity <= store->capacity) return true;
+    bool ok = true;
+
+    store->position           = body_store_grow(store->position,           sizeof(Vec3),       capacity, &ok);
+    store->velocity           = body_store_grow(store->velocity,           sizeof(Vec3),       capacity, &ok);
+    store->force_accumulator  = body_store_grow(store->force_accumulator,  sizeof(Vec3),       capacity, &ok);
+    store->orientation        = body_store_grow(store->orientation,        sizeof(Quat),       capacity, &ok);
+    store->angular_velocity   = body_store_grow(store->angular_velocity,   sizeof(Vec3),       capacity, &ok);
+    store->torque_accumulator = body_store_grow(store->torque_accumulator, sizeof(Vec3),       capacity, &ok);
+    store->inv_inertia_world  = body_store_grow(store->inv_inertia_world,  sizeof(Mat3),       capacity, &ok);
+    store->inv_inertia_body   = body_store_grow(store->inv_inertia_body,   sizeof(Vec3),       capacity, &ok);
+    store->inv_mass           = body_store_grow(store->inv_mass,           sizeof(float),      capacity, &ok);
+    store->radius             = body_store_grow(store->radius,             sizeof(float),      capacity, &ok);
+    store->drag_linear        = body_store_grow(store->drag_linear,        sizeof(float),      capacity, &ok);
+    store->drag_angular       = body_store_grow(store->drag_angular,       sizeof(float),      capacity, &ok);
+    store->flags              = body_store_grow(store->flags,              sizeof(uint8_t),    capacity, &ok);
+    store->shape              = body_store_grow(store->shape,              sizeof(uint8_t),    capacity, &ok);
+
+    store->restitution        = body_store_grow(store->restitution,        sizeof(float),      capacity, &ok);
+    store->friction           = body_store_grow(store->friction,           sizeof(float),      capacity, &ok);
+    store->sleep_timer        = body_store_grow(store->sleep_timer,        sizeof(float),      capacity, &ok);
+    store->sleep_group        = body_store_grow(store->sleep_group,        sizeof(uint32_t),   capacity, &ok);
+
+    store->mass               = body_store_grow(store->mass,               sizeof(float),      capacity, &ok);
+    store->inertia_tensor     = body_store_grow(store->inertia_tensor,     sizeof(Mat3),       capacity, &ok);
+    store->half_extents       = body_store_grow(store->half_extents,       sizeof(Vec3),       capacity, &ok);
+    store->id                 = body_store_grow(store->id,                 sizeof(int),        capacity, &ok);
+    store->visuals            = body_store_grow(store->visuals,            sizeof(BodyVisual), capacity, &ok);
+    store->slot               = body_store_grow(store->slot,               sizeof(uint32_t),   capacity, &ok);
+    if (ok) store->capacity = capacity;
+    return ok;
+}
+
+void body_store_free(BodyStore* store) {
+    mem_free(store->position);
+    mem_free(store->velocity);
+    mem_free(store->force_accumulator);
+    mem_free(store->orientation);
+    mem_free(store->angular_velocity);
+    mem_free(store->torque_accumulator);
+    mem_free(store->inv_inertia_world);
+    mem_free(store->inv_inertia_body);
+    mem_free(store->inv_mass);
+    mem_free(store->radius);
+    mem_free(store->drag_linear);
+    mem_free(store->drag_angular);
+    mem_free(store->flags);
+    mem_free(store->shape);
+    mem_free(store->restitution);
+    mem_free(store->friction);
+    mem_free(store->sleep_timer);
+    mem_free(store->sleep_group);
+    mem_free(store->mass);
+    mem_free(store->inertia_tensor);
+    mem_free(store->half_extents);
+    mem_free(store->id);
+    mem_free(store->visuals);
+    mem_free(store->slot);
+    for (int p = 0; p < store->page_count; p++) mem_free(store->slot_pages[p]);
+    mem_free(store->slot_pages);
+    memset(store, 0, sizeof(BodyStore));
+    store->free_slot = -1;
+}
+
+// Invalidates every handle; storage is kept
+void body_store_clear(BodyStore* store) {
+    while (store->count > 0) body_store_remove(store, store->count - 1);
+}
+
+// ============================================================================
+// HANDLES
+// ============================================================================
+
+static inline BodySlot* body_store_slot(const BodyStore* store, uint32_t slot) {
+    return &store->slot_pages[slot / BODY_SLOT_PAGE_SIZE][slot % BODY_SLOT_PAGE_SIZE];
+}
+
+// -1 if a new page could not be allocated
+static int body_store_alloc_slot(BodyStore* store) {
+    if (store->free_slot >= 0) {
+        int slot = store->free_slot;
+        store->free_slot = body_store_slot(store, (uint32_t)slot)->index;
+        return slot;
+    }
+
+    if (store->slot_count == store->page_count * BODY_SLOT_PAGE_SIZE) {
+        BodySlot** pages = mem_realloc(store->slot_pages, (store->page_count + 1) * sizeof(BodySlot*));
+        if (!pages) return -1;
+        store->slot_pages = pages;
+        BodySlot* page = mem_calloc(BODY_SLOT_PAGE_SIZE, sizeof(BodySlot));
+        if (!page) return -1;
+        store->slot_pages[store->page_count++] = page;
+    }
+    return store->slot_count++;
+}
+
+BodyHandle body_store_handle(const BodyStore* store, int index) {
+    if (index < 0 || index >= store->count) return BODY_HANDLE_NULL;
+    uint32_t slot = store->slot[index];
+    return (BodyHandle){ slot, body_store_slot(store, slot)->generation };
+}
+
+int body_store_index(const BodyStore* store, BodyHandle handle) {
+    if (handle.slot >= (uint32_t)store->slot_count) return -1;
+    const BodySlot* s = body_store_slot(store, handle.slot);
+    return s->generation == handle.generation ? s->index : -1;
+}
+
+// ============================================================================
+// SHAPE ORDER
+// ============================================================================
+
+// Flags the store if the body at index breaks the grouping by shape
+static void body_store_check_order(BodyStore* store, int index) {
+    uint8_t s = store->shape[index];
+    if ((index > 0 && store->shape[index - 1] > s) ||
+        (index + 1 < store->count && store->shape[index + 1] < s)) {
+        store->shape_unsorted = true;
+    }
+}
+
+_Static_assert(sizeof(BodyVisual) <= sizeof(Mat3), "Mat3 is the largest per-body field");
+
+static void body_store_swap_field(void* array, size_t size, int a, int b) {
+    unsigned char tmp[sizeof(Mat3)];
+    unsigned char* base = array;
+    memcpy(tmp, base + (size_t)a * size, size);
+    memcpy(base + (size_t)a * size, base + (size_t)b * size, size);
+    memcpy(base + (size_t)b * size, tmp, size);
+}
+
+// Exchanges every field of bodies a and b; their handles follow
+static void body_store_swap(BodyStore* store, int a, int b) {
+    body_store_swap_field(store->position,           sizeof(Vec3),       a, b);
+    body_store_swap_field(store->velocity,           sizeof(Vec3),       a, b);
+    body_store_swap_field(store->force_accumulator,  sizeof(Vec3),       a, b);
+    body_store_swap_field(store->orientation,        sizeof(Quat),       a, b);
+    body_store_swap_field(store->angular_velocity,   sizeof(Vec3),       a, b);
+    body_store_swap_field(store->torque_accumulator, sizeof(Vec3),       a, b);
+    body_store_swap_field(store->inv_inertia_world,  sizeof(Mat3),       a, b);
+    body_store_swap_field(store->inv_inertia_body,   sizeof(Vec3),       a, b);
+    body_store_swap_field(store->inv_mass,           sizeof(float),      a, b);
+    body_store_swap_field(store->radius,             sizeof(float),      a, b);
+    body_store_swap_field(store->drag_linear,        sizeof(float),      a, b);
+    body_store_swap_field(store->drag_angular,       sizeof(float),      a, b);
+    body_store_swap_field(store->flags,              sizeof(uint8_t),    a, b);
+    body_store_swap_field(store->shape,              sizeof(uint8_t),    a, b);
+    body_store_swap_field(store->restitution,        sizeof(float),      a, b);
+    body_store_swap_field(store->friction,           sizeof(float),      a, b);
+    body_store_swap_field(store->sleep_timer,        sizeof(float),      a, b);
+    body_store_swap_field(store->sleep_group,        sizeof(uint32_t),   a, b);
+    body_store_swap_field(store->mass,               sizeof(float),      a, b);
+    body_store_swap_field(store->inertia_tensor,     sizeof(Mat3),       a, b);
+    body_store_swap_field(store->half_extents,       sizeof(Vec3),       a, b);
+    body_store_swap_field(store->id,                 sizeof(int),        a, b);
+    body_store_swap_field(store->visuals,            sizeof(BodyVisual), a, b);
+    body_store_swap_field(store->slot,               sizeof(uint32_t),   a, b);
+    body_store_slot(store, store->slot[a])->index = a;
+    body_store_slot(store, store->slot[b])->index = b;
+}
+
+/*
+ * One partition pass per shape: the bodies of shape s are gathered at the
+ * front of what is left by swapping the first misplaced body from the front
+ * with the last body of shape s. Runs of bodies that are already grouped do
+ * not move, so a store broken by one add or removal costs a few swaps.
+ */
+bool body_store_sort_by_shape(BodyStore* store) {
+    store->shape_unsorted = false;
+    bool moved = false;
+    int begin = 0;
+    for (uint8_t s = 0; s + 1 < SHAPE_COUNT; s++) {
+        int i = begin, j = store->count - 1;
+        for (;;) {
+            while (i <= j && store->shape[i] == s) i++;
+            while (i < j && store->shape[j] != s) j--;
+            if (i >= j) break;
+            body_store_swap(store, i++, j--);
+            moved = true;
+        }
+        begin = i;
+    }
+    return moved;
+}
+
+// ============================================================================
+// ADD / REMOVE
+// ============================================================================
+
+int body_store_add(BodyStore* store, const RigidBody* body) {
+    if (store->count == store->capacity &&
+        !body_store_reserve(store, store->capacity ? store->capacity * 2 : 64)) {
+        return -1;
+    }
+    int slot = body_store_alloc_slot(store);
+    if (slot < 0) return -1;
+
+    int index = store->count++;
+    body_store_write(store, index, body);
+    body_store_slot(store, (uint32_t)slot)->index = index;
+    store->slot[index] = (uint32_t)slot;
+    return index;
+}
+
+// Copies every field of body from into slot to
+static void body_store_move(BodyStore* store, int from, int to) {
+    store->position[to]           = store->position[from];
+    store->velocity[to]           = store->velocity[from];
+    store->force_accumulator[to]  = store->force_accumulator[from];
+    store->orientation[to]        = store->orientation[from];
+    store->angular_velocity[to]   = store->angular_velocity[from];
+    store->torque_accumulator[to] = store->torque_accumulator[from];
+    store->inv_inertia_world[to]  = store->inv_inertia_world[from];
+    store->inv_inertia_body[to]   = store->inv_inertia_body[from];
+    store->inv_mass[to]           = store->inv_mass[from];
+    store->radius[to]             = store->radius[from];
+    store->drag_linear[to]        = store->drag_linear[from];
+    store->drag_angular[to]       = store->drag_angular[from];
+    store->flags[to]              = store->flags[from];
+    store->shape[to]              = store->shape[from];
+    store->restitution[to]        = store->restitution[from];
+    store->friction[to]           = store->friction[from];
+    store->sleep_timer[to]        = store->sleep_timer[from];
+    store->sleep_group[to]        = store->sleep_group[from];
+    store->mass[to]               = store->mass[from];
+    store->inertia_tensor[to]     = store->inertia_tensor[from];
+    store->half_extents[to]       = store->half_extents[from];
+    store->id[to]                 = store->id[from];
+    store->visuals[to]            = store->visuals[from];
+    store->slot[to]               = store->slot[from];
+}
+
+void body_store_remove(BodyStore* store, int index) {
+    if (index < 0 || index >= store->count) return;
+
+    // Retire the handle and put its slot on the free list
+    BodySlot* dead = body_store_slot(store, store->slot[index]);
+    dead->generation++;
+    dead->index = store->free_slot;
+    store->free_slot = (int)store->slot[index];
+
+    int last = --store->count;
+    if (index != last) {
+        body_store_move(store, last, index);
+        body_store_slot(store, store->slot[index])->index = index;
+        body_store_check_order(store, index);
+    }
+}
+
+// ============================================================================
+// SLEEPING
+// ============================================================================
+
+void body_store_wake(BodyStore* store, int index) {
+    store->flags[index] &= (uint8_t)~BODY_FLAG_SLEEPING;
+    store->sleep_timer[index] = 0.0f;
+}
+
+void body_store_add_force(BodyStore* store, int index, Vec3 force) {
+    if (store->flags[index] & BODY_FLAG_STATIC) return;
+    store->force_accumulator[index] = vec3_add(store->force_accumulator[index], force);
+    body_store_wake(store, index);
+}
+
+void body_store_add_torque(BodyStore* store, int index, Vec3 torque) {
+    if (store->flags[index] & BODY_FLAG_STATIC) return;
+    store->torque_accumulator[index] = vec3_add(store->torque_accumulator[index], torque);
+    body_store_wake(store, index);
+}
+
+// ============================================================================
+// RIGIDBODY CONVERSION
+// ============================================================================
+
+void body_store_write(BodyStore* store, int index, const RigidBody* body) {
+    store->position[index]           = body->position;
+    store->velocity[index]           = body->velocity;
+    store->force_accumulator[index]  = body->force_accumulator;
+    store->orientation[index]        = body->orientation;
+    store->angular_velocity[index]   = body->angular_velocity;
+    store->torque_accumulator[index] = body->torque_accumulator;
+    store->inv_inertia_world[index]  = body->inv_inertia_world;
+    store->inv_inertia_body[index]   = (Vec3){ body->inv_inertia_body.m[0][0],
+                                               body->inv_inertia_body.m[1][1],
+                                               body->inv_inertia_body.m[2][2] };
+    store->inv_mass[index]           = body->inv_mass;
+    store->radius[index]             = body->radius;
+    store->drag_linear[index]        = body->drag_linear;
+    store->drag_angular[index]       = body->drag_angular;
+    store->flags[index]              = (body->is_static ? BODY_FLAG_STATIC : 0) |
+                                       (body->is_sleeping ? BODY_FLAG_SLEEPING : 0) |
+                                       (body->is_bullet ? BODY_FLAG_CCD : 0) |
+                                       (body->trail ? BODY_FLAG_TRAIL : 0);
+    store->shape[index]              = (uint8_t)body->shape;
+
+    store->restitution[index]        = body->restitution;
+    store->friction[index]           = body->friction;
+    store->sleep_timer[index]        = 0.0f;
+    store->sleep_group[index]        = UINT32_MAX;
+
+    store->mass[index]               = body->mass;
+    store->inertia_tensor[index]     = body->inertia_tensor;
+    store->half_extents[index]       = body->half_extents;
+    store->id[index]                 = body->id;
+
+    BodyVisual* v = &store->visuals[index];
+    v->color = body->color;
+    body_store_check_order(store, index);
+}
+
+void body_store_read(const BodyStore* store, int index, RigidBody* out) {
+    memset(out, 0, sizeof(RigidBody));
+    out->position           = store->position[index];
+    out->velocity           = store->velocity[index];
+    out->force_accumulator  = store->force_accumulator[index];
+    out->orientation        = store->orientation[index];
+    out->angular_velocity   = store->angular_velocity[index];
+    out->torque_accumulator = store->torque_accumulator[index];
+    out->inv_inertia_world  = store->inv_inertia_world[index];
+    out->inv_inertia_body   = mat3_zero();
+    out->inv_inertia_body.m[0][0] = store->inv_inertia_body[index].x;
+    out->inv_inertia_body.m[1][1] = store->inv_inertia_body[index].y;
+    out->inv_inertia_body.m[2][2] = store->inv_inertia_body[index].z;
+    out->inv_mass           = store->inv_mass[index];
+    out->radius             = store->radius[index];
+    out->drag_linear        = store->drag_linear[index];
+    out->drag_angular       = store->drag_angular[index];
+    out->is_static          = (store->flags[index] & BODY_FLAG_STATIC) != 0;
+    out->is_sleeping        = (store->flags[index] & BODY_FLAG_SLEEPING) != 0;
+    out->is_bullet          = (store->flags[index] & BODY_FLAG_CCD) != 0;
+    out->trail              = (store->flags[index] & BODY_FLAG_TRAIL) != 0;
+    out->shape              = (ShapeType)store->shape[index];
+
+    out->restitution        = store->restitution[index];
+    out->friction           = store->friction[index];
+
+    out->mass               = store->mass[index];
+    out->inertia_tensor     = store->inertia_tensor[index];
+    out->half_extents       = store->half_extents[index];
+    out->id                 = store->id[index];
+
+    const BodyVisual* v = &store->visuals[index];
+    out->color = v->color;
+}
@@ -0,0 +1,228 @@
+#include "box_collision.h"
+#include <float.h>
+#include <math.h>
+
+OrientedBox oriented_box_make(Vec3 center, Quat orientation, Vec3 half_extents) {
+    Mat3 r = quat_to_mat3(orientation);
+    OrientedBox box;
+    box.center = center;
+    for (int k = 0; k < 3; k++) box.axis[k] = (Vec3){ r.m[0][k], r.m[1][k], r.m[2][k] };
+    box.half = half_extents;
+    return box;
+}
+
+static float box_half(const OrientedBox* box, int k) {
+    return k == 0 ? box->half.x : (k == 1 ? box->half.y : box->half.z);
+}
+
+// Half length of the box's projection on L: Σ h_k |u⃗_k ⋅ L|
+static float box_extent_along(const OrientedBox* box, Vec3 L) {
+    return box->half.x * fabsf(vec3_dot(box->axis[0], L)) +
+           box->half.y * fabsf(vec3_dot(box->axis[1], L)) +
+           box->half.z * fabsf(vec3_dot(box->axis[2], L));
+}
+
+static void box_vertices(const OrientedBox* box, Vec3 out[8]) {
+    Vec3 ex = vec3_scale(box->axis[0], box->half.x);
+    Vec3 ey = vec3_scale(box->axis[1], box->half.y);
+    Vec3 ez = vec3_scale(box->axis[2], box->half.z);
+    for (int v = 0; v < 8; v++) {
+        Vec3 p = box->center;
+        p = (v & 1) ? vec3_add(p, ex) : vec3_sub(p, ex);
+        p = (v & 2) ? vec3_add(p, ey) : vec3_sub(p, ey);
+        p = (v & 4) ? vec3_add(p, ez) : vec3_sub(p, ez);
+        out[v] = p;
+    }
+}
+
+// Unit axis k of the pair; false for the cross product of parallel edges
+static bool sat_axis(const OrientedBox* a, const OrientedBox* b, int k, Vec3* L) {
+    if (k < 3) { *L = a->axis[k]; return true; }
+    if (k < 6) { *L = b->axis[k - 3]; return true; }
+    Vec3 c = vec3_cross(a->axis[(k - 6) / 3], b->axis[(k - 6) % 3]);
+    float len_sq = vec3_mag_sq(c);
+    if (len_sq < 1e-6f) return false;
+    *L = vec3_scale(c, 1.0f / sqrtf(len_sq));
+    return true;
+}
+
+// r_A + r_B - |t⃗ ⋅ L|: overlap of the projections, negative if L separates
+static float sat_overlap(const OrientedBox* a, const OrientedBox* b, Vec3 t, Vec3 L) {
+    return box_extent_along(a, L) + box_extent_along(b, L) - fabsf(vec3_dot(t, L));
+}
+
+// Point of `box` with u⃗_k coordinates clamped to its extents, except along `keep`
+static Vec3 box_clamp_point(const OrientedBox* box, Vec3 p, int keep) {
+    Vec3 d = vec3_sub(p, box->center);
+    Vec3 q = box->center;
+    for (int k = 0; k < 3; k++) {
+        float s = vec3_dot(d, box->axis[k]);
+        float h = box_half(box, k);
+        if (k != keep) s = fminf(fmaxf(s, -h), h);
+        q = vec3_add(q, vec3_scale(box->axis[k], s));
+    }
+    return q;
+}
+
+/*
+ * Face contact: the incident box's vertices behind the reference face
+ * (whose outward normal is n̂) are averaged, then clamped to the face so
+ * the point lies in the overlap. A box resting flat gets its point under
+ * the middle of the overlap and carries no tipping torque.
+ */
+static Vec3 box_face_point(const OrientedBox* ref, int face, const OrientedBox* inc, Vec3 n) {
+    float plane = vec3_dot(n, ref->center) + box_half(ref, face);
+    Vec3 verts[8];
+    box_vertices(inc, verts);
+    Vec3 sum = vec3_zero();
+    int count = 0;
+    float deepest = FLT_MAX;
+    Vec3 deepest_v = inc->center;
+    for (int v = 0; v < 8; v++) {
+        float d = vec3_dot(n, verts[v]);
+        if (d < deepest) { deepest = d; deepest_v = verts[v]; }
+        if (d >= plane) continue;
+        sum = vec3_add(sum, verts[v]);
+        count++;
+    }
+    Vec3 p = count > 0 ? vec3_scale(sum, 1.0f / count) : deepest_v;
+    return box_clamp_point(ref, p, face);
+}
+
+// Midpoint of the closest points of two segments c⃗ + s d̂, |s| ≤ h
+static Vec3 segment_closest_midpoint(Vec3 c1, Vec3 d1, float h1, Vec3 c2, Vec3 d2, float h2) {
+    Vec3 r = vec3_sub(c1, c2);
+    float b = vec3_dot(d1, d2), c = vec3_dot(d1, r), f = vec3_dot(d2, r);
+    float denom = 1.0f - b * b;
+    float s = denom > 1e-6f ? fminf(fmaxf((b * f - c) / denom, -h1), h1) : 0.0f;
+    float t = fminf(fmaxf(b * s + f, -h2), h2);
+    s = fminf(fmaxf(b * t - c, -h1), h1);
+    Vec3 p1 = vec3_add(c1, vec3_scale(d1, s));
+    Vec3 p2 = vec3_add(c2, vec3_scale(d2, t));
+    return vec3_scale(vec3_add(p1, p2), 0.5f);
+}
+
+// Edge of the box parallel to u⃗_k that lies furthest along dir
+static Vec3 box_support_edge(const OrientedBox* box, int k, Vec3 dir) {
+    Vec3 c = box->center;
+    for (int m = 0; m < 3; m++) {
+        if (m == k) continue;
+        float s = vec3_dot(box->axis[m], dir) >= 0.0f ? 1.0f : -1.0f;
+        c = vec3_add(c, vec3_scale(box->axis[m], s * box_half(box, m)));
+    }
+    return c;
+}
+
+/*
+ * box_box_contact
+ * The boxes are disjoint iff some axis L separates their projections:
+ *   |t⃗ ⋅ L| > Σ hᴬ_k |u⃗ᴬ_k ⋅ L| + Σ hᴮ_k |u⃗ᴮ_k ⋅ L|,  t⃗ = c⃗_B - c⃗_A
+ * over the 3 + 3 face normals and 9 edge cross products. When none does,
+ * the axis of least overlap is the contact normal and the overlap the
+ * penetration; edge axes are taken only when clearly better than a face,
+ * so resting boxes keep a stable face contact.
+ */
+bool box_box_contact(const OrientedBox* a, const OrientedBox* b, int hint, Contact* contact, int* axis) {
+    Vec3 t = vec3_sub(b->center, a->center);
+    Vec3 L;
+    if (hint >= 0 && hint < BOX_SAT_AXIS_COUNT && sat_axis(a, b, hint, &L) && sat_overlap(a, b, t, L) < 0.0f) {
+        *axis = hint;
+        return false;
+    }
+
+    int best = -1;
+    float best_overlap = FLT_MAX;
+    Vec3 best_L = { 0, 1, 0 };
+    for (int k = 0; k < BOX_SAT_AXIS_COUNT; k++) {
+        if (!sat_axis(a, b, k, &L)) continue;
+        float overlap = sat_overlap(a, b, t, L);
+        if (overlap < 0.0f) {
+            *axis = k;
+            return false;
+        }
+        if (k < 6 ? overlap < best_overlap : overlap < BOX_SAT_EDGE_PREFERENCE * best_overlap) {
+            best = k;
+            best_overlap = overlap;
+            best_L = L;
+        }
+    }
+    *axis = best;
+
+    Vec3 n = vec3_dot(t, best_L) < 0.0f ? vec3_scale(best_L, -1.0f) : best_L;
+    contact->normal = n;
+    contact->penetration = best_overlap;
+    if (best < 3) {
+        contact->point = box_face_point(a, best, b, n);
+    } else if (best < 6) {
+        contact->point = box_face_point(b, best - 3, a, vec3_scale(n, -1.0f));
+    } else {
+        int i = (best - 6) / 3, j = (best - 6) % 3;
+        Vec3 ea = box_support_edge(a, i, n);
+        Vec3 eb = box_support_edge(b, j, vec3_scale(n, -1.0f));
+        contact->point = segment_closest_midpoint(ea, a->axis[i], box_half(a, i), eb, b->axis[j], box_half(b, j));
+    }
+    return true;
+}
+
+/*
+ * box_sphere_contact
+ * Closest point of the box to the sphere center: clamp the center's box
+ * coordinates to ±h. A center inside the box is pushed out through the
+ * nearest face.
+ */
+bool box_sphere_contact(const OrientedBox* box, Vec3 center, float radius, Contact* contact) {
+    Vec3 d = vec3_sub(center, box->center);
+    float local[3], clamped[3];
+    bool inside = true;
+    Vec3 q = box->center;
+    for (int k = 0; k < 3; k++) {
+        float h = box_half(box, k);
+        local[k] = vec3_dot(d, box->axis[k]);
+        clamped[k] = fminf(fmaxf(local[k], -h), h);
+        inside &= clamped[k] == local[k];
+        q = vec3_add(q, vec3_scale(box->axis[k], clamped[k]));
+    }
+
+    if (!inside) {
+        Vec3 diff = vec3_sub(center, q);
+        float dist_sq = vec3_mag_sq(diff);
+        if (dist_sq >= radius * radius) return false;
+        float dist = sqrtf(dist_sq);
+        contact->normal = dist > 1e-6f ? vec3_scale(diff, 1.0f / dist) : box->axis[1];
+        contact->penetration = radius - dist;
+        contact->point = q;
+        return true;
+    }
+
+    int face = 0;
+    float face_dist = FLT_MAX;
+    for (int k = 0; k < 3; k++) {
+        float gap = box_half(box, k) - fabsf(local[k]);
+        if (gap < face_dist) { face_dist = gap; face = k; }
+    }
+    Vec3 n = local[face] < 0.0f ? vec3_scale(box->axis[face], -1.0f) : box->axis[face];
+    contact->normal = n;
+    contact->penetration = radius + face_dist;
+    contact->point = vec3_add(center, vec3_scale(n, face_dist));
+    return true;
+}
+
+bool box_plane_contact(const OrientedBox* box, Vec3 normal, float offset, Contact* contact) {
+    float depth = offset - (vec3_dot(normal, box->center) - box_extent_along(box, normal));
+    if (depth <= 0.0f) return false;
+
+    Vec3 verts[8];
+    box_vertices(box, verts);
+    Vec3 sum = vec3_zero();
+    int count = 0;
+    for (int v = 0; v < 8; v++) {
+        if (vec3_dot(normal, verts[v]) >= offset) continue;
+        sum = vec3_add(sum, verts[v]);
+        count++;
+    }
+    if (count == 0) return false;   // Rounding: the deepest vertex is on the plane
+    contact->normal = vec3_scale(normal, -1.0f);
+    contact->penetration = depth;
+    contact->point = vec3_scale(sum, 1.0f / count);
+    return true;
+}
@@ -1,96 +1,1825 @@
 #include "collision.h"
+#include "box_collision.h"
+#include "mem.h"
+#include "profile.h"
+#include "spatial_hash.h"
+#include "sweep_prune.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include "vec3_batch.h"
 #include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
 
-void collision_handle_world_boundaries(PhysicsObject* obj, float box_size) {
-    float half_box = box_size / 2.0f;
-    float restitution = 0.75f; // Coefficient of restitution (ε)
+/*
+ * collision_detect_sphere_sphere
+ * Narrow phase test for two bounding spheres.
+ *
+ * d⃗ = x⃗_B - x⃗_A, collision if ‖d⃗‖ < r_A + r_B.
+ * n̂ = d⃗ / ‖d⃗‖ (from A to B), penetration = (r_A + r_B) - ‖d⃗‖.
+ * The contact point lies on the surface of A along n̂.
+ */
+bool collision_detect_sphere_sphere(const BodyStore* bodies, int a, int b, Contact* contact) {
+    Vec3 pa = bodies->position[a];
+    Vec3 d = vec3_sub(bodies->position[b], pa);
+    float dist_sq = vec3_mag_sq(d);
+    float total_radius = bodies->radius[a] + bodies->radius[b];
+
+    if (dist_sq >= total_radius * total_radius) return false;
+
+    float dist = sqrtf(dist_sq);
+    contact->a = a;
+    contact->b = b;
+    // Coincident centers: pick an arbitrary but consistent normal
+    contact->normal = (dist > 1e-6f) ? vec3_scale(d, 1.0f / dist) : (Vec3){0, 1, 0};
+    contact->penetration = total_radius - dist;
+    contact->point = vec3_add(pa, vec3_scale(contact->normal, bodies->radius[a]));
+    return true;
+}
+
+/*
+ * collision_project
+ * Removes overlap by a linear projection split by inverse mass, leaving
+ * `slop` of penetration so resting contacts persist between steps.
+ */
+void collision_project(BodyStore* bodies, const Contact* c) {
+    int a = c->a;
+    int b = c->b;
+    float inv_mass_a = bodies->inv_mass[a];
+    float inv_mass_b = b != CONTACT_WORLD ? bodies->inv_mass[b] : 0.0f;
+    float inv_mass_sum = inv_mass_a + inv_mass_b;
+    if (inv_mass_sum <= 0.0f) return;
+
+    const float slop = 0.01f;
+    const float percent = 0.8f;
+    float correction_mag = fmaxf(c->penetration - slop, 0.0f) * percent / inv_mass_sum;
+    Vec3 correction = vec3_scale(c->normal, correction_mag);
+    // Static bodies are never written, so islands sharing one can run concurrently
+    if (inv_mass_a > 0.0f) bodies->position[a] = vec3_sub(bodies->position[a], vec3_scale(correction, inv_mass_a));
+    if (inv_mass_b > 0.0f) bodies->position[b] = vec3_add(bodies->position[b], vec3_scale(correction, inv_mass_b));
+}
+
+/*
+ * collision_resolve
+ * Single-shot impulse resolution of one contact, without friction or
+ * memory. The collision system uses the sequential impulse solver below;
+ * this remains for resolving an isolated contact.
+ *
+ * v⃗ᵣₑₗ = v⃗_B - v⃗_A, approaching if v⃗ᵣₑₗ ⋅ n̂ < 0.
+ * j = -(1 + ε)(v⃗ᵣₑₗ ⋅ n̂) / (1/m_A + 1/m_B)
+ * v⃗'_A = v⃗_A - (j/m_A)n̂,  v⃗'_B = v⃗_B + (j/m_B)n̂
+ */
+void collision_resolve(BodyStore* bodies, const Contact* c) {
+    int a = c->a;
+    int b = c->b;
+    bool world = b == CONTACT_WORLD;
+    float inv_mass_a = bodies->inv_mass[a];
+    float inv_mass_b = world ? 0.0f : bodies->inv_mass[b];
+    float inv_mass_sum = inv_mass_a + inv_mass_b;
+    if (inv_mass_sum <= 0.0f) return;
+
+    collision_project(bodies, c);
+
+    // --- Impulse Resolution ---
+    Vec3 velocity_b = world ? vec3_zero() : bodies->velocity[b];
+    Vec3 rel_vel = vec3_sub(velocity_b, bodies->velocity[a]);
+    float vel_along_normal = vec3_dot(rel_vel, c->normal);
+
+    // Do not resolve if velocities are separating
+    if (vel_along_normal > 0) return;
+
+    // Boundaries take on the material of whatever touches them
+    float e = world ? bodies->restitution[a] : fminf(bodies->restitution[a], bodies->restitution[b]);
+    float j = -(1.0f + e) * vel_along_normal / inv_mass_sum;
+    Vec3 impulse = vec3_scale(c->normal, j);
+
+    if (inv_mass_a > 0.0f) bodies->velocity[a] = vec3_sub(bodies->velocity[a], vec3_scale(impulse, inv_mass_a));
+    if (inv_mass_b > 0.0f) bodies->velocity[b] = vec3_add(bodies->velocity[b], vec3_scale(impulse, inv_mass_b));
+}
+
+// ============================================================================
+// BOUNDING VOLUMES
+// ============================================================================
+
+AABB aabb_from_sphere(Vec3 center, float radius) {
+    return (AABB){
+        {center.x - radius, center.y - radius, center.z - radius},
+        {center.x + radius, center.y + radius, center.z + radius}
+    };
+}
+
+bool aabb_overlap(AABB a, AABB b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+bool aabb_contains(AABB outer, AABB inner) {
+    return inner.min.x >= outer.min.x && inner.max.x <= outer.max.x &&
+           inner.min.y >= outer.min.y && inner.max.y <= outer.max.y &&
+           inner.min.z >= outer.min.z && inner.max.z <= outer.max.z;
+}
+
+static Vec3 vec3_clamp_box(Vec3 v, AABB box) {
+    return (Vec3){
+        fminf(fmaxf(v.x, box.min.x), box.max.x),
+        fminf(fmaxf(v.y, box.min.y), box.max.y),
+        fminf(fmaxf(v.z, box.min.z), box.max.z)
+    };
+}
+
+// Clamp both corners into bounds; boxes outside collapse onto the nearest face
+static AABB aabb_clamp(AABB box, AABB bounds) {
+    return (AABB){ vec3_clamp_box(box.min, bounds), vec3_clamp_box(box.max, bounds) };
+}
+
+static AABB aabb_fat(Vec3 position, float radius) {
+    return aabb_from_sphere(position, radius * (1.0f + OCTREE_FAT_MARGIN));
+}
+
+// ============================================================================
+// OCTREE
+// ============================================================================
+
+// Boxes bodies are placed by: the caller's for octree_build, the fat
+// proxies for the collision system. Indexed by body index.
+// Nodes come from pool, or from the heap when it is NULL (octree_build).
+typedef struct {
+    const AABB* boxes;
+    AABB root;
+    OctreePool* pool;
+} OctreeContext;
+
+static AABB octree_body_box(const OctreeContext* ctx, int body) {
+    return aabb_clamp(ctx->boxes[body], ctx->root);
+}
+
+// NULL if the node, or the pool's first block, could not be allocated
+static OctreeNode* octree_node_create(OctreePool* pool, AABB bounds) {
+    OctreeNode* node;
+    if (!pool) {
+        node = mem_calloc(1, sizeof(OctreeNode));
+        if (!node) return NULL;
+    } else if (pool->free_list) {
+        node = pool->free_list;
+        pool->free_list = node->children[0];
+        node->children[0] = NULL;
+    } else {
+        if (!pool->nodes) {
+            OctreeNode* nodes = mem_calloc(OCTREE_POOL_SIZE, sizeof(OctreeNode));
+            int* slab = mem_malloc((size_t)OCTREE_POOL_SIZE * OCTREE_POOL_NODE_BODIES * sizeof(int));
+            if (!nodes || !slab) {
+                mem_free(nodes);
+                mem_free(slab);
+                return NULL;
+            }
+            pool->nodes = nodes;
+            pool->body_slab = slab;
+        }
+        // The tree never holds more than OCTREE_POOL_SIZE nodes
+        node = &pool->nodes[pool->used++];
+        node->bodies = pool->body_slab + (node - pool->nodes) * OCTREE_POOL_NODE_BODIES;
+        node->capacity = OCTREE_POOL_NODE_BODIES;
+    }
+    node->bounds = bounds;
+    node->body_count = 0;
+    node->is_leaf = true;
+    return node;
+}
+
+// Empties a pooled node, handing a grown array back to the pool's spares
+// (or freeing it when the spare list cannot grow)
+static void octree_node_clear_bodies(OctreePool* pool, OctreeNode* node) {
+    node->body_count = 0;
+    int* slab = pool->body_slab + (node - pool->nodes) * OCTREE_POOL_NODE_BODIES;
+    if (node->bodies == slab) return;
+    if (pool->spare_count == pool->spare_capacity) {
+        int capacity = pool->spare_capacity ? pool->spare_capacity * 2 : 16;
+        OctreeSpareArray* spares = mem_realloc(pool->spares, capacity * sizeof(OctreeSpareArray));
+        if (spares) {
+            pool->spares = spares;
+            pool->spare_capacity = capacity;
+        }
+    }
+    if (pool->spare_count < pool->spare_capacity) {
+        pool->spares[pool->spare_count++] = (OctreeSpareArray){ node->bodies, node->capacity };
+    } else {
+        mem_free(node->bodies);
+    }
+    node->bodies = slab;
+    node->capacity = OCTREE_POOL_NODE_BODIES;
+}
+
+static void octree_node_release(OctreePool* pool, OctreeNode* node) {
+    if (!node) return;
+    for (int o = 0; o < 8; o++) {
+        octree_node_release(pool, node->children[o]);
+        node->children[o] = NULL;
+    }
+    if (!pool) {
+        mem_free(node->bodies);
+        mem_free(node);
+        return;
+    }
+    octree_node_clear_bodies(pool, node);
+    node->children[0] = pool->free_list;
+    pool->free_list = node;
+}
 
-    // For each axis (i ∈ {x, y, z}):
-    // If |posᵢ| + radius > half_box, a collision occurs.
-    // The response is to clamp the position and reflect the velocity:
-    // v'ᵢ = -ε ⋅ vᵢ
-    if (obj->position.x + obj->radius > half_box) {
-        obj->position.x = half_box - obj->radius;
-        obj->velocity.x *= -restitution;
+static void octree_pool_free(OctreePool* pool) {
+    for (int i = 0; i < pool->used; i++) octree_node_clear_bodies(pool, &pool->nodes[i]);
+    for (int i = 0; i < pool->spare_count; i++) mem_free(pool->spares[i].bodies);
+    mem_free(pool->spares);
+    mem_free(pool->nodes);
+    mem_free(pool->body_slab);
+    memset(pool, 0, sizeof(OctreePool));
+}
+
+// A pooled node outgrowing its array takes a spare of twice the size
+// before anything is allocated. Sizes are OCTREE_POOL_NODE_BODIES ⋅ 2^k;
+// matching them exactly keeps a larger spare for the leaf that needs it.
+// False if no array could be had; the node keeps its old one.
+static bool octree_node_grow(OctreePool* pool, OctreeNode* node) {
+    int capacity = node->capacity ? node->capacity * 2 : OCTREE_CAPACITY;
+    if (!pool) {
+        int* bodies = mem_realloc(node->bodies, capacity * sizeof(int));
+        if (!bodies) return false;
+        node->bodies = bodies;
+        node->capacity = capacity;
+        return true;
     }
-    if (obj->position.x - obj->radius < -half_box) {
-        obj->position.x = -half_box + obj->radius;
-        obj->velocity.x *= -restitution;
+
+    int match = -1;
+    for (int i = 0; i < pool->spare_count && match < 0; i++) {
+        if (pool->spares[i].capacity == capacity) match = i;
     }
-    if (obj->position.y + obj->radius > half_box) {
-        obj->position.y = half_box - obj->radius;
-        obj->velocity.y *= -restitution;
+    OctreeSpareArray grown;
+    if (match >= 0) {
+        grown = pool->spares[match];
+        pool->spares[match] = pool->spares[--pool->spare_count];
+    } else {
+        grown = (OctreeSpareArray){ mem_malloc(capacity * sizeof(int)), capacity };
+        if (!grown.bodies) return false;
     }
-    if (obj->position.y - obj->radius < -half_box) {
-        obj->position.y = -half_box + obj->radius;
-        obj->velocity.y *= -restitution;
+    memcpy(grown.bodies, node->bodies, node->body_count * sizeof(int));
+
+    int count = node->body_count;
+    octree_node_clear_bodies(pool, node);
+    node->bodies = grown.bodies;
+    node->capacity = grown.capacity;
+    node->body_count = count;
+    return true;
+}
+
+static bool octree_node_push(OctreePool* pool, OctreeNode* node, int body) {
+    if (node->body_count == node->capacity && !octree_node_grow(pool, node)) return false;
+    node->bodies[node->body_count++] = body;
+    return true;
+}
+
+static bool octree_node_has(const OctreeNode* node, int body) {
+    for (int i = 0; i < node->body_count; i++) {
+        if (node->bodies[i] == body) return true;
     }
-    if (obj->position.z + obj->radius > half_box) {
-        obj->position.z = half_box - obj->radius;
-        obj->velocity.z *= -restitution;
+    return false;
+}
+
+// Octant bits: 1 = +x, 2 = +y, 4 = +z
+static AABB octree_child_bounds(AABB b, int octant) {
+    Vec3 c = vec3_scale(vec3_add(b.min, b.max), 0.5f);
+    AABB r;
+    r.min.x = (octant & 1) ? c.x : b.min.x;  r.max.x = (octant & 1) ? b.max.x : c.x;
+    r.min.y = (octant & 2) ? c.y : b.min.y;  r.max.y = (octant & 2) ? b.max.y : c.y;
+    r.min.z = (octant & 4) ? c.z : b.min.z;  r.max.z = (octant & 4) ? b.max.z : c.z;
+    return r;
+}
+
+static bool octree_insert(const OctreeContext* ctx, OctreeNode* node, int body, AABB box, int depth);
+
+// Without nodes for the children the leaf just stays over capacity.
+// False if a body could not be re-inserted; the tree is then incomplete.
+static bool octree_split(const OctreeContext* ctx, OctreeNode* node, int depth) {
+    for (int o = 0; o < 8; o++) {
+        node->children[o] = octree_node_create(ctx->pool, octree_child_bounds(node->bounds, o));
+        if (node->children[o]) continue;
+        for (int k = 0; k < o; k++) {
+            octree_node_release(ctx->pool, node->children[k]);
+            node->children[k] = NULL;
+        }
+        return true;
     }
-    if (obj->position.z - obj->radius < -half_box) {
-        obj->position.z = -half_box + obj->radius;
-        obj->velocity.z *= -restitution;
+    node->is_leaf = false;
+
+    for (int i = 0; i < node->body_count; i++) {
+        int body = node->bodies[i];
+        if (!octree_insert(ctx, node, body, octree_body_box(ctx, body), depth)) return false;
+    }
+    if (ctx->pool) octree_node_clear_bodies(ctx->pool, node);
+    else node->body_count = 0;  // The array is kept for a later collapse
+    return true;
+}
+
+// Box must already be clamped to the root bounds. False if an array could
+// not grow; the tree no longer lists every body and must be rebuilt.
+static bool octree_insert(const OctreeContext* ctx, OctreeNode* node, int body, AABB box, int depth) {
+    if (!node->is_leaf) {
+        for (int o = 0; o < 8; o++) {
+            if (aabb_overlap(node->children[o]->bounds, box) &&
+                !octree_insert(ctx, node->children[o], body, box, depth + 1)) return false;
+        }
+        return true;
+    }
+
+    if (!octree_node_push(ctx->pool, node, body)) return false;
+    if (node->body_count > OCTREE_CAPACITY && depth < MAX_OCTREE_DEPTH) {
+        return octree_split(ctx, node, depth);
     }
+    return true;
+}
+
+// Merge leaf children back into their parent once they hold few bodies
+static void octree_try_collapse(OctreePool* pool, OctreeNode* node) {
+    int total = 0;
+    for (int o = 0; o < 8; o++) {
+        if (!node->children[o]->is_leaf) return;
+        total += node->children[o]->body_count;
+    }
+    // A node that split kept room for OCTREE_CAPACITY, so this never allocates
+    if (total > OCTREE_CAPACITY || total > node->capacity) return;
+
+    node->is_leaf = true;
+    for (int o = 0; o < 8; o++) {
+        OctreeNode* child = node->children[o];
+        for (int i = 0; i < child->body_count; i++) {
+            if (!octree_node_has(node, child->bodies[i])) octree_node_push(pool, node, child->bodies[i]);
+        }
+        octree_node_release(pool, child);
+        node->children[o] = NULL;
+    }
+}
+
+// Box must be the (clamped) box the body was inserted with
+static void octree_remove(const OctreeContext* ctx, OctreeNode* node, int body, AABB box) {
+    if (node->is_leaf) {
+        for (int i = 0; i < node->body_count; i++) {
+            if (node->bodies[i] == body) {
+                node->bodies[i] = node->bodies[--node->body_count];
+                return;
+            }
+        }
+        return;
+    }
+
+    for (int o = 0; o < 8; o++) {
+        if (aabb_overlap(node->children[o]->bounds, box)) {
+            octree_remove(ctx, node->children[o], body, box);
+        }
+    }
+    octree_try_collapse(ctx->pool, node);
+}
+
+OctreeNode* octree_build(AABB bounds, const AABB* boxes, int count, int depth) {
+    OctreeContext ctx = { boxes, bounds, NULL };
+    OctreeNode* root = octree_node_create(NULL, bounds);
+    if (!root) return NULL;
+    for (int i = 0; i < count; i++) {
+        if (!octree_insert(&ctx, root, i, octree_body_box(&ctx, i), depth)) {
+            octree_destroy(root);
+            return NULL;
+        }
+    }
+    return root;
+}
+
+void octree_destroy(OctreeNode* node) {
+    octree_node_release(NULL, node);
+}
+
+typedef struct {
+    AABB box;
+    uint32_t* mark;
+    uint32_t stamp;
+    int* results;
+    int max_results;
+    int count;
+} OctreeQuery;
+
+// False once results is full
+static bool octree_query_recursive(const OctreeNode* node, OctreeQuery* q) {
+    if (!aabb_overlap(node->bounds, q->box)) return true;
+    if (!node->is_leaf) {
+        for (int o = 0; o < 8; o++) {
+            if (!octree_query_recursive(node->children[o], q)) return false;
+        }
+        return true;
+    }
+
+    for (int i = 0; i < node->body_count; i++) {
+        int other = node->bodies[i];
+        // Bodies straddling leaves are listed once
+        if (q->mark[other] == q->stamp) continue;
+        if (q->count == q->max_results) return false;
+        q->mark[other] = q->stamp;
+        q->results[q->count++] = other;
+    }
+    return true;
 }
 
 /*
- * collision_resolve_spheres
- * Handles the elastic collision between two spheres.
- *
- * 1. Detection:
- * A collision occurs if the distance between centers is less than the sum of radii.
- * Let d = ‖x⃗₂ - x⃗₁‖. Collision if d < (r₁ + r₂).
- *
- * 2. Resolution (based on conservation of momentum and kinetic energy):
- * The collision normal vector is n̂ = (x⃗₂ - x⃗₁) / d.
- * The relative velocity is v⃗ᵣₑₗ = v⃗₁ - v⃗₂.
- * The impulse magnitude `j` for a perfectly elastic collision is calculated.
- * The impulse is a vector quantity J⃗ = jn̂ that describes the change in momentum.
- * j = (-2 * (v⃗ᵣₑₗ ⋅ n̂)) / (1/m₁ + 1/m₂)
- *
- * The change in momentum for each object is:
- * Δp⃗₁ = -J⃗ and Δp⃗₂ = J⃗
- *
- * Since p⃗ = mv⃗, the new velocities are:
- * v⃗'₁ = v⃗₁ - (j/m₁)n̂
- * v⃗'₂ = v⃗₂ + (j/m₂)n̂
+ * octree_query
+ * Collects the bodies listed in leaves that overlap `box`, each once, up to
+ * max_results; returns the number written. Duplicates are caught by
+ * stamping mark[body] (one entry per body) with a value it does not hold
+ * yet, so each query costs O(k) and mark is never cleared: pass a fresh
+ * stamp per query and zero mark when the counter wraps.
  */
-void collision_resolve_spheres(PhysicsObject* obj1, PhysicsObject* obj2) {
-    Vec3 axis = vec3_sub(obj1->position, obj2->position);
-    float dist_sq = vec3_dot(axis, axis);
-    float total_radius = obj1->radius + obj2->radius;
+int octree_query(const OctreeNode* node, AABB box, uint32_t* mark, uint32_t stamp, int* results, int max_results) {
+    if (!node || max_results <= 0) return 0;
+    OctreeQuery q = { aabb_clamp(box, node->bounds), mark, stamp, results, max_results, 0 };
+    octree_query_recursive(node, &q);
+    return q.count;
+}
+
+void octree_for_each_leaf(OctreeNode* node, void (*visit)(OctreeNode* leaf, void* user), void* user) {
+    if (!node) return;
+    if (node->is_leaf) {
+        visit(node, user);
+        return;
+    }
+    for (int o = 0; o < 8; o++) octree_for_each_leaf(node->children[o], visit, user);
+}
+
+static bool aabb_contains_point(AABB box, Vec3 p) {
+    return p.x >= box.min.x && p.x <= box.max.x &&
+           p.y >= box.min.y && p.y <= box.max.y &&
+           p.z >= box.min.z && p.z <= box.max.z;
+}
+
+// Octants split at the center, which is where child 0 ends
+const OctreeNode* octree_find_leaf(const OctreeNode* node, Vec3 p) {
+    if (!node || !aabb_contains_point(node->bounds, p)) return NULL;
+    while (!node->is_leaf) {
+        Vec3 c = node->children[0]->bounds.max;
+        node = node->children[(p.x >= c.x) | ((p.y >= c.y) << 1) | ((p.z >= c.z) << 2)];
+    }
+    return node;
+}
+
+// ============================================================================
+// COLLISION SYSTEM
+// ============================================================================
+
+void collision_system_init(CollisionSystem* sys, float world_size) {
+    memset(sys, 0, sizeof(CollisionSystem));
+    sys->broadphase = BROADPHASE_OCTREE;
+    sys->solver = (ContactSolverSettings){ COLLISION_SOLVER_ITERATIONS, true };
+    sys->ccd = (ContinuousSettings){ true, COLLISION_CCD_MOTION };
+    pair_cache_init(&sys->cache, sizeof(ContactImpulse));
+    pair_cache_init(&sys->axes, sizeof(int));
+    sys->stages[COLLISION_STAGE_CCD]         = collision_stage_ccd;
+    sys->stages[COLLISION_STAGE_BROADPHASE]  = collision_stage_broadphase;
+    sys->stages[COLLISION_STAGE_NARROWPHASE] = collision_stage_narrowphase;
+    sys->stages[COLLISION_STAGE_ISLANDS]     = collision_stage_islands;
+    sys->stages[COLLISION_STAGE_SOLVE]       = collision_stage_solve;
+    collision_system_set_world_size(sys, world_size);
+}
+
+const char* collision_stage_name(CollisionStage stage) {
+    switch (stage) {
+        case COLLISION_STAGE_CCD:         return "ccd";
+        case COLLISION_STAGE_BROADPHASE:  return "broad";
+        case COLLISION_STAGE_NARROWPHASE: return "narrow";
+        case COLLISION_STAGE_ISLANDS:     return "islands";
+        case COLLISION_STAGE_SOLVE:       return "solve";
+        default:                          return "?";
+    }
+}
+
+const char* collision_broadphase_name(BroadphaseType type) {
+    switch (type) {
+        case BROADPHASE_BRUTE_FORCE: return "brute";
+        case BROADPHASE_OCTREE:      return "octree";
+        case BROADPHASE_GRID:        return "grid";
+        case BROADPHASE_SAP:         return "sap";
+        default:                     return "?";
+    }
+}
+
+bool collision_broadphase_from_name(const char* name, BroadphaseType* type) {
+    for (int t = 0; t < BROADPHASE_COUNT; t++) {
+        if (strcmp(name, collision_broadphase_name((BroadphaseType)t)) == 0) {
+            *type = (BroadphaseType)t;
+            return true;
+        }
+    }
+    return false;
+}
+
+void collision_system_set_world_size(CollisionSystem* sys, float world_size) {
+    float h = world_size / 2.0f;
+    sys->world_bounds = (AABB){ {-h, -h, -h}, {h, h, h} };
+    collision_system_reset_planes(sys);
+    collision_system_clear(sys);
+}
+
+void collision_system_clear_planes(CollisionSystem* sys) {
+    sys->plane_count = 0;
+}
+
+bool collision_system_add_plane(CollisionSystem* sys, Vec3 normal, float offset) {
+    if (sys->plane_count == sys->plane_capacity) {
+        int capacity = sys->plane_capacity ? sys->plane_capacity * 2 : 8;
+        CollisionPlane* planes = mem_realloc(sys->planes, capacity * sizeof(CollisionPlane));
+        if (!planes) return false;
+        sys->planes = planes;
+        sys->plane_capacity = capacity;
+    }
+    sys->planes[sys->plane_count++] = (CollisionPlane){ vec3_normalize(normal), offset };
+    return true;
+}
+
+// Floor first, so plane_count = 1 leaves only the floor
+void collision_system_reset_planes(CollisionSystem* sys) {
+    AABB w = sys->world_bounds;
+    collision_system_clear_planes(sys);
+    collision_system_add_plane(sys, (Vec3){ 0,  1,  0 },  w.min.y);
+    collision_system_add_plane(sys, (Vec3){ 0, -1,  0 }, -w.max.y);
+    collision_system_add_plane(sys, (Vec3){ 1,  0,  0 },  w.min.x);
+    collision_system_add_plane(sys, (Vec3){-1,  0,  0 }, -w.max.x);
+    collision_system_add_plane(sys, (Vec3){ 0,  0,  1 },  w.min.z);
+    collision_system_add_plane(sys, (Vec3){ 0,  0, -1 }, -w.max.z);
+}
+
+void collision_system_forget_bodies(CollisionSystem* sys) {
+    octree_node_release(&sys->octree_pool, sys->octree);
+    sys->octree = NULL;
+    sys->tracked_count = 0;
+    sys->pairs.count = 0;
+    sys->swept_count = 0;
+    sys->sweep_tracked = 0;
+    sys->contact_count = 0;
+    sys->island_count = 0;
+    sys->island_body_count = 0;
+    if (sys->sap) sweep_prune_clear(sys->sap);
+}
+
+void collision_system_clear(CollisionSystem* sys) {
+    collision_system_forget_bodies(sys);
+    pair_cache_clear(&sys->cache);
+    pair_cache_clear(&sys->axes);
+}
+
+void collision_system_cleanup(CollisionSystem* sys) {
+    collision_system_clear(sys);
+    octree_pool_free(&sys->octree_pool);
+    frame_arena_free(&sys->frame);
+    if (sys->grid) {
+        spatial_hash_free(sys->grid);
+        mem_free(sys->grid);
+        sys->grid = NULL;
+    }
+    if (sys->sap) {
+        sweep_prune_free(sys->sap);
+        mem_free(sys->sap);
+        sys->sap = NULL;
+    }
+    mem_free(sys->proxies);
+    sys->proxies = NULL;
+    sys->proxy_capacity = 0;
+    mem_free(sys->planes);
+    sys->planes = NULL;
+    sys->plane_count = sys->plane_capacity = 0;
+    mem_free(sys->swept);
+    mem_free(sys->swept_toi);
+    mem_free(sys->sweep_order);
+    sys->swept = NULL;
+    sys->swept_toi = NULL;
+    sys->sweep_boxes = NULL;
+    sys->sweep_order = NULL;
+    sys->swept_capacity = 0;
+    sys->sweep_capacity = 0;
+    pair_list_free(&sys->pairs);
+    pair_cache_free(&sys->cache);
+    pair_cache_free(&sys->axes);
+    mem_free(sys->contacts);
+    mem_free(sys->island_contacts);
+    mem_free(sys->islands);
+    mem_free(sys->body_island);
+    sys->wake_mark = NULL;
+    sys->wake_mark_capacity = 0;
+    sys->contacts = NULL;
+    sys->island_contacts = NULL;
+    sys->contact_island = NULL;
+    sys->pair_hit = NULL;
+    sys->islands = NULL;
+    sys->body_island = NULL;
+    sys->island_parent = NULL;
+    sys->contact_count = sys->contact_capacity = 0;
+    sys->island_count = sys->island_capacity = 0;
+}
+
+bool pair_list_push(PairList* list, int a, int b) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 256;
+        BodyPair* pairs = mem_realloc(list->pairs, capacity * sizeof(BodyPair));
+        if (!pairs) return false;
+        list->pairs = pairs;
+        list->capacity = capacity;
+    }
+    list->pairs[list->count++] = (a < b) ? (BodyPair){a, b} : (BodyPair){b, a};
+    return true;
+}
+
+void pair_list_free(PairList* list) {
+    mem_free(list->pairs);
+    list->pairs = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/*
+ * Incremental refit.
+ * Each body owns a fat proxy box (radius enlarged by OCTREE_FAT_MARGIN).
+ * Only bodies whose tight box escaped their proxy are removed and reinserted;
+ * resting or slowly moving bodies cost one containment test per frame.
+ * False if an allocation failed; the tree is dropped and rebuilt next frame.
+ */
+static void collision_drop_octree(CollisionSystem* sys) {
+    octree_node_release(&sys->octree_pool, sys->octree);
+    sys->octree = NULL;
+    sys->tracked_count = 0;
+}
+
+static bool collision_refit_octree(CollisionSystem* sys, const BodyStore* bodies) {
+    int count = bodies->count;
+    if (!sys->octree || count < sys->tracked_count) {
+        collision_drop_octree(sys);
+        sys->octree = octree_node_create(&sys->octree_pool, sys->world_bounds);
+        if (!sys->octree) return false;
+    }
+    if (count > sys->proxy_capacity) {
+        AABB* proxies = mem_realloc(sys->proxies, count * 2 * sizeof(AABB));
+        if (!proxies) {
+            collision_drop_octree(sys);
+            return false;
+        }
+        sys->proxies = proxies;
+        sys->proxy_capacity = count * 2;
+    }
+
+    OctreeContext ctx = { sys->proxies, sys->world_bounds, &sys->octree_pool };
+    const Vec3* position = bodies->position;
+    const float* radius = bodies->radius;
+    sys->reinserted = 0;
+
+    for (int i = 0; i < sys->tracked_count; i++) {
+        if (bodies->flags[i] & BODY_FLAG_SLEEPING) continue; // Not moving
+        if (aabb_contains(sys->proxies[i], aabb_from_sphere(position[i], radius[i]))) continue;
+
+        octree_remove(&ctx, sys->octree, i, octree_body_box(&ctx, i));
+        sys->proxies[i] = aabb_fat(position[i], radius[i]);
+        if (!octree_insert(&ctx, sys->octree, i, octree_body_box(&ctx, i), 0)) {
+            collision_drop_octree(sys);
+            return false;
+        }
+        sys->reinserted++;
+    }
+
+    // Newly added bodies
+    for (int i = sys->tracked_count; i < count; i++) {
+        sys->proxies[i] = aabb_fat(position[i], radius[i]);
+        if (!octree_insert(&ctx, sys->octree, i, octree_body_box(&ctx, i), 0)) {
+            collision_drop_octree(sys);
+            return false;
+        }
+    }
+    sys->tracked_count = count;
+    return true;
+}
+
+/*
+ * Mirrors the swap-remove of the body store. The tree refers to bodies by
+ * index, so the last body is re-keyed under its new index; an untracked
+ * body moving into a tracked index is inserted there.
+ */
+static void collision_octree_remove_body(CollisionSystem* sys, const BodyStore* bodies, int index, int last) {
+    if (!sys->octree || index >= sys->tracked_count) return;
+
+    OctreeContext ctx = { sys->proxies, sys->world_bounds, &sys->octree_pool };
+    octree_remove(&ctx, sys->octree, index, octree_body_box(&ctx, index));
+    if (index == last) {
+        sys->tracked_count--;
+        return;
+    }
+
+    if (last < sys->tracked_count) {
+        octree_remove(&ctx, sys->octree, last, octree_body_box(&ctx, last));
+        sys->proxies[index] = sys->proxies[last];
+        sys->tracked_count--;
+    } else {
+        sys->proxies[index] = aabb_fat(bodies->position[last], bodies->radius[last]);
+    }
+    if (!octree_insert(&ctx, sys->octree, index, octree_body_box(&ctx, index), 0)) collision_drop_octree(sys);
+}
+
+void collision_system_remove_body(CollisionSystem* sys, const BodyStore* bodies, int index) {
+    int last = bodies->count - 1;
+    if (index < 0 || index > last) return;
+
+    collision_octree_remove_body(sys, bodies, index, last);
+    if (sys->sap) sweep_prune_remove(sys->sap, index, last);
+    sys->pairs.count = 0;
+    sys->contact_count = 0;
+    sys->island_count = 0;
+}
+
+// True if p falls in the half-open cell of the leaf (closed on the root's max faces)
+static bool octree_leaf_owns(const OctreeNode* leaf, Vec3 p, AABB root) {
+    return p.x >= leaf->bounds.min.x && (p.x < leaf->bounds.max.x || leaf->bounds.max.x >= root.max.x) &&
+           p.y >= leaf->bounds.min.y && (p.y < leaf->bounds.max.y || leaf->bounds.max.y >= root.max.y) &&
+           p.z >= leaf->bounds.min.z && (p.z < leaf->bounds.max.z || leaf->bounds.max.z >= root.max.z);
+}
+
+/*
+ * A pair overlapping several leaves is seen in each of them. It is emitted
+ * only by the leaf owning the min corner of the two proxies' intersection,
+ * which both bodies are guaranteed to be listed in.
+ */
+static void collision_gather_leaf_pairs(OctreeNode* leaf, void* user) {
+    CollisionSystem* sys = user;
+
+    for (int i = 0; i < leaf->body_count; i++) {
+        int ia = leaf->bodies[i];
+        AABB a = sys->proxies[ia];
+        for (int j = i + 1; j < leaf->body_count; j++) {
+            int ib = leaf->bodies[j];
+            AABB b = sys->proxies[ib];
+            if (!aabb_overlap(a, b)) continue;
+
+            Vec3 corner = { fmaxf(a.min.x, b.min.x), fmaxf(a.min.y, b.min.y), fmaxf(a.min.z, b.min.z) };
+            if (!octree_leaf_owns(leaf, vec3_clamp_box(corner, sys->world_bounds), sys->world_bounds)) continue;
+
+            pair_list_push(&sys->pairs, ia, ib);
+        }
+    }
+}
+
+static void collision_find_pairs_brute_force(CollisionSystem* sys, const BodyStore* bodies) {
+    int count = bodies->count;
+    for (int i = 0; i < count; i++) {
+        AABB a = aabb_from_sphere(bodies->position[i], bodies->radius[i]);
+        for (int j = i + 1; j < count; j++) {
+            if (aabb_overlap(a, aabb_from_sphere(bodies->position[j], bodies->radius[j]))) {
+                pair_list_push(&sys->pairs, i, j);
+            }
+        }
+    }
+}
+
+// A broad phase that cannot allocate its structure falls back to brute
+// force for the frame
+void collision_system_find_pairs(CollisionSystem* sys, const BodyStore* bodies) {
+    int count = bodies->count;
+    sys->pairs.count = 0;
+
+    switch (sys->broadphase) {
+        case BROADPHASE_BRUTE_FORCE:
+            collision_find_pairs_brute_force(sys, bodies);
+            break;
+
+        case BROADPHASE_OCTREE:
+            if (!collision_refit_octree(sys, bodies)) {
+                collision_find_pairs_brute_force(sys, bodies);
+                break;
+            }
+            octree_for_each_leaf(sys->octree, collision_gather_leaf_pairs, sys);
+            break;
+
+        case BROADPHASE_GRID:
+            if (!sys->grid && (sys->grid = mem_malloc(sizeof(SpatialHash)))) spatial_hash_init(sys->grid);
+            if (!sys->grid || !spatial_hash_build(sys->grid, bodies->position, bodies->radius, count, sys->grid_cell_size)) {
+                collision_find_pairs_brute_force(sys, bodies);
+                break;
+            }
+            spatial_hash_find_pairs(sys->grid, &sys->pairs);
+            break;
+
+        case BROADPHASE_SAP:
+            if (!sys->sap && (sys->sap = mem_malloc(sizeof(SweepPrune)))) sweep_prune_init(sys->sap);
+            if (!sys->sap || !sweep_prune_update(sys->sap, bodies->position, bodies->radius, count)) {
+                collision_find_pairs_brute_force(sys, bodies);
+                break;
+            }
+            for (int i = 0; i < sys->sap->pair_count; i++) {
+                pair_list_push(&sys->pairs, sys->sap->pairs[i].a, sys->sap->pairs[i].b);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// ============================================================================
+// CONTINUOUS COLLISION
+// ============================================================================
+
+/*
+ * collision_sphere_toi
+ * Spheres moving linearly over the step, x⃗(t) = p⃗ + t d⃗. With the relative
+ * start p⃗ = p⃗_A - p⃗_B and motion m⃗ = d⃗_A - d⃗_B they touch when
+ *   ‖p⃗ + t m⃗‖² = R²  ⇔  (m⃗ ⋅ m⃗) t² + 2 (p⃗ ⋅ m⃗) t + (p⃗ ⋅ p⃗ - R²) = 0
+ * and the first contact is the smaller root. Spheres have a closed-form
+ * time of impact, so conservative advancement reaches it in one step.
+ */
+bool collision_sphere_toi(Vec3 pa, Vec3 da, Vec3 pb, Vec3 db, float radius_sum, float* toi) {
+    Vec3 p = vec3_sub(pa, pb);
+    Vec3 m = vec3_sub(da, db);
+    float c = vec3_dot(p, p) - radius_sum * radius_sum;
+    if (c <= 0.0f) return false;    // Already overlapping: left to the narrow phase
+    float b = vec3_dot(p, m);
+    if (b >= 0.0f) return false;    // Separating
+    float a = vec3_dot(m, m);
+    float disc = b * b - a * c;
+    if (disc < 0.0f) return false;  // Passing by
+    float t = (-b - sqrtf(disc)) / a;
+    if (t > 1.0f) return false;
+    *toi = t;
+    return true;
+}
+
+/*
+ * Sphere a body is swept as. A box's bounding sphere would stop it where
+ * no corner touches yet, so boxes use their inscribed sphere and stop
+ * slightly inside what they hit instead.
+ */
+static float ccd_radius(const BodyStore* bodies, int i) {
+    if (bodies->shape[i] != SHAPE_BOX) return bodies->radius[i];
+    Vec3 h = bodies->half_extents[i];
+    return fminf(h.x, fminf(h.y, h.z));
+}
+
+// Integration ends with x⃗ += v⃗ Δt, so the start of the step is x⃗ - v⃗ Δt
+static Vec3 ccd_start(const BodyStore* bodies, int i, float dt) {
+    if (bodies->flags[i] & (BODY_FLAG_STATIC | BODY_FLAG_SLEEPING)) return bodies->position[i];
+    return vec3_sub(bodies->position[i], vec3_scale(bodies->velocity[i], dt));
+}
+
+static AABB aabb_swept(Vec3 start, Vec3 end, float radius) {
+    return (AABB){
+        { fminf(start.x, end.x) - radius, fminf(start.y, end.y) - radius, fminf(start.z, end.z) - radius },
+        { fmaxf(start.x, end.x) + radius, fmaxf(start.y, end.y) + radius, fmaxf(start.z, end.z) + radius }
+    };
+}
 
-    // Check if spheres are colliding (using squared distance to avoid sqrt)
-    if (dist_sq < total_radius * total_radius && dist_sq > 1e-9) {
+static int sweep_key_compare(const void* a, const void* b) {
+    float x = ((const SweepKey*)a)->box.min.x, y = ((const SweepKey*)b)->box.min.x;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Boxes around every body's step, and the bodies sorted by box min x.
+ * The order is kept between steps and repaired by insertion sort, which
+ * is close to O(N) while bodies move little; a change in body count
+ * rebuilds it. False if either could not be allocated.
+ */
+static bool collision_sort_sweeps(CollisionSystem* sys, const BodyStore* bodies) {
+    int count = bodies->count;
+    if (count > sys->sweep_capacity) {
+        SweepKey* order = mem_realloc(sys->sweep_order, count * 2 * sizeof(SweepKey));
+        if (!order) return false;
+        sys->sweep_order = order;
+        sys->sweep_capacity = count * 2;
+    }
+    sys->sweep_boxes = frame_arena_alloc(&sys->frame, count * sizeof(AABB));
+    if (!sys->sweep_boxes) return false;
+    sys->sweep_width = 0.0f;
+    for (int i = 0; i < count; i++) {
+        AABB box = aabb_swept(ccd_start(bodies, i, sys->dt), bodies->position[i], bodies->radius[i]);
+        sys->sweep_boxes[i] = box;
+        sys->sweep_width = fmaxf(sys->sweep_width, box.max.x - box.min.x);
+    }
+
+    SweepKey* order = sys->sweep_order;
+    if (sys->sweep_tracked != count) {
+        for (int i = 0; i < count; i++) order[i] = (SweepKey){ sys->sweep_boxes[i], i };
+        qsort(order, count, sizeof(SweepKey), sweep_key_compare);
+        sys->sweep_tracked = count;
+        return true;
+    }
+    for (int k = 0; k < count; k++) order[k].box = sys->sweep_boxes[order[k].body];
+    for (int k = 1; k < count; k++) {
+        SweepKey key = order[k];
+        int m = k - 1;
+        for (; m >= 0 && order[m].box.min.x > key.box.min.x; m--) order[m + 1] = order[m];
+        order[m + 1] = key;
+    }
+    return true;
+}
+
+// First entry of the order with box.min.x >= x
+static int sweep_lower_bound(const SweepKey* order, int count, float x) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (order[mid].box.min.x < x) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void collision_sweep_pair(const CollisionSystem* sys, const BodyStore* bodies, int i, Vec3 start, Vec3 motion,
+                                 int j, float* toi) {
+    Vec3 start_j = ccd_start(bodies, j, sys->dt);
+    Vec3 motion_j = vec3_sub(bodies->position[j], start_j);
+    float t;
+    if (collision_sphere_toi(start, motion, start_j, motion_j, ccd_radius(bodies, i) + ccd_radius(bodies, j), &t) && t < *toi) {
+        *toi = t;
+    }
+}
+
+typedef struct {
+    CollisionSystem* sys;
+    const BodyStore* bodies;
+} SweepJob;
+
+/*
+ * Earliest impact of each swept body against the boundary planes and every
+ * other body, moving along its own step. No box is wider than sweep_width in x,
+ * so only bodies whose box starts that far before the swept one can reach
+ * it. Reads only this step's start and end positions, so the result does
+ * not depend on the order bodies are swept in and ranges can run
+ * concurrently.
+ */
+static void collision_sweep_range(void* user, int begin, int end) {
+    SweepJob* job = user;
+    CollisionSystem* sys = job->sys;
+    const BodyStore* bodies = job->bodies;
+    for (int k = begin; k < end; k++) {
+        int i = sys->swept[k];
+        float r = ccd_radius(bodies, i);
+        Vec3 start = ccd_start(bodies, i, sys->dt);
+        Vec3 motion = vec3_sub(bodies->position[i], start);
+        AABB sweep = sys->sweep_boxes[i];
+        float toi = 1.0f;
+
+        // Planes: n̂ ⋅ (p⃗ + t m⃗) - r = offset
+        for (int p = 0; p < sys->plane_count; p++) {
+            const CollisionPlane* plane = &sys->planes[p];
+            float gap = vec3_dot(plane->normal, start) - r - plane->offset;
+            float closing = vec3_dot(plane->normal, motion);
+            if (gap >= 0.0f && closing < 0.0f && gap < -closing * toi) toi = gap / -closing;
+        }
+        const SweepKey* order = sys->sweep_order;
+        for (int o = sweep_lower_bound(order, sys->sweep_tracked, sweep.min.x - sys->sweep_width);
+             o < sys->sweep_tracked && order[o].box.min.x <= sweep.max.x; o++) {
+            int j = order[o].body;
+            if (j != i && aabb_overlap(sweep, order[o].box)) collision_sweep_pair(sys, bodies, i, start, motion, j, &toi);
+        }
+        sys->swept_toi[k] = toi;
+    }
+}
+
+/*
+ * Continuous collision for bodies that would otherwise step through what
+ * they hit: awake bodies moving more than ccd.motion_threshold of their
+ * radius this step, and bullets (BODY_FLAG_CCD). Each is moved back along
+ * its path to its first impact plus COLLISION_CCD_SKIN, keeping its
+ * velocity, so the narrow phase finds the contact and the solver bounces
+ * it. The rest of the step's motion is dropped.
+ */
+void collision_stage_ccd(CollisionSystem* sys, BodyStore* bodies) {
+    sys->swept_count = 0;
+    sys->ccd_clamped = 0;
+    if (!sys->ccd.enabled || sys->dt <= 0.0f) return;
+
+    float threshold = sys->ccd.motion_threshold / sys->dt;
+    for (int i = 0; i < bodies->count; i++) {
+        uint8_t flags = bodies->flags[i];
+        if (flags & (BODY_FLAG_STATIC | BODY_FLAG_SLEEPING)) continue;
+        float speed_sq = vec3_mag_sq(bodies->velocity[i]);
+        float limit = threshold * bodies->radius[i];
+        if (!(flags & BODY_FLAG_CCD) && speed_sq <= limit * limit) continue;
+        if (speed_sq == 0.0f) continue;
+        if (sys->swept_count == sys->swept_capacity) {
+            // Out of memory, only the bodies found so far are swept
+            int capacity = sys->swept_capacity ? sys->swept_capacity * 2 : 64;
+            int* swept = mem_realloc(sys->swept, capacity * sizeof(int));
+            if (!swept) break;
+            sys->swept = swept;
+            float* toi = mem_realloc(sys->swept_toi, capacity * sizeof(float));
+            if (!toi) break;
+            sys->swept_toi = toi;
+            sys->swept_capacity = capacity;
+        }
+        sys->swept[sys->swept_count++] = i;
+    }
+    if (sys->swept_count == 0) return;
+
+    if (!collision_sort_sweeps(sys, bodies)) {
+        sys->swept_count = 0;
+        return;
+    }
+    SweepJob job = { sys, bodies };
+    thread_pool_parallel_for(sys->pool, 0, sys->swept_count, COLLISION_CCD_GRAIN, collision_sweep_range, &job);
+
+    // Applied after every impact is known, so swept pairs see each other's full path
+    for (int k = 0; k < sys->swept_count; k++) {
+        if (sys->swept_toi[k] >= 1.0f) continue;
+        int i = sys->swept[k];
+        Vec3 start = ccd_start(bodies, i, sys->dt);
+        Vec3 motion = vec3_sub(bodies->position[i], start);
+        float t = fminf(sys->swept_toi[k] + COLLISION_CCD_SKIN / vec3_magnitude(motion), 1.0f);
+        bodies->position[i] = vec3_add(start, vec3_scale(motion, t));
+        sys->ccd_clamped++;
+    }
+}
+
+// ============================================================================
+// CONTACT ISLANDS
+// ============================================================================
+
+static int island_find(int* parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]]; // Path halving
+        i = parent[i];
+    }
+    return i;
+}
+
+// The lower index becomes the root, so islands do not depend on pair order
+static void island_union(int* parent, int a, int b) {
+    a = island_find(parent, a);
+    b = island_find(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+static bool collision_reserve_islands(CollisionSystem* sys, int body_count) {
+    if (body_count <= sys->island_capacity) return true;
+    int capacity = body_count * 2;
+    int* body_island = mem_realloc(sys->body_island, capacity * sizeof(int));
+    if (!body_island) return false;
+    sys->body_island = body_island;
+    // At most one island per dynamic body
+    ContactIsland* islands = mem_realloc(sys->islands, capacity * sizeof(ContactIsland));
+    if (!islands) return false;
+    sys->islands = islands;
+    sys->island_capacity = capacity;
+    return true;
+}
+
+static OrientedBox collision_body_box(const BodyStore* bodies, int i) {
+    return oriented_box_make(bodies->position[i], bodies->orientation[i], bodies->half_extents[i]);
+}
+
+/*
+ * Sphere against boundary plane p. The world is B, so the contact normal
+ * is -n̂ and the contact point is the deepest point of the sphere.
+ */
+static bool collision_detect_plane(const CollisionSystem* sys, const BodyStore* bodies, int a, int p, Contact* contact) {
+    const CollisionPlane* plane = &sys->planes[p];
+    if (bodies->shape[a] == SHAPE_BOX) {
+        OrientedBox box = collision_body_box(bodies, a);
+        if (!box_plane_contact(&box, plane->normal, plane->offset, contact)) return false;
+        contact->a = a;
+        contact->b = CONTACT_WORLD;
+        contact->plane = p;
+        return true;
+    }
+    Vec3 pa = bodies->position[a];
+    float r = bodies->radius[a];
+    float depth = plane->offset - (vec3_dot(plane->normal, pa) - r);
+    if (depth <= 0.0f) return false;
+
+    contact->a = a;
+    contact->b = CONTACT_WORLD;
+    contact->plane = p;
+    contact->normal = vec3_scale(plane->normal, -1.0f);
+    contact->penetration = depth;
+    contact->point = vec3_sub(pa, vec3_scale(plane->normal, r));
+    return true;
+}
+
+// Cache key of a body pair: the handle slots, smaller first
+static void handle_pair_key(BodyHandle ha, BodyHandle hb, uint64_t* key, uint64_t* generations) {
+    if (ha.slot > hb.slot) {
+        BodyHandle t = ha;
+        ha = hb;
+        hb = t;
+    }
+    *key = ((uint64_t)ha.slot << 32) | hb.slot;
+    *generations = ((uint64_t)ha.generation << 32) | hb.generation;
+}
+
+/*
+ * Narrow phase for a pair of any shapes, normal from a to b. Box pairs
+ * start from the axis cached for them last step; the axis they end on is
+ * recorded when store_axis is set (single-threaded callers only).
+ */
+static bool collision_detect_pair(CollisionSystem* sys, const BodyStore* bodies, int a, int b, Contact* c, bool store_axis) {
+    uint8_t sa = bodies->shape[a], sb = bodies->shape[b];
+    if (sa != SHAPE_BOX && sb != SHAPE_BOX) return collision_detect_sphere_sphere(bodies, a, b, c);
+
+    if (sa == SHAPE_BOX && sb == SHAPE_BOX) {
+        uint64_t key, generations;
+        handle_pair_key(body_store_handle(bodies, a), body_store_handle(bodies, b), &key, &generations);
+        const int* cached = pair_cache_find(&sys->axes, key, generations);
+        int hint = cached ? *cached : -1;
+        OrientedBox box_a = collision_body_box(bodies, a), box_b = collision_body_box(bodies, b);
+        int axis;
+        bool touching = box_box_contact(&box_a, &box_b, hint, c, &axis);
+        if (store_axis) {
+            pair_cache_store(&sys->axes, key, generations, &axis);
+            sys->box_pairs++;
+            if (!touching && axis == hint) sys->axis_rejects++;
+        }
+        if (!touching) return false;
+    } else if (sa == SHAPE_BOX) {
+        OrientedBox box = collision_body_box(bodies, a);
+        if (!box_sphere_contact(&box, bodies->position[b], bodies->radius[b], c)) return false;
+    } else {
+        OrientedBox box = collision_body_box(bodies, b);
+        if (!box_sphere_contact(&box, bodies->position[a], bodies->radius[a], c)) return false;
+        c->normal = vec3_scale(c->normal, -1.0f);
+    }
+    c->a = a;
+    c->b = b;
+    return true;
+}
+
+// Storage is kept across frames
+bool collision_system_reserve_contacts(CollisionSystem* sys, int count) {
+    if (count <= sys->contact_capacity) return true;
+    int capacity = count * 2;
+    Contact* contacts = mem_realloc(sys->contacts, capacity * sizeof(Contact));
+    if (!contacts) return false;
+    sys->contacts = contacts;
+    int* island_contacts = mem_realloc(sys->island_contacts, capacity * sizeof(int));
+    if (!island_contacts) return false;
+    sys->island_contacts = island_contacts;
+    sys->contact_capacity = capacity;
+    return true;
+}
+
+void collision_stage_broadphase(CollisionSystem* sys, BodyStore* bodies) {
+    collision_system_find_pairs(sys, bodies);
+}
+
+// Narrow phase over the candidate pairs, without resolving anything yet.
+// Boundary contacts follow, so the solver treats walls like any other
+// support and their impulses are warm started too. Out of memory, contacts
+// past contact_capacity are dropped for the frame.
+void collision_stage_narrowphase(CollisionSystem* sys, BodyStore* bodies) {
+    collision_system_reserve_contacts(sys, sys->pairs.count + bodies->count);
+    int hit_count = sys->pairs.count > bodies->count ? sys->pairs.count : bodies->count;
+    sys->pair_hit = frame_arena_alloc(&sys->frame, hit_count);
+    sys->contact_count = 0;
+    if (!sys->pair_hit) return;
+
+    // Most broad-phase candidates only share a cell or an AABB overlap;
+    // reject them with a bounding-sphere test before the narrow phase. The
+    // pairs index bodies at random, so this stays scalar: the gathers of
+    // sphere_batch_overlap cost more than its lanes save (bench --simd).
+    // Box pairs that pass are the ones that reach SAT and the axis cache.
+    int box_pairs = 0;
+    for (int i = 0; i < sys->pairs.count; i++) {
+        int a = sys->pairs.pairs[i].a;
+        int b = sys->pairs.pairs[i].b;
+        Vec3 pa = bodies->position[a], pb = bodies->position[b];
+        float dx = pb.x - pa.x, dy = pb.y - pa.y, dz = pb.z - pa.z;
+        float r = bodies->radius[a] + bodies->radius[b];
+        bool hit = dx * dx + dy * dy + dz * dz < r * r;
+        sys->pair_hit[i] = hit;
+        box_pairs += hit && bodies->shape[a] == SHAPE_BOX && bodies->shape[b] == SHAPE_BOX;
+    }
+    pair_cache_begin(&sys->axes, box_pairs);
+    sys->box_pairs = 0;
+    sys->axis_rejects = 0;
+
+    int count = 0;
+    for (int i = 0; i < sys->pairs.count && count < sys->contact_capacity; i++) {
+        if (!sys->pair_hit[i]) continue;
+        int a = sys->pairs.pairs[i].a;
+        int b = sys->pairs.pairs[i].b;
+        // Needs at least one awake dynamic body; sleeping groups stay frozen
+        // until an awake body touches them
+        const uint8_t inactive = BODY_FLAG_STATIC | BODY_FLAG_SLEEPING;
+        if ((bodies->flags[a] & inactive) && (bodies->flags[b] & inactive)) continue;
+        Contact* c = &sys->contacts[count];
+        if (!collision_detect_pair(sys, bodies, a, b, c, true)) continue;
+        c->normal_impulse = 0.0f;
+        c->tangent_impulse[0] = c->tangent_impulse[1] = 0.0f;
+        c->tangent[0] = c->tangent[1] = vec3_zero();
+        c->rolling_impulse = vec3_zero();
+        count++;
+    }
+
+    // One branch-free pass per plane over every body (pair_hit is free again and
+    // holds a flag per body); most bodies are inside, so few reach the loop
+    for (int p = 0; p < sys->plane_count; p++) {
+        const CollisionPlane* plane = &sys->planes[p];
+        int hits = sphere_batch_plane(bodies->position, bodies->radius, bodies->count,
+                                      plane->normal, plane->offset, sys->pair_hit);
+        if (hits == 0) continue;
+        collision_system_reserve_contacts(sys, count + hits);
+        for (int i = 0; i < bodies->count && count < sys->contact_capacity; i++) {
+            if (!sys->pair_hit[i] || (bodies->flags[i] & (BODY_FLAG_STATIC | BODY_FLAG_SLEEPING))) continue;
+            Contact* c = &sys->contacts[count];
+            if (!collision_detect_plane(sys, bodies, i, p, c)) continue;
+            c->normal_impulse = 0.0f;
+            c->tangent_impulse[0] = c->tangent_impulse[1] = 0.0f;
+            c->tangent[0] = c->tangent[1] = vec3_zero();
+            c->rolling_impulse = vec3_zero();
+            count++;
+        }
+    }
+    sys->contact_count = count;
+}
+
+/*
+ * Union-find over the contact graph. Island ids follow the order in which
+ * islands are first touched by the contact list, and contacts keep their
+ * list order inside an island (counting sort), so the solve order is fixed
+ * for a given contact list.
+ */
+static bool collision_build_islands(CollisionSystem* sys, const BodyStore* bodies) {
+    if (!collision_reserve_islands(sys, bodies->count)) return false;
+    sys->island_parent = frame_arena_alloc(&sys->frame, bodies->count * sizeof(int));
+    sys->contact_island = frame_arena_alloc(&sys->frame, sys->contact_count * sizeof(int));
+    if (!sys->island_parent || !sys->contact_island) return false;
+    int* parent = sys->island_parent;
+    int* body_island = sys->body_island;
+    const Contact* contacts = sys->contacts;
+
+    for (int i = 0; i < bodies->count; i++) {
+        parent[i] = i;
+        body_island[i] = -1;
+    }
+    sys->island_body_count = bodies->count;
+    for (int c = 0; c < sys->contact_count; c++) {
+        int a = contacts[c].a, b = contacts[c].b;
+        if (b == CONTACT_WORLD) continue;
+        if (!(bodies->flags[a] & BODY_FLAG_STATIC) && !(bodies->flags[b] & BODY_FLAG_STATIC)) {
+            island_union(parent, a, b);
+        }
+    }
+
+    // Flatten, so every body points straight at its root. A root that has
+    // been given an island stores it as parent = -(id + 1).
+    for (int i = 0; i < bodies->count; i++) parent[i] = island_find(parent, i);
+
+    // Number islands
+    sys->island_count = 0;
+    sys->largest_island = 0;
+    for (int c = 0; c < sys->contact_count; c++) {
+        int a = contacts[c].a, b = contacts[c].b;
+        int x = (bodies->flags[a] & BODY_FLAG_STATIC) ? b : a;
+        int root = parent[x] < 0 ? x : parent[x];
+        if (parent[root] == root) {
+            parent[root] = -(sys->island_count + 1);
+            sys->islands[sys->island_count++] = (ContactIsland){ 0, 0, 0, 0, 0.0f, UINT32_MAX };
+        }
+        int id = -parent[root] - 1;
+        ContactIsland* island = &sys->islands[id];
+        island->contact_count++;
+        sys->contact_island[c] = id;
+
+        int ends[2] = { a, b };
+        for (int e = 0; e < 2; e++) {
+            int body = ends[e];
+            if (body == CONTACT_WORLD) continue;
+            if ((bodies->flags[body] & BODY_FLAG_STATIC) || body_island[body] >= 0) continue;
+            body_island[body] = id;
+            island->body_count++;
+            if (!(bodies->flags[body] & BODY_FLAG_SLEEPING)) island->awake_count++;
+        }
+    }
+
+    // Prefix sums, then a stable scatter of contact indices
+    int offset = 0;
+    for (int k = 0; k < sys->island_count; k++) {
+        ContactIsland* island = &sys->islands[k];
+        island->first_contact = offset;
+        offset += island->contact_count;
+        island->contact_count = 0;
+        if (island->body_count > sys->largest_island) sys->largest_island = island->body_count;
+    }
+    for (int c = 0; c < sys->contact_count; c++) {
+        ContactIsland* island = &sys->islands[sys->contact_island[c]];
+        sys->island_contacts[island->first_contact + island->contact_count++] = c;
+    }
+    return true;
+}
+
+/*
+ * Contacts only form around awake bodies, so a sleeping body in an island
+ * is being touched by an awake one. It wakes, and with it every body of the
+ * sleep group it fell asleep with.
+ */
+static void collision_wake_islands(CollisionSystem* sys, BodyStore* bodies) {
+    int woken = 0;
+    sys->wake_mark = NULL;
+    sys->wake_mark_capacity = 0;
+    for (int i = 0; i < bodies->count; i++) {
+        if (sys->body_island[i] < 0 || !(bodies->flags[i] & BODY_FLAG_SLEEPING)) continue;
+
+        uint32_t group = bodies->sleep_group[i];
+        if (!sys->wake_mark && group != UINT32_MAX) {
+            // Groups are handle slots
+            sys->wake_mark_capacity = bodies->slot_count;
+            sys->wake_mark = frame_arena_alloc(&sys->frame, sys->wake_mark_capacity);
+            if (sys->wake_mark) memset(sys->wake_mark, 0, sys->wake_mark_capacity);
+            else sys->wake_mark_capacity = 0;
+        }
+        if (group < (uint32_t)sys->wake_mark_capacity) {
+            sys->wake_mark[group] = 1;
+            woken++;
+        }
+        body_store_wake(bodies, i);
+        sys->islands[sys->body_island[i]].awake_count++;
+    }
+    if (woken == 0) return;
+
+    for (int i = 0; i < bodies->count; i++) {
+        if (!(bodies->flags[i] & BODY_FLAG_SLEEPING)) continue;
+        uint32_t group = bodies->sleep_group[i];
+        if (group < (uint32_t)sys->wake_mark_capacity && sys->wake_mark[group]) body_store_wake(bodies, i);
+    }
+}
+
+// Contacts that cannot be grouped into islands are dropped for the frame
+void collision_stage_islands(CollisionSystem* sys, BodyStore* bodies) {
+    if (!collision_build_islands(sys, bodies)) {
+        sys->contact_count = 0;
+        sys->island_count = 0;
+        sys->island_body_count = 0;
+        return;
+    }
+    collision_wake_islands(sys, bodies);
+}
+
+/*
+ * Islands sleep as a unit: once the least rested body has been below the
+ * thresholds for time_to_sleep, all of them are deactivated together.
+ * Bodies without contacts decide on their own.
+ */
+static int collision_island_of(const CollisionSystem* sys, int body) {
+    return body < sys->island_body_count ? sys->body_island[body] : -1;
+}
+
+int collision_system_update_sleep(CollisionSystem* sys, BodyStore* bodies, float time_to_sleep) {
+    for (int k = 0; k < sys->island_count; k++) {
+        sys->islands[k].rest_time = time_to_sleep;
+        sys->islands[k].sleep_group = UINT32_MAX;
+    }
+    for (int i = 0; i < bodies->count; i++) {
+        int id = collision_island_of(sys, i);
+        if (id < 0) continue;
+        ContactIsland* island = &sys->islands[id];
+        if (bodies->sleep_timer[i] < island->rest_time) island->rest_time = bodies->sleep_timer[i];
+        if (island->sleep_group == UINT32_MAX) island->sleep_group = bodies->slot[i];
+    }
+
+    int sleeping = 0;
+    for (int i = 0; i < bodies->count; i++) {
+        uint8_t flags = bodies->flags[i];
+        if (flags & BODY_FLAG_STATIC) continue;
+        if (!(flags & BODY_FLAG_SLEEPING)) {
+            int id = collision_island_of(sys, i);
+            float rest = id >= 0 ? sys->islands[id].rest_time : bodies->sleep_timer[i];
+            if (rest < time_to_sleep) continue;
+
+            bodies->flags[i] = flags | BODY_FLAG_SLEEPING;
+            bodies->sleep_group[i] = id >= 0 ? sys->islands[id].sleep_group : bodies->slot[i];
+            bodies->velocity[i] = vec3_zero();
+            bodies->angular_velocity[i] = vec3_zero();
+            bodies->force_accumulator[i] = vec3_zero();
+            bodies->torque_accumulator[i] = vec3_zero();
+        }
+        sleeping++;
+    }
+    return sleeping;
+}
+
+// ============================================================================
+// SEQUENTIAL IMPULSE SOLVER
+// ============================================================================
+
+// Cache key of a contact. Boundary plane p takes slot UINT32_MAX - p,
+// which no body handle reaches.
+static void contact_key(const BodyStore* bodies, const Contact* c, uint64_t* key, uint64_t* generations) {
+    BodyHandle hb = c->b != CONTACT_WORLD ? body_store_handle(bodies, c->b) : (BodyHandle){ UINT32_MAX - (uint32_t)c->plane, 0 };
+    handle_pair_key(body_store_handle(bodies, c->a), hb, key, generations);
+}
+
+// Fixed unit vector ⊥ n̂, so friction directions do not flicker between steps
+static Vec3 contact_tangent(Vec3 n) {
+    if (fabsf(n.x) >= 0.57735f) return vec3_normalize((Vec3){ n.y, -n.x, 0.0f });
+    return vec3_normalize((Vec3){ 0.0f, n.z, -n.y });
+}
+
+/*
+ * Relative velocity of the contact points along constraint direction k
+ * (0 = n̂, 1-2 = t̂), from the precomputed Jacobian:
+ *   (v⃗_B - v⃗_A) ⋅ d̂ + ω⃗_B ⋅ (r⃗_B ∧ d̂) - ω⃗_A ⋅ (r⃗_A ∧ d̂)
+ */
+static float contact_axis_velocity(const BodyStore* bodies, const Contact* c, Vec3 d, int k) {
+    float v = -vec3_dot(bodies->velocity[c->a], d) - vec3_dot(bodies->angular_velocity[c->a], c->angular_a[k]);
+    if (c->b != CONTACT_WORLD) {
+        v += vec3_dot(bodies->velocity[c->b], d) + vec3_dot(bodies->angular_velocity[c->b], c->angular_b[k]);
+    }
+    return v;
+}
+
+// λd̂ is applied to B and -λd̂ to A at the contact point; static bodies are never written
+static void contact_apply_axis(BodyStore* bodies, const Contact* c, Vec3 d, int k, float lambda) {
+    if (c->inv_mass_a > 0.0f) {
+        int a = c->a;
+        bodies->velocity[a] = vec3_sub(bodies->velocity[a], vec3_scale(d, lambda * c->inv_mass_a));
+        bodies->angular_velocity[a] = vec3_sub(bodies->angular_velocity[a], vec3_scale(c->response_a[k], lambda));
+    }
+    if (c->inv_mass_b > 0.0f) {
+        int b = c->b;
+        bodies->velocity[b] = vec3_add(bodies->velocity[b], vec3_scale(d, lambda * c->inv_mass_b));
+        bodies->angular_velocity[b] = vec3_add(bodies->angular_velocity[b], vec3_scale(c->response_b[k], lambda));
+    }
+}
+
+/*
+ * Jacobian terms of direction k, then the effective mass
+ *   1 / (d̂ ⋅ K d̂),  d̂ ⋅ K d̂ = 1/m_A + 1/m_B + (r⃗_A ∧ d̂) ⋅ I⁻¹_A (r⃗_A ∧ d̂) + (r⃗_B ∧ d̂) ⋅ I⁻¹_B (r⃗_B ∧ d̂)
+ */
+static float contact_prepare_axis(const BodyStore* bodies, Contact* c, Vec3 d, int k) {
+    c->angular_a[k] = vec3_cross(c->ra, d);
+    c->response_a[k] = c->inv_mass_a > 0.0f ? mat3_mul_vec(bodies->inv_inertia_world[c->a], c->angular_a[k]) : vec3_zero();
+    float m = c->inv_mass_a + vec3_dot(c->angular_a[k], c->response_a[k]);
+    if (c->b != CONTACT_WORLD) {
+        c->angular_b[k] = vec3_cross(c->rb, d);
+        c->response_b[k] = c->inv_mass_b > 0.0f ? mat3_mul_vec(bodies->inv_inertia_world[c->b], c->angular_b[k]) : vec3_zero();
+        m += c->inv_mass_b + vec3_dot(c->angular_b[k], c->response_b[k]);
+    } else {
+        c->angular_b[k] = c->response_b[k] = vec3_zero();
+    }
+    return m > 0.0f ? 1.0f / m : 0.0f;
+}
+
+// Precomputes the constraint frame and restitution target of a contact
+static void contact_prepare(const BodyStore* bodies, Contact* c) {
+    int a = c->a, b = c->b;
+    bool world = b == CONTACT_WORLD;
+    c->ra = vec3_sub(c->point, bodies->position[a]);
+    c->rb = world ? vec3_zero() : vec3_sub(c->point, bodies->position[b]);
+    c->inv_mass_a = bodies->inv_mass[a];
+    c->inv_mass_b = world ? 0.0f : bodies->inv_mass[b];
+    c->tangent[0] = contact_tangent(c->normal);
+    c->tangent[1] = vec3_cross(c->normal, c->tangent[0]);
+    c->normal_mass = contact_prepare_axis(bodies, c, c->normal, 0);
+    c->tangent_mass[0] = contact_prepare_axis(bodies, c, c->tangent[0], 1);
+    c->tangent_mass[1] = contact_prepare_axis(bodies, c, c->tangent[1], 2);
+    // Boundaries take on the material of whatever touches them
+    c->friction = world ? bodies->friction[a] : sqrtf(bodies->friction[a] * bodies->friction[b]);
+    float r = world ? bodies->radius[a] : fminf(bodies->radius[a], bodies->radius[b]);
+    c->rolling = COLLISION_ROLLING_RESISTANCE * r;
+
+    // Bounce only off real impacts; resting contacts aim for zero approach speed
+    float vn = contact_axis_velocity(bodies, c, c->normal, 0);
+    float e = world ? bodies->restitution[a] : fminf(bodies->restitution[a], bodies->restitution[b]);
+    c->velocity_bias = vn < -COLLISION_RESTITUTION_THRESHOLD ? -e * vn : 0.0f;
+
+    c->normal_impulse = 0.0f;
+    c->tangent_impulse[0] = c->tangent_impulse[1] = 0.0f;
+    c->rolling_impulse = vec3_zero();
+}
+
+/*
+ * Re-applies the impulses the pair ended the last step with. The cached
+ * friction impulse is stored in world space and projected onto this step's
+ * tangents, so it survives a slowly turning normal.
+ */
+static void contact_warm_start(BodyStore* bodies, const PairCache* cache, Contact* c) {
+    uint64_t key, generations;
+    contact_key(bodies, c, &key, &generations);
+    const ContactImpulse* cached = pair_cache_find(cache, key, generations);
+    if (!cached) return;
+    c->normal_impulse = cached->normal_impulse;
+    c->tangent_impulse[0] = vec3_dot(cached->friction_impulse, c->tangent[0]);
+    c->tangent_impulse[1] = vec3_dot(cached->friction_impulse, c->tangent[1]);
+    contact_apply_axis(bodies, c, c->normal, 0, c->normal_impulse);
+    contact_apply_axis(bodies, c, c->tangent[0], 1, c->tangent_impulse[0]);
+    contact_apply_axis(bodies, c, c->tangent[1], 2, c->tangent_impulse[1]);
+}
+
+/*
+ * Rolling resistance: an angular impulse against ω⃗_B - ω⃗_A. Sliding
+ * friction cannot stop a rolling sphere, so without it piles keep rolling
+ * apart instead of coming to rest.
+ */
+static void contact_solve_rolling(BodyStore* bodies, Contact* c) {
+    int a = c->a, b = c->b;
+    bool world = b == CONTACT_WORLD;
+    Vec3 w = vec3_scale(bodies->angular_velocity[a], -1.0f);
+    if (!world) w = vec3_add(w, bodies->angular_velocity[b]);
+    float speed = vec3_magnitude(w);
+    if (speed < 1e-6f) return;
+
+    Vec3 d = vec3_scale(w, 1.0f / speed);
+    float k = vec3_dot(d, mat3_mul_vec(bodies->inv_inertia_world[a], d));
+    if (!world) k += vec3_dot(d, mat3_mul_vec(bodies->inv_inertia_world[b], d));
+    if (k <= 0.0f) return;
+
+    Vec3 old = c->rolling_impulse;
+    Vec3 impulse = vec3_sub(old, vec3_scale(d, speed / k));
+    float max_rolling = c->rolling * c->normal_impulse;
+    float mag = vec3_magnitude(impulse);
+    if (mag > max_rolling) impulse = vec3_scale(impulse, max_rolling / mag);
+    c->rolling_impulse = impulse;
+
+    Vec3 delta = vec3_sub(impulse, old);
+    if (c->inv_mass_a > 0.0f) {
+        bodies->angular_velocity[a] = vec3_sub(bodies->angular_velocity[a],
+            mat3_mul_vec(bodies->inv_inertia_world[a], delta));
+    }
+    if (c->inv_mass_b > 0.0f) {
+        bodies->angular_velocity[b] = vec3_add(bodies->angular_velocity[b],
+            mat3_mul_vec(bodies->inv_inertia_world[b], delta));
+    }
+}
+
+/*
+ * One velocity pass over a contact. Accumulated impulses are clamped, not
+ * the per-pass increments, so later passes can take back what earlier ones
+ * overshot:
+ *   λ_n ← max(λ_n + m_n (b - v⃗ᵣₑₗ ⋅ n̂), 0)
+ *   λ_t ← clamp(λ_t - m_t (v⃗ᵣₑₗ ⋅ t̂), -μλ_n, μλ_n)
+ * Friction goes first so the normal impulse has the last word on
+ * penetration.
+ */
+static void contact_solve_velocity(BodyStore* bodies, Contact* c) {
+    contact_solve_rolling(bodies, c);
+
+    float max_friction = c->friction * c->normal_impulse;
+    for (int t = 0; t < 2; t++) {
+        float vt = contact_axis_velocity(bodies, c, c->tangent[t], t + 1);
+        float old = c->tangent_impulse[t];
+        c->tangent_impulse[t] = fminf(fmaxf(old - c->tangent_mass[t] * vt, -max_friction), max_friction);
+        contact_apply_axis(bodies, c, c->tangent[t], t + 1, c->tangent_impulse[t] - old);
+    }
+
+    float vn = contact_axis_velocity(bodies, c, c->normal, 0);
+    float old = c->normal_impulse;
+    c->normal_impulse = fmaxf(old + c->normal_mass * (c->velocity_bias - vn), 0.0f);
+    contact_apply_axis(bodies, c, c->normal, 0, c->normal_impulse - old);
+}
+
+typedef struct {
+    CollisionSystem* sys;
+    BodyStore* bodies;
+} IslandSolveJob;
+
+/*
+ * Islands share no dynamic body, so each range can be solved on its own
+ * thread. Per island: prepare every contact, warm start, run the
+ * velocity passes, then push overlapping bodies apart with contacts
+ * refreshed against the current positions.
+ */
+static void collision_solve_islands(void* user, int begin, int end) {
+    IslandSolveJob* job = user;
+    CollisionSystem* sys = job->sys;
+    BodyStore* bodies = job->bodies;
+    const ContactSolverSettings* settings = &sys->solver;
+    for (int k = begin; k < end; k++) {
+        const ContactIsland* island = &sys->islands[k];
+        if (island->awake_count == 0) continue;
+        const int* members = &sys->island_contacts[island->first_contact];
+
+        // Every restitution target is taken before any impulse is applied
+        for (int i = 0; i < island->contact_count; i++) {
+            contact_prepare(bodies, &sys->contacts[members[i]]);
+        }
+        if (settings->warm_start) {
+            for (int i = 0; i < island->contact_count; i++) {
+                contact_warm_start(bodies, &sys->cache, &sys->contacts[members[i]]);
+            }
+        }
+        for (int pass = 0; pass < settings->iterations; pass++) {
+            for (int i = 0; i < island->contact_count; i++) {
+                contact_solve_velocity(bodies, &sys->contacts[members[i]]);
+            }
+        }
+        for (int i = 0; i < island->contact_count; i++) {
+            const Contact* found = &sys->contacts[members[i]];
+            Contact c;
+            bool touching = found->b == CONTACT_WORLD
+                ? collision_detect_plane(sys, bodies, found->a, found->plane, &c)
+                : collision_detect_pair(sys, bodies, found->a, found->b, &c, false);
+            if (touching) collision_project(bodies, &c);
+        }
+    }
+}
+
+// Records this step's impulses for warm starting the next
+static void collision_cache_impulses(CollisionSystem* sys, const BodyStore* bodies) {
+    sys->warm_started = 0;
+    for (int i = 0; i < sys->contact_count; i++) {
+        const Contact* c = &sys->contacts[i];
+        uint64_t key, generations;
+        contact_key(bodies, c, &key, &generations);
+        if (sys->solver.warm_start && pair_cache_find(&sys->cache, key, generations)) sys->warm_started++;
+        ContactImpulse impulse = { c->normal_impulse, vec3_add(vec3_scale(c->tangent[0], c->tangent_impulse[0]),
+                                                               vec3_scale(c->tangent[1], c->tangent_impulse[1])) };
+        pair_cache_store(&sys->cache, key, generations, &impulse);
+    }
+}
+
+// Sequential impulse solve, island by island (concurrently when a thread
+// pool is attached)
+void collision_stage_solve(CollisionSystem* sys, BodyStore* bodies) {
+    // Last step's impulses become the lookup table for this one. Room for
+    // a contact per body at least, so a scene settling into more contacts
+    // does not regrow the tables.
+    int expected = sys->contact_count > bodies->count ? sys->contact_count : bodies->count;
+    pair_cache_begin(&sys->cache, expected);
+    IslandSolveJob job = { sys, bodies };
+    thread_pool_parallel_for(sys->pool, 0, sys->island_count, COLLISION_ISLAND_GRAIN, collision_solve_islands, &job);
+    collision_cache_impulses(sys, bodies);
+}
+
+// ============================================================================
+// PARTICLES
+// ============================================================================
+
+typedef struct {
+    const CollisionSystem* sys;
+    const BodyStore* bodies;
+    ParticleStore* particles;
+    ParticleCollisionSettings settings;
+    const OctreeNode* octree;   // NULL: candidates come from sys->grid
+    float mask_scale;           // Mask cells per unit length
+    atomic_int tests;
+    atomic_int hits;
+} ParticleCollideJob;
+
+// v⃗ relative to a surface moving at surface_v, with n̂ out of the surface
+static Vec3 particle_bounce(Vec3 v, Vec3 surface_v, Vec3 n, const ParticleCollisionSettings* s) {
+    Vec3 rel = vec3_sub(v, surface_v);
+    float vn = vec3_dot(rel, n);
+    if (vn >= 0.0f) return v;
+    Vec3 tangent = vec3_sub(rel, vec3_scale(n, vn));
+    rel = vec3_sub(vec3_scale(tangent, 1.0f - s->friction), vec3_scale(n, s->restitution * vn));
+    return vec3_add(surface_v, rel);
+}
+
+// Cell of the particle mask holding p; points outside fall in the border cells
+static int particle_mask_cell(float p, float min, float scale) {
+    int c = (int)((p - min) * scale);
+    return c < 0 ? 0 : (c >= COLLISION_PARTICLE_MASK ? COLLISION_PARTICLE_MASK - 1 : c);
+}
+
+// Marks every mask cell a body's bounding box touches
+static void particle_mask_build(CollisionSystem* sys, const BodyStore* bodies, float scale) {
+    memset(sys->particle_mask, 0, sizeof(sys->particle_mask));
+    Vec3 min = sys->world_bounds.min;
+    for (int i = 0; i < bodies->count; i++) {
+        AABB box = aabb_from_sphere(bodies->position[i], bodies->radius[i]);
+        int x0 = particle_mask_cell(box.min.x, min.x, scale), x1 = particle_mask_cell(box.max.x, min.x, scale);
+        int y0 = particle_mask_cell(box.min.y, min.y, scale), y1 = particle_mask_cell(box.max.y, min.y, scale);
+        int z0 = particle_mask_cell(box.min.z, min.z, scale), z1 = particle_mask_cell(box.max.z, min.z, scale);
+        uint32_t bits = (uint32_t)((2ull << x1) - (1ull << x0)); // Bits x0..x1
+        for (int z = z0; z <= z1; z++) {
+            for (int y = y0; y <= y1; y++) sys->particle_mask[z][y] |= bits;
+        }
+    }
+}
+
+// Puts a particle inside body j back on its surface; false if outside
+static bool particle_collide_body(const BodyStore* bodies, int j, Vec3* x, Vec3* v, const ParticleCollisionSettings* s) {
+    Vec3 d = vec3_sub(*x, bodies->position[j]);
+    float r = bodies->radius[j];
+    float dist_sq = vec3_mag_sq(d);
+    if (dist_sq >= r * r) return false;
+
+    Vec3 n;
+    if (bodies->shape[j] == SHAPE_BOX) {
+        // A zero-radius sphere only touches a box from inside
+        OrientedBox box = collision_body_box(bodies, j);
+        Contact c;
+        if (!box_sphere_contact(&box, *x, 0.0f, &c)) return false;
+        n = c.normal;
+        *x = c.point;
+    } else {
         float dist = sqrtf(dist_sq);
-        Vec3 normal = vec3_scale(axis, 1.0f / dist);
-
-        // --- Positional Correction (to prevent overlap) ---
-        float overlap = total_radius - dist;
-        float mass_ratio1 = obj1->mass / (obj1->mass + obj2->mass);
-        float mass_ratio2 = obj2->mass / (obj1->mass + obj2->mass);
-        obj1->position = vec3_add(obj1->position, vec3_scale(normal, overlap * mass_ratio2));
-        obj2->position = vec3_sub(obj2->position, vec3_scale(normal, overlap * mass_ratio1));
-
-
-        // --- Impulse Resolution ---
-        Vec3 rel_vel = vec3_sub(obj1->velocity, obj2->velocity);
-        float vel_along_normal = vec3_dot(rel_vel, normal);
-
-        // Do not resolve if velocities are separating
-        if (vel_along_normal > 0) return;
-
-        // For elastic collision, coefficient of restitution ε = 1.
-        // We can simplify the general formula for our case.
-        float inv_mass1 = 1.0f / obj1->mass;
-        float inv_mass2 = 1.0f / obj2->mass;
-        
-        float impulse_j = -2.0f * vel_along_normal / (inv_mass1 + inv_mass2);
-        Vec3 impulse_vec = vec3_scale(normal, impulse_j);
-        
-        obj1->velocity = vec3_add(obj1->velocity, vec3_scale(impulse_vec, inv_mass1));
-        obj2->velocity = vec3_sub(obj2->velocity, vec3_scale(impulse_vec, inv_mass2));
-    }
-}
\ No newline at end of file
+        n = dist > 1e-6f ? vec3_scale(d, 1.0f / dist) : (Vec3){ 0, 1, 0 };
+        *x = vec3_add(bodies->position[j], vec3_scale(n, r));
+    }
+    *v = particle_bounce(*v, bodies->velocity[j], n, s);
+    return true;
+}
+
+static void particle_collide_range(void* user, int begin, int end) {
+    ParticleCollideJob* job = user;
+    const CollisionSystem* sys = job->sys;
+    const BodyStore* bodies = job->bodies;
+    const ParticleCollisionSettings* s = &job->settings;
+    Vec3* position = job->particles->position;
+    Vec3* velocity = job->particles->velocity;
+    int candidates[COLLISION_PARTICLE_CANDIDATES];
+    int tests = 0, hits = 0;
+    const OctreeNode* leaf = NULL;
+
+    for (int i = begin; i < end; i++) {
+        Vec3 x = position[i], v = velocity[i];
+        bool hit = false;
+
+        for (int p = 0; p < sys->plane_count; p++) {
+            const CollisionPlane* plane = &sys->planes[p];
+            Vec3 n = plane->normal;
+            float depth = plane->offset - (n.x * x.x + n.y * x.y + n.z * x.z);
+            if (depth <= 0.0f) continue;
+            x = vec3_add(x, vec3_scale(plane->normal, depth));
+            v = particle_bounce(v, vec3_zero(), plane->normal, s);
+            hit = true;
+        }
+
+        // Most particles are nowhere near a body
+        Vec3 min = sys->world_bounds.min;
+        int mx = particle_mask_cell(x.x, min.x, job->mask_scale);
+        int my = particle_mask_cell(x.y, min.y, job->mask_scale);
+        int mz = particle_mask_cell(x.z, min.z, job->mask_scale);
+        const int* near = NULL;
+        int count = 0;
+        if (!((sys->particle_mask[mz][my] >> mx) & 1u)) {
+            // No candidates
+        } else if (job->octree) {
+            // Neighbouring particles often share a leaf
+            if (!leaf || !aabb_contains_point(leaf->bounds, x)) leaf = octree_find_leaf(job->octree, x);
+            near = leaf ? leaf->bodies : NULL;
+            count = leaf ? leaf->body_count : 0;
+        } else {
+            near = candidates;
+            count = spatial_hash_query_point(sys->grid, x, candidates, COLLISION_PARTICLE_CANDIDATES);
+        }
+        tests += count;
+        for (int k = 0; k < count; k++) hit |= particle_collide_body(bodies, near[k], &x, &v, s);
+
+        if (!hit) continue;
+        position[i] = x;
+        velocity[i] = v;
+        hits++;
+    }
+    atomic_fetch_add_explicit(&job->tests, tests, memory_order_relaxed);
+    atomic_fetch_add_explicit(&job->hits, hits, memory_order_relaxed);
+}
+
+/*
+ * collision_system_collide_particles
+ * Each particle looks up only the bodies the broad phase already grouped
+ * around it: one descent to its octree leaf, or the 8 grid cells nearest
+ * it. Particles do not affect each other, so ranges run concurrently.
+ */
+void collision_system_collide_particles(CollisionSystem* sys, const BodyStore* bodies, ParticleStore* particles,
+                                        const ParticleCollisionSettings* settings) {
+    sys->particle_tests = 0;
+    sys->particle_hits = 0;
+    if (!settings->enabled || particles->count == 0) return;
+
+    const OctreeNode* octree = NULL;
+    if (sys->broadphase == BROADPHASE_OCTREE && sys->octree) {
+        octree = sys->octree;
+    } else if (sys->broadphase != BROADPHASE_GRID || !sys->grid) {
+        if (!sys->grid && (sys->grid = mem_malloc(sizeof(SpatialHash)))) spatial_hash_init(sys->grid);
+        if (!sys->grid) return;
+        // A grid that cannot grow is left empty: particles only meet the planes
+        spatial_hash_build(sys->grid, bodies->position, bodies->radius, bodies->count, sys->grid_cell_size);
+    }
+
+    float scale = COLLISION_PARTICLE_MASK / (sys->world_bounds.max.x - sys->world_bounds.min.x);
+    particle_mask_build(sys, bodies, scale);
+
+    ParticleCollideJob job = { .sys = sys, .bodies = bodies, .particles = particles, .settings = *settings,
+                               .octree = octree, .mask_scale = scale };
+    atomic_init(&job.tests, 0);
+    atomic_init(&job.hits, 0);
+    thread_pool_parallel_for(sys->pool, 0, particles->count, COLLISION_PARTICLE_GRAIN, particle_collide_range, &job);
+    sys->particle_tests = atomic_load(&job.tests);
+    sys->particle_hits = atomic_load(&job.hits);
+}
+
+/*
+ * collision_system_update
+ * Runs the stage table: continuous collision, broad phase, narrow phase,
+ * contact islands, then the solver. Each stage is timed into stage_ns.
+ * The frame arena is reset first, so last update's scratch is gone.
+ */
+void collision_system_update(CollisionSystem* sys, BodyStore* bodies, float dt) {
+    sys->dt = dt;
+    frame_arena_reset(&sys->frame);
+    for (int s = 0; s < COLLISION_STAGE_COUNT; s++) {
+        uint64_t start = timer_now_ns();
+        sys->stages[s](sys, bodies);
+        uint64_t end = timer_now_ns();
+        sys->stage_ns[s] = end - start;
+        PROFILE_SPAN(collision_stage_name((CollisionStage)s), start, end);
+    }
+}
@@ -0,0 +1,63 @@
+#include "frame_arena.h"
+#include "mem.h"
+#include <stdint.h>
+#include <string.h>
+
+static size_t frame_arena_round(size_t size) {
+    return (size + FRAME_ARENA_ALIGN - 1) & ~(size_t)(FRAME_ARENA_ALIGN - 1);
+}
+
+static unsigned char* frame_arena_aligned(void* block, size_t header) {
+    uintptr_t p = (uintptr_t)block + header;
+    return (unsigned char*)((p + FRAME_ARENA_ALIGN - 1) & ~(uintptr_t)(FRAME_ARENA_ALIGN - 1));
+}
+
+void frame_arena_init(FrameArena* arena) {
+    memset(arena, 0, sizeof(FrameArena));
+}
+
+static void frame_arena_free_overflow(FrameArena* arena) {
+    while (arena->overflow) {
+        FrameArenaBlock* next = arena->overflow->next;
+        mem_free(arena->overflow);
+        arena->overflow = next;
+    }
+}
+
+void frame_arena_free(FrameArena* arena) {
+    frame_arena_free_overflow(arena);
+    mem_free(arena->base);
+    memset(arena, 0, sizeof(FrameArena));
+}
+
+void frame_arena_reset(FrameArena* arena) {
+    if (arena->overflow) {
+        frame_arena_free_overflow(arena);
+        size_t capacity = arena->capacity ? arena->capacity : FRAME_ARENA_MIN_SIZE;
+        while (capacity < 2 * arena->peak) capacity *= 2;
+        mem_free(arena->base);
+        arena->base = mem_malloc(capacity + FRAME_ARENA_ALIGN);
+        arena->capacity = capacity;
+    }
+    arena->used = 0;
+    arena->step_total = 0;
+}
+
+void* frame_arena_alloc(FrameArena* arena, size_t size) {
+    size = frame_arena_round(size ? size : 1);
+    arena->step_total += size;
+    if (arena->step_total > arena->peak) arena->peak = arena->step_total;
+
+    if (arena->base && arena->used + size <= arena->capacity) {
+        void* p = frame_arena_aligned(arena->base, 0) + arena->used;
+        arena->used += size;
+        return p;
+    }
+
+    // Out of room until the next reset grows the arena
+    FrameArenaBlock* block = mem_malloc(sizeof(FrameArenaBlock) + FRAME_ARENA_ALIGN + size);
+    if (!block) return NULL;
+    block->next = arena->overflow;
+    arena->overflow = block;
+    return frame_arena_aligned(block, sizeof(FrameArenaBlock));
+}
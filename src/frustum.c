@@ -0,0 +1,49 @@
+#include "frustum.h"
+#include <math.h>
+
+void frustum_from_matrix(Frustum* frustum, const float clip[16]) {
+    // Row i of a column-major matrix is (m[i], m[4 + i], m[8 + i], m[12 + i])
+    for (int p = 0; p < 6; p++) {
+        int row = p / 2;
+        float sign = (p & 1) ? -1.0f : 1.0f;
+        float a = clip[3] + sign * clip[row];
+        float b = clip[7] + sign * clip[4 + row];
+        float c = clip[11] + sign * clip[8 + row];
+        float d = clip[15] + sign * clip[12 + row];
+        float length = sqrtf(a * a + b * b + c * c);
+        float inv = length > 0.0f ? 1.0f / length : 0.0f;
+        frustum->planes[p] = (FrustumPlane){ { a * inv, b * inv, c * inv }, d * inv };
+    }
+}
+
+bool frustum_test_sphere(const Frustum* frustum, Vec3 center, float radius) {
+    for (int p = 0; p < 6; p++) {
+        const FrustumPlane* plane = &frustum->planes[p];
+        if (vec3_dot(plane->normal, center) + plane->d < -radius) return false;
+    }
+    return true;
+}
+
+bool frustum_test_point(const Frustum* frustum, Vec3 point) {
+    return frustum_test_sphere(frustum, point, 0.0f);
+}
+
+/*
+ * frustum_test_aabb
+ * Per plane, the corner furthest along n⃗ decides whether the box is
+ * outside; the nearest corner whether it straddles the plane.
+ */
+FrustumResult frustum_test_aabb(const Frustum* frustum, AABB box) {
+    FrustumResult result = FRUSTUM_INSIDE;
+    for (int p = 0; p < 6; p++) {
+        const FrustumPlane* plane = &frustum->planes[p];
+        Vec3 n = plane->normal;
+        Vec3 far = { n.x >= 0.0f ? box.max.x : box.min.x, n.y >= 0.0f ? box.max.y : box.min.y,
+                     n.z >= 0.0f ? box.max.z : box.min.z };
+        if (vec3_dot(n, far) + plane->d < 0.0f) return FRUSTUM_OUTSIDE;
+        Vec3 near = { n.x >= 0.0f ? box.min.x : box.max.x, n.y >= 0.0f ? box.min.y : box.max.y,
+                      n.z >= 0.0f ? box.min.z : box.max.z };
+        if (vec3_dot(n, near) + plane->d < 0.0f) result = FRUSTUM_INTERSECT;
+    }
+    return result;
+}
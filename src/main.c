@@ -1,18 +1,25 @@
 #include <GL/glut.h>
 #include "scene.h"
 #include "renderer.h"
+#include "sim_thread.h"
+#include "profile.h"
 #include <time.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 Scene g_scene;
-bool keys[32];
+SceneStepper g_stepper;
+SimThread* g_sim;
+bool keys[256];
 int last_time;
 int mouse_x, mouse_y;
 bool mouse_locked = true;
+int g_fountain;
 
 void init() {
     srand(time(NULL));
     scene_init(&g_scene);
+    stepper_init(&g_stepper, STEPPER_DEFAULT_HZ, 1, STEPPER_DEFAULT_MAX_STEPS);
     renderer_init();
     
     // Create random Rigid Bodies
@@ -39,9 +46,21 @@ void init() {
         };
         
         b.color = (Vec3){ (float)rand()/RAND_MAX, (float)rand()/RAND_MAX, (float)rand()/RAND_MAX };
+        b.trail = true;
         scene_add_body(&g_scene, b);
     }
     
+    // Toggled with 'f'
+    g_fountain = scene_add_emitter(&g_scene, (Emitter){
+        .position = {0, 5, 0},
+        .rate = 2000.0f,
+        .spawn = particle_spawn_explosion(),
+        .rng = (uint32_t)rand(),
+    });
+    
+    // From here on the scene belongs to the simulation thread
+    g_sim = sim_thread_start(&g_scene, &g_stepper, NULL);
+    if (!g_sim) exit(1);
     last_time = glutGet(GLUT_ELAPSED_TIME);
 }
 
@@ -49,27 +68,72 @@ void update() {
     int now = glutGet(GLUT_ELAPSED_TIME);
     float dt = (now - last_time) / 1000.0f;
     last_time = now;
-    if(dt > 0.1f) dt = 0.1f;
     
-    renderer_update_camera_keyboard(keys, dt);
-    scene_update(&g_scene, dt);
+    // Physics steps on its own thread; this one only draws what it publishes
+    renderer_update_camera_keyboard(keys, dt > 0.1f ? 0.1f : dt);
     
     glutPostRedisplay();
 }
 
 void display() {
-    renderer_render_scene(&g_scene);
+    renderer_render_snapshot(sim_thread_acquire(g_sim));
+    glutSwapBuffers();
 }
 
 void reshape(int w, int h) {
     renderer_resize(w, h);
 }
 
+#ifdef PHYSICS_PROFILE
+// 't' starts a capture of up to ~10 s of steps; pressed again it writes the trace
+#define VIEWER_TRACE_EVENTS (24 * 60 * 10)
+#define VIEWER_TRACE_PATH "physics_trace.json"
+
+static void toggle_trace(Scene* scene, void* user) {
+    (void)scene; (void)user;
+    if (!profile_active()) {
+        if (profile_start(VIEWER_TRACE_EVENTS)) printf("profiling...\n");
+        return;
+    }
+    profile_stop();
+    profile_print_summary(stdout);
+    if (profile_write_chrome_trace(VIEWER_TRACE_PATH)) {
+        printf("trace: %d events written to %s\n", profile_event_count(), VIEWER_TRACE_PATH);
+    }
+}
+#endif
+
+// Scene changes run on the simulation thread between steps
+static void explode(Scene* scene, void* user) {
+    (void)user;
+    scene_spawn_explosion(scene, (Vec3){0,5,0}, 50);
+}
+
+static void toggle_fountain(Scene* scene, void* user) {
+    (void)user;
+    if (g_fountain >= 0) scene->emitters[g_fountain].active = !scene->emitters[g_fountain].active;
+}
+
 void keyboard_down(unsigned char key, int x, int y) {
     (void)x; (void)y;
     keys[key] = true;
-    if(key == 27) exit(0);
-    if(key == 'p') scene_spawn_explosion(&g_scene, (Vec3){0,5,0}, 50);
+    if(key == 27) {
+        sim_thread_stop(g_sim);
+        exit(0);
+    }
+    if(key == 'p') sim_thread_post(g_sim, explode, NULL);
+    if(key == 'f') sim_thread_post(g_sim, toggle_fountain, NULL);
+    if(key == 'i') {
+        RenderPath path = renderer_path() == RENDER_PATH_INSTANCED ? RENDER_PATH_IMMEDIATE : RENDER_PATH_INSTANCED;
+        if (renderer_set_path(path)) printf("renderer: %s\n", renderer_path_name(path));
+    }
+    if(key == 'c') {
+        renderer_set_culling(!renderer_culling());
+        printf("renderer: culling %s\n", renderer_culling() ? "on" : "off");
+    }
+#ifdef PHYSICS_PROFILE
+    if(key == 't') sim_thread_post(g_sim, toggle_trace, NULL);
+#endif
 }
 
 void keyboard_up(unsigned char key, int x, int y) {
@@ -0,0 +1,32 @@
+#include "mem.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+static atomic_uint_fast64_t g_allocations;
+
+static void mem_count() {
+    atomic_fetch_add_explicit(&g_allocations, 1, memory_order_relaxed);
+}
+
+void* mem_malloc(size_t size) {
+    mem_count();
+    return malloc(size);
+}
+
+void* mem_calloc(size_t count, size_t size) {
+    mem_count();
+    return calloc(count, size);
+}
+
+void* mem_realloc(void* ptr, size_t size) {
+    if (size > 0) mem_count();
+    return realloc(ptr, size);
+}
+
+void mem_free(void* ptr) {
+    free(ptr);
+}
+
+uint64_t mem_allocation_count() {
+    return atomic_load_explicit(&g_allocations, memory_order_relaxed);
+}
@@ -0,0 +1,94 @@
+#include "pair_cache.h"
+#include "mem.h"
+#include <string.h>
+
+// Slot header; the payload follows, 8-byte aligned
+typedef struct {
+    uint64_t key;               // 0 = empty
+    uint64_t generations;
+} PairCacheHeader;
+
+void pair_cache_init(PairCache* cache, size_t payload_size) {
+    memset(cache, 0, sizeof(PairCache));
+    cache->payload_size = payload_size;
+    cache->entry_size = sizeof(PairCacheHeader) + ((payload_size + 7) & ~(size_t)7);
+}
+
+void pair_cache_free(PairCache* cache) {
+    mem_free(cache->current);
+    mem_free(cache->previous);
+    size_t payload_size = cache->payload_size;
+    pair_cache_init(cache, payload_size);
+}
+
+void pair_cache_clear(PairCache* cache) {
+    if (cache->current) memset(cache->current, 0, cache->current_capacity * cache->entry_size);
+    if (cache->previous) memset(cache->previous, 0, cache->previous_capacity * cache->entry_size);
+    cache->current_count = 0;
+    cache->previous_count = 0;
+}
+
+// 64-bit finalizer (MurmurHash3 fmix64)
+static inline uint64_t pair_cache_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+static inline PairCacheHeader* pair_cache_slot(unsigned char* table, size_t entry_size, uint64_t i) {
+    return (PairCacheHeader*)(table + i * entry_size);
+}
+
+bool pair_cache_begin(PairCache* cache, int count) {
+    unsigned char* entries = cache->previous;
+    int capacity = cache->previous_capacity;
+    cache->previous = cache->current;
+    cache->previous_capacity = cache->current_capacity;
+    cache->previous_count = cache->current_count;
+
+    // Load factor ≤ 0.5
+    int needed = 64;
+    while (needed < count * 2) needed <<= 1;
+    if (needed > capacity) {
+        // One doubling of headroom: a count hovering at a power of two
+        // would otherwise reallocate both tables back and forth
+        capacity = needed * 2;
+        mem_free(entries);
+        entries = mem_malloc(capacity * cache->entry_size);
+        if (!entries) capacity = 0;
+    }
+    if (entries) memset(entries, 0, capacity * cache->entry_size);
+    cache->current = entries;
+    cache->current_capacity = capacity;
+    cache->current_count = 0;
+    return entries != NULL;
+}
+
+const void* pair_cache_find(const PairCache* cache, uint64_t key, uint64_t generations) {
+    if (cache->previous_count == 0) return NULL;
+    uint64_t mask = (uint64_t)cache->previous_capacity - 1;
+    for (uint64_t i = pair_cache_hash(key) & mask; ; i = (i + 1) & mask) {
+        const PairCacheHeader* e = pair_cache_slot(cache->previous, cache->entry_size, i);
+        if (e->key == 0) return NULL;
+        if (e->key == key) return e->generations == generations ? e + 1 : NULL;
+    }
+}
+
+void pair_cache_store(PairCache* cache, uint64_t key, uint64_t generations, const void* payload) {
+    // The table is sized for the step's pairs in pair_cache_begin
+    if (2 * (cache->current_count + 1) > cache->current_capacity) return;
+    uint64_t mask = (uint64_t)cache->current_capacity - 1;
+    uint64_t i = pair_cache_hash(key) & mask;
+    PairCacheHeader* e = pair_cache_slot(cache->current, cache->entry_size, i);
+    while (e->key != 0 && e->key != key) {
+        i = (i + 1) & mask;
+        e = pair_cache_slot(cache->current, cache->entry_size, i);
+    }
+    if (e->key == 0) cache->current_count++;
+    e->key = key;
+    e->generations = generations;
+    memcpy(e + 1, payload, cache->payload_size);
+}
@@ -0,0 +1,187 @@
+#include "particles.h"
+#include "simd.h"
+#include "mem.h"
+#include <math.h>
+#include <string.h>
+
+// ============================================================================
+// STORAGE
+// ============================================================================
+
+void particle_store_init(ParticleStore* store) {
+    memset(store, 0, sizeof(ParticleStore));
+}
+
+// Realloc that leaves the old block in place (and clears ok) on failure
+static void* particle_store_grow(void* array, size_t size, int capacity, bool* ok) {
+    void* grown = mem_realloc(array, (size_t)capacity * size);
+    if (grown) return grown;
+    *ok = false;
+    return array;
+}
+
+// Arrays that did grow keep their larger block; capacity only moves once all have
+bool particle_store_reserve(ParticleStore* store, int capacity) {
+    if (capacity <= store->capacity) return true;
+    bool ok = true;
+
+    store->position = particle_store_grow(store->position, sizeof(Vec3),  capacity, &ok);
+    store->velocity = particle_store_grow(store->velocity, sizeof(Vec3),  capacity, &ok);
+    store->life     = particle_store_grow(store->life,     sizeof(float), capacity, &ok);
+    store->max_life = particle_store_grow(store->max_life, sizeof(float), capacity, &ok);
+    store->color    = particle_store_grow(store->color,    sizeof(Vec3),  capacity, &ok);
+    if (ok) store->capacity = capacity;
+    return ok;
+}
+
+void particle_store_free(ParticleStore* store) {
+    mem_free(store->position);
+    mem_free(store->velocity);
+    mem_free(store->life);
+    mem_free(store->max_life);
+    mem_free(store->color);
+    memset(store, 0, sizeof(ParticleStore));
+}
+
+// Storage is kept
+void particle_store_clear(ParticleStore* store) {
+    store->count = 0;
+}
+
+// ============================================================================
+// SPAWNING
+// ============================================================================
+
+// xorshift32, as the bench workloads use; rand() is shared global state
+static inline float particle_random(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (float)(x >> 8) / 16777216.0f; // [0, 1)
+}
+
+static inline float particle_random_range(uint32_t* state, float lo, float hi) {
+    return lo + (hi - lo) * particle_random(state);
+}
+
+ParticleSpawn particle_spawn_explosion() {
+    return (ParticleSpawn){
+        .speed_min = 5.0f, .speed_max = 15.0f,
+        .life_min = 0.5f, .life_max = 1.5f,
+        .color_min = {1.0f, 0.5f, 0.0f}, .color_max = {1.0f, 1.0f, 0.0f},
+    };
+}
+
+void particle_store_emit(ParticleStore* store, Vec3 origin, int count, const ParticleSpawn* spawn, uint32_t* rng) {
+    if (count <= 0) return;
+    int needed = store->count + count;
+    if (needed > store->capacity) {
+        int capacity = store->capacity ? store->capacity : 512;
+        while (capacity < needed) capacity *= 2;
+        // Out of memory, only what fits is emitted
+        if (!particle_store_reserve(store, capacity)) needed = store->capacity;
+    }
+    if (*rng == 0) *rng = 1; // xorshift never leaves 0
+
+    for (int i = store->count; i < needed; i++) {
+        float theta = particle_random(rng) * 2 * PI;
+        float phi = particle_random(rng) * PI;
+        float speed = particle_random_range(rng, spawn->speed_min, spawn->speed_max);
+        float sin_phi = sinf(phi);
+
+        store->position[i] = origin;
+        store->velocity[i] = (Vec3){ speed * sin_phi * cosf(theta), speed * cosf(phi), speed * sin_phi * sinf(theta) };
+        store->max_life[i] = particle_random_range(rng, spawn->life_min, spawn->life_max);
+        store->life[i] = store->max_life[i];
+        store->color[i] = (Vec3){
+            particle_random_range(rng, spawn->color_min.x, spawn->color_max.x),
+            particle_random_range(rng, spawn->color_min.y, spawn->color_max.y),
+            particle_random_range(rng, spawn->color_min.z, spawn->color_max.z)
+        };
+    }
+    store->count = needed;
+}
+
+void emitter_update(Emitter* emitter, ParticleStore* store, float dt) {
+    if (!emitter->active) return;
+    emitter->owed += emitter->rate * dt;
+    int count = (int)emitter->owed;
+    emitter->owed -= (float)count;
+    particle_store_emit(store, emitter->position, count, &emitter->spawn, &emitter->rng);
+}
+
+// ============================================================================
+// UPDATE
+// ============================================================================
+
+typedef struct {
+    ParticleStore* store;
+    Vec3 gravity;               // Already scaled by PARTICLE_GRAVITY_SCALE
+    float dt;
+} ParticleRangeJob;
+
+_Static_assert(sizeof(Vec3) == 3 * sizeof(float), "particle vectors are updated as flat float arrays");
+
+/*
+ * x⃗ += v⃗ Δt, then v⃗ += g⃗ Δt, with life -= Δt. The Vec3 arrays are read
+ * as flat floats, SIMD_WIDTH particles (three lane vectors) at a time, so
+ * nothing is transposed; Δv⃗ repeats every three floats. Expired particles
+ * are moved too and removed afterwards.
+ */
+static void particle_update_range(void* user, int begin, int end) {
+    ParticleRangeJob* job = user;
+    ParticleStore* s = job->store;
+    float dt = job->dt;
+    Vec3 dv = vec3_scale(job->gravity, dt);
+
+    float* x = (float*)s->position;
+    float* v = (float*)s->velocity;
+    float pattern[3 * SIMD_WIDTH];
+    for (int k = 0; k < 3 * SIMD_WIDTH; k += 3) {
+        pattern[k] = dv.x;
+        pattern[k + 1] = dv.y;
+        pattern[k + 2] = dv.z;
+    }
+    Lanes dt_l = lanes_set1(dt);
+    Lanes dv_l[3] = { lanes_load(pattern), lanes_load(pattern + SIMD_WIDTH), lanes_load(pattern + 2 * SIMD_WIDTH) };
+
+    int i = begin;
+    for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+        for (int c = 0; c < 3; c++) {
+            int k = 3 * i + c * SIMD_WIDTH;
+            Lanes vel = lanes_load(v + k);
+            lanes_store(x + k, lanes_add(lanes_load(x + k), lanes_mul(vel, dt_l)));
+            lanes_store(v + k, lanes_add(vel, dv_l[c]));
+        }
+        lanes_store(&s->life[i], lanes_sub(lanes_load(&s->life[i]), dt_l));
+    }
+    for (; i < end; i++) {
+        s->position[i] = vec3_add(s->position[i], vec3_scale(s->velocity[i], dt));
+        s->velocity[i] = vec3_add(s->velocity[i], dv);
+        s->life[i] -= dt;
+    }
+}
+
+static void particle_store_move(ParticleStore* store, int from, int to) {
+    store->position[to] = store->position[from];
+    store->velocity[to] = store->velocity[from];
+    store->life[to]     = store->life[from];
+    store->max_life[to] = store->max_life[from];
+    store->color[to]    = store->color[from];
+}
+
+void particle_store_update(ParticleStore* store, ThreadPool* pool, Vec3 gravity, float dt) {
+    ParticleRangeJob job = { store, vec3_scale(gravity, PARTICLE_GRAVITY_SCALE), dt };
+    thread_pool_parallel_for(pool, 0, store->count, PARTICLE_PARALLEL_GRAIN, particle_update_range, &job);
+
+    // Swap-remove; the moved particle is checked at this index next
+    for (int i = 0; i < store->count; ) {
+        if (store->life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        particle_store_move(store, --store->count, i);
+    }
+}
@@ -1,4 +1,6 @@
 #include "physics.h"
+#include "body_store.h"
+#include "simd.h"
 #include <string.h>
 
 void physics_init_body(RigidBody* body, Vec3 pos, float mass, float radius, int id) {
@@ -10,6 +12,7 @@ void physics_init_body(RigidBody* body, Vec3 pos, float mass, float radius, int
     body->orientation = quat_identity();
     body->angular_velocity = vec3_zero();
     
+    body->shape = SHAPE_SPHERE;
     body->mass = mass;
     if (mass > 1e-6) {
         body->inv_mass = 1.0f / mass;
@@ -27,6 +30,7 @@ void physics_init_body(RigidBody* body, Vec3 pos, float mass, float radius, int
         body->is_static = true;
         body->inertia_tensor = mat3_zero();
     }
+    body->inv_inertia_body = body->is_static ? mat3_zero() : mat3_inverse(body->inertia_tensor);
     
     body->radius = radius;
     body->restitution = 0.7f;
@@ -37,22 +41,46 @@ void physics_init_body(RigidBody* body, Vec3 pos, float mass, float radius, int
     
     // Initial World Inertia Calculation
     physics_update_inertia(body);
-    
-    // Initialize trail
-    for(int i=0; i<TRAIL_LENGTH; ++i) body->trail[i] = pos;
-    body->trail_head = 0;
+}
+
+/*
+ * physics_init_box
+ * Solid cuboid with half extents h⃗:
+ * I = (m/3) diag(h_y² + h_z², h_x² + h_z², h_x² + h_y²)
+ */
+void physics_init_box(RigidBody* body, Vec3 pos, float mass, Vec3 half_extents, int id) {
+    physics_init_body(body, pos, mass, vec3_magnitude(half_extents), id);
+    body->shape = SHAPE_BOX;
+    body->half_extents = half_extents;
+    if (body->is_static) return;
+
+    float k = mass / 3.0f;
+    Vec3 h2 = { half_extents.x * half_extents.x, half_extents.y * half_extents.y, half_extents.z * half_extents.z };
+    body->inertia_tensor = mat3_zero();
+    body->inertia_tensor.m[0][0] = k * (h2.y + h2.z);
+    body->inertia_tensor.m[1][1] = k * (h2.x + h2.z);
+    body->inertia_tensor.m[2][2] = k * (h2.x + h2.y);
+    body->inv_inertia_body = mat3_inverse(body->inertia_tensor);
+    physics_update_inertia(body);
 }
 
 void physics_update_inertia(RigidBody* body) {
     if (body->is_static) return;
     
-    // I⁻¹_world = R I⁻¹_body Rᵀ
+    // A sphere's inertia is the same about every axis, so rotating it is a no-op
+    if (body->shape == SHAPE_SPHERE) {
+        body->inv_inertia_world = body->inv_inertia_body;
+        return;
+    }
+    
+    // I⁻¹_world = R I⁻¹_body Rᵀ (I⁻¹_body is diagonal in the principal frame)
     Mat3 R = quat_to_mat3(body->orientation);
-    Mat3 I_inv_body = mat3_inverse(body->inertia_tensor);
-    Mat3 temp = mat3_mul(R, I_inv_body);
-    body->inv_inertia_world = mat3_mul(temp, mat3_transpose(R));
+    Vec3 d = { body->inv_inertia_body.m[0][0], body->inv_inertia_body.m[1][1], body->inv_inertia_body.m[2][2] };
+    body->inv_inertia_world = mat3_rotate_diagonal(R, d);
 }
 
+// Accumulates on the description only; bodies in a scene are pushed (and
+// woken) through scene_add_force or body_store_add_force
 void physics_add_force(RigidBody* body, Vec3 force) {
     body->force_accumulator = vec3_add(body->force_accumulator, force);
 }
@@ -90,7 +118,7 @@ void physics_add_torque(RigidBody* body, Vec3 torque) {
  * Apply linear and angular drag to simulate air resistance.
  */
 void physics_integrate(RigidBody* body, float dt) {
-    if (body->is_static) return;
+    if (body->is_static || body->is_sleeping) return;
     
     // --- 1. Linear Dynamics ---
     
@@ -146,11 +174,156 @@ void physics_integrate(RigidBody* body, float dt) {
     // --- 3. Cleanup ---
     body->force_accumulator = vec3_zero();
     body->torque_accumulator = vec3_zero();
+}
+
+// ============================================================================
+// STORE INTEGRATION
+// ============================================================================
+// Linear motion, drag and the orientation update are the same for every
+// shape; the kernels below differ only in how α⃗ = I⁻¹ τ⃗ is formed and
+// whether I⁻¹_world has to follow the new orientation.
+
+typedef void (*PhysicsIntegrateFn)(BodyStore* store, int i, float dt);
+
+// Advances body i given its angular acceleration; returns the new orientation
+static Quat physics_integrate_motion(BodyStore* store, int i, Vec3 ang_accel, float dt) {
+    // --- 1. Linear Dynamics ---
+    Vec3 accel = vec3_scale(store->force_accumulator[i], store->inv_mass[i]);
+    Vec3 v = vec3_add(store->velocity[i], vec3_scale(accel, dt));
+    v = vec3_scale(v, 1.0f / (1.0f + store->drag_linear[i] * dt));
+    store->velocity[i] = v;
+    store->position[i] = vec3_add(store->position[i], vec3_scale(v, dt));
+    
+    // --- 2. Rotational Dynamics ---
+    Vec3 w = vec3_add(store->angular_velocity[i], vec3_scale(ang_accel, dt));
+    w = vec3_scale(w, 1.0f / (1.0f + store->drag_angular[i] * dt));
+    store->angular_velocity[i] = w;
+    
+    // q_new = q + (0.5 * ω * q) * dt
+    Quat q = store->orientation[i];
+    Quat spin = quat_mul((Quat){0, w.x, w.y, w.z}, q);
+    q.w += spin.w * 0.5f * dt;
+    q.x += spin.x * 0.5f * dt;
+    q.y += spin.y * 0.5f * dt;
+    q.z += spin.z * 0.5f * dt;
+    q = quat_normalize(q);
+    store->orientation[i] = q;
+    
+    // --- 3. Cleanup ---
+    store->force_accumulator[i] = vec3_zero();
+    store->torque_accumulator[i] = vec3_zero();
+    return q;
+}
+
+// Sphere: α⃗ = τ⃗ / I, and I⁻¹_world never changes
+static void physics_integrate_sphere(BodyStore* store, int i, float dt) {
+    Vec3 ang_accel = vec3_scale(store->torque_accumulator[i], store->inv_inertia_body[i].x);
+    physics_integrate_motion(store, i, ang_accel, dt);
+}
+
+// Box: α⃗ = I⁻¹(t) τ⃗, then I⁻¹(t+Δt) = R diag(d⃗) Rᵀ
+static void physics_integrate_box(BodyStore* store, int i, float dt) {
+    Vec3 ang_accel = mat3_mul_vec(store->inv_inertia_world[i], store->torque_accumulator[i]);
+    Quat q = physics_integrate_motion(store, i, ang_accel, dt);
+    store->inv_inertia_world[i] = mat3_rotate_diagonal(quat_to_mat3(q), store->inv_inertia_body[i]);
+}
+
+// --- Lanes: SIMD_WIDTH consecutive awake bodies of one shape ---
+
+static QuatLanes physics_integrate_motion_lanes(BodyStore* store, int i, Vec3Lanes ang_accel, float dt) {
+    Lanes dt_l = lanes_set1(dt);
+    Lanes one = lanes_set1(1.0f);
+    Lanes half = lanes_set1(0.5f);
     
-    // Trail Update
-    static int trail_counter = 0;
-    if (trail_counter++ % 3 == 0) {
-        body->trail[body->trail_head] = body->position;
-        body->trail_head = (body->trail_head + 1) % TRAIL_LENGTH;
+    // --- 1. Linear Dynamics ---
+    Vec3Lanes accel = vec3_lanes_scale(vec3_lanes_load(&store->force_accumulator[i]), lanes_load(&store->inv_mass[i]));
+    Vec3Lanes v = vec3_lanes_add(vec3_lanes_load(&store->velocity[i]), vec3_lanes_scale(accel, dt_l));
+    Lanes damp = lanes_div(one, lanes_add(one, lanes_mul(lanes_load(&store->drag_linear[i]), dt_l)));
+    v = vec3_lanes_scale(v, damp);
+    vec3_lanes_store(&store->velocity[i], v);
+    vec3_lanes_store(&store->position[i], vec3_lanes_add(vec3_lanes_load(&store->position[i]), vec3_lanes_scale(v, dt_l)));
+    
+    // --- 2. Rotational Dynamics ---
+    Vec3Lanes w = vec3_lanes_add(vec3_lanes_load(&store->angular_velocity[i]), vec3_lanes_scale(ang_accel, dt_l));
+    damp = lanes_div(one, lanes_add(one, lanes_mul(lanes_load(&store->drag_angular[i]), dt_l)));
+    w = vec3_lanes_scale(w, damp);
+    vec3_lanes_store(&store->angular_velocity[i], w);
+    
+    QuatLanes q = quat_lanes_load(&store->orientation[i]);
+    QuatLanes spin = quat_lanes_mul((QuatLanes){ lanes_set1(0.0f), w.x, w.y, w.z }, q);
+    q.w = lanes_add(q.w, lanes_mul(lanes_mul(spin.w, half), dt_l));
+    q.x = lanes_add(q.x, lanes_mul(lanes_mul(spin.x, half), dt_l));
+    q.y = lanes_add(q.y, lanes_mul(lanes_mul(spin.y, half), dt_l));
+    q.z = lanes_add(q.z, lanes_mul(lanes_mul(spin.z, half), dt_l));
+    q = quat_lanes_normalize(q);
+    quat_lanes_store(&store->orientation[i], q);
+    
+    // --- 3. Cleanup ---
+    for (int l = 0; l < SIMD_WIDTH; l++) {
+        store->force_accumulator[i + l] = vec3_zero();
+        store->torque_accumulator[i + l] = vec3_zero();
     }
-}
\ No newline at end of file
+    return q;
+}
+
+static void physics_integrate_sphere_lanes(BodyStore* store, int i, float dt) {
+    Lanes inv_inertia = vec3_lanes_load(&store->inv_inertia_body[i]).x;
+    Vec3Lanes ang_accel = vec3_lanes_scale(vec3_lanes_load(&store->torque_accumulator[i]), inv_inertia);
+    physics_integrate_motion_lanes(store, i, ang_accel, dt);
+}
+
+static void physics_integrate_box_lanes(BodyStore* store, int i, float dt) {
+    Mat3Lanes inv_world = mat3_lanes_load(&store->inv_inertia_world[i]);
+    Vec3Lanes ang_accel = mat3_lanes_mul_vec(&inv_world, vec3_lanes_load(&store->torque_accumulator[i]));
+    QuatLanes q = physics_integrate_motion_lanes(store, i, ang_accel, dt);
+    Mat3Lanes R = quat_lanes_to_mat3(q);
+    Vec3Lanes d = vec3_lanes_load(&store->inv_inertia_body[i]);
+    mat3_lanes_store(&store->inv_inertia_world[i], mat3_lanes_rotate_diagonal(&R, d));
+}
+
+static const PhysicsIntegrateFn g_integrate_one[SHAPE_COUNT] = {
+    [SHAPE_SPHERE] = physics_integrate_sphere,
+    [SHAPE_BOX]    = physics_integrate_box,
+};
+
+static const PhysicsIntegrateFn g_integrate_lanes[SHAPE_COUNT] = {
+    [SHAPE_SPHERE] = physics_integrate_sphere_lanes,
+    [SHAPE_BOX]    = physics_integrate_box_lanes,
+};
+
+/*
+ * physics_integrate_store
+ *
+ * Structure-of-arrays counterpart of physics_integrate. Each loop iteration
+ * reads and writes only the hot arrays of one body. Runs of SIMD_WIDTH awake
+ * bodies of the same shape go through that shape's lane kernel (simd.h).
+ * The store keeps bodies grouped by shape (body_store_sort_by_shape), so
+ * only the block at each shape boundary, blocks holding a static or
+ * sleeping body, and the remainder are dispatched one body at a time.
+ *
+ * The body-space inverse inertia is cached at init, so no step inverts a
+ * matrix: spheres skip the world-inertia update entirely and boxes rotate
+ * a diagonal.
+ */
+void physics_integrate_store(BodyStore* store, int begin, int end, float dt) {
+    const uint8_t inactive = BODY_FLAG_STATIC | BODY_FLAG_SLEEPING;
+    int i = begin;
+    for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+        uint8_t any = 0;
+        bool same_shape = true;
+        for (int l = 0; l < SIMD_WIDTH; l++) {
+            any |= store->flags[i + l];
+            same_shape &= store->shape[i + l] == store->shape[i];
+        }
+        if (!(any & inactive) && same_shape) {
+            g_integrate_lanes[store->shape[i]](store, i, dt);
+            continue;
+        }
+        for (int l = 0; l < SIMD_WIDTH; l++) {
+            if (!(store->flags[i + l] & inactive)) g_integrate_one[store->shape[i + l]](store, i + l, dt);
+        }
+    }
+    for (; i < end; i++) {
+        if (!(store->flags[i] & inactive)) g_integrate_one[store->shape[i]](store, i, dt);
+    }
+}
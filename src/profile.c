@@ -0,0 +1,270 @@
+#include "profile.h"
+#include "mem.h"
+#include "timer.h"
+#include <string.h>
+
+typedef enum {
+    PROFILE_EVENT_ZONE,
+    PROFILE_EVENT_COUNTER,
+    PROFILE_EVENT_TRACK,
+} ProfileEventKind;
+
+typedef struct {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t dur_ns;            // Zones
+    int64_t value;              // Counters
+    int track;
+    ProfileEventKind kind;
+} ProfileEvent;
+
+typedef struct {
+    bool active;
+    uint64_t epoch_ns;          // Trace timestamps are relative to this
+    int track;
+
+    ProfileEvent* events;
+    int event_count;
+    int event_capacity;
+    int dropped;
+
+    // Names seen so far; index = summary slot
+    const char* zone_names[PROFILE_MAX_ZONES];
+    int zone_count;
+    const char* counter_names[PROFILE_MAX_COUNTERS];
+    int counter_count;
+
+    // Current frame, then one row per past frame (ring)
+    uint64_t frame_ns[PROFILE_MAX_ZONES];
+    int frame_calls[PROFILE_MAX_ZONES];
+    int64_t frame_counter[PROFILE_MAX_COUNTERS];
+    uint64_t history_ns[PROFILE_HISTORY][PROFILE_MAX_ZONES];
+    int history_calls[PROFILE_HISTORY][PROFILE_MAX_ZONES];
+    int64_t history_counter[PROFILE_HISTORY][PROFILE_MAX_COUNTERS];
+    int history_next;
+    int history_frames;
+} Profiler;
+
+static Profiler g_profile;
+
+static void profile_clear_summary() {
+    g_profile.zone_count = 0;
+    g_profile.counter_count = 0;
+    memset(g_profile.frame_ns, 0, sizeof(g_profile.frame_ns));
+    memset(g_profile.frame_calls, 0, sizeof(g_profile.frame_calls));
+    memset(g_profile.frame_counter, 0, sizeof(g_profile.frame_counter));
+    g_profile.history_next = 0;
+    g_profile.history_frames = 0;
+}
+
+bool profile_start(int event_capacity) {
+    mem_free(g_profile.events);
+    memset(&g_profile, 0, sizeof(Profiler));
+    if (event_capacity > 0) {
+        g_profile.events = mem_malloc(event_capacity * sizeof(ProfileEvent));
+        if (!g_profile.events) return false;
+        g_profile.event_capacity = event_capacity;
+    }
+    g_profile.epoch_ns = timer_now_ns();
+    g_profile.active = true;
+    return true;
+}
+
+// The summary and captured events stay readable
+void profile_stop() {
+    g_profile.active = false;
+}
+
+bool profile_active() {
+    return g_profile.active;
+}
+
+static ProfileEvent* profile_push(ProfileEventKind kind, const char* name) {
+    if (g_profile.event_count == g_profile.event_capacity) {
+        if (g_profile.event_capacity > 0) g_profile.dropped++;
+        return NULL;
+    }
+    ProfileEvent* e = &g_profile.events[g_profile.event_count++];
+    e->kind = kind;
+    e->name = name;
+    e->track = g_profile.track;
+    return e;
+}
+
+// Clears the summary: frames of different tracks are not comparable
+void profile_begin_track(const char* name) {
+    if (!g_profile.active) return;
+    g_profile.track++;
+    profile_clear_summary();
+    ProfileEvent* e = profile_push(PROFILE_EVENT_TRACK, name);
+    if (e) e->start_ns = timer_now_ns();
+}
+
+// Slot of name in names, added if new; -1 when the table is full
+static int profile_slot(const char** names, int* count, int max, const char* name) {
+    for (int i = 0; i < *count; i++) {
+        if (names[i] == name) return i;
+    }
+    if (*count == max) return -1;
+    names[*count] = name;
+    return (*count)++;
+}
+
+uint64_t profile_zone_begin() {
+    return g_profile.active ? timer_now_ns() : 0;
+}
+
+// A zone begun before profile_start has start_ns 0 and is skipped
+void profile_span(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    if (!g_profile.active || start_ns < g_profile.epoch_ns) return;
+    uint64_t dur = end_ns - start_ns;
+
+    int slot = profile_slot(g_profile.zone_names, &g_profile.zone_count, PROFILE_MAX_ZONES, name);
+    if (slot >= 0) {
+        g_profile.frame_ns[slot] += dur;
+        g_profile.frame_calls[slot]++;
+    }
+    ProfileEvent* e = profile_push(PROFILE_EVENT_ZONE, name);
+    if (e) {
+        e->start_ns = start_ns;
+        e->dur_ns = dur;
+    }
+}
+
+void profile_counter(const char* name, int64_t value) {
+    if (!g_profile.active) return;
+    int slot = profile_slot(g_profile.counter_names, &g_profile.counter_count, PROFILE_MAX_COUNTERS, name);
+    if (slot >= 0) g_profile.frame_counter[slot] = value;
+    ProfileEvent* e = profile_push(PROFILE_EVENT_COUNTER, name);
+    if (e) {
+        e->start_ns = timer_now_ns();
+        e->value = value;
+    }
+}
+
+void profile_frame_end() {
+    if (!g_profile.active) return;
+    int row = g_profile.history_next;
+    memcpy(g_profile.history_ns[row], g_profile.frame_ns, sizeof(g_profile.frame_ns));
+    memcpy(g_profile.history_calls[row], g_profile.frame_calls, sizeof(g_profile.frame_calls));
+    memcpy(g_profile.history_counter[row], g_profile.frame_counter, sizeof(g_profile.frame_counter));
+    memset(g_profile.frame_ns, 0, sizeof(g_profile.frame_ns));
+    memset(g_profile.frame_calls, 0, sizeof(g_profile.frame_calls));
+    g_profile.history_next = (row + 1) % PROFILE_HISTORY;
+    if (g_profile.history_frames < PROFILE_HISTORY) g_profile.history_frames++;
+}
+
+// ============================================================================
+// SUMMARY
+// ============================================================================
+
+void profile_summary(ProfileSummary* out) {
+    memset(out, 0, sizeof(ProfileSummary));
+    int frames = g_profile.history_frames;
+    out->frames = frames;
+    out->zone_count = g_profile.zone_count;
+    out->counter_count = g_profile.counter_count;
+
+    // Oldest row first, so the last counter value is the newest frame's
+    int first = (g_profile.history_next - frames + PROFILE_HISTORY) % PROFILE_HISTORY;
+    for (int z = 0; z < g_profile.zone_count; z++) {
+        ProfileZoneSummary* s = &out->zones[z];
+        s->name = g_profile.zone_names[z];
+        uint64_t total = 0;
+        for (int f = 0; f < frames; f++) {
+            int row = (first + f) % PROFILE_HISTORY;
+            uint64_t ns = g_profile.history_ns[row][z];
+            total += ns;
+            if (ns > s->max_ns) s->max_ns = ns;
+            s->calls += g_profile.history_calls[row][z];
+        }
+        s->mean_ns = frames > 0 ? (double)total / frames : 0.0;
+    }
+    for (int c = 0; c < g_profile.counter_count; c++) {
+        ProfileCounterSummary* s = &out->counters[c];
+        s->name = g_profile.counter_names[c];
+        double total = 0.0;
+        for (int f = 0; f < frames; f++) {
+            int64_t v = g_profile.history_counter[(first + f) % PROFILE_HISTORY][c];
+            total += (double)v;
+            if (f == 0 || v > s->max) s->max = v;
+            s->last = v;
+        }
+        s->mean = frames > 0 ? total / frames : 0.0;
+    }
+}
+
+void profile_print_summary(FILE* out) {
+    ProfileSummary s;
+    profile_summary(&s);
+    fprintf(out, "  last %d frames\n", s.frames);
+    fprintf(out, "  %-14s %12s %12s %8s\n", "zone", "mean us", "max us", "calls");
+    for (int z = 0; z < s.zone_count; z++) {
+        const ProfileZoneSummary* p = &s.zones[z];
+        fprintf(out, "  %-14s %12.2f %12.2f %8d\n", p->name, p->mean_ns * 1e-3, p->max_ns * 1e-3, p->calls);
+    }
+    fprintf(out, "  %-14s %12s %12s %12s\n", "counter", "mean", "max", "last");
+    for (int c = 0; c < s.counter_count; c++) {
+        const ProfileCounterSummary* p = &s.counters[c];
+        fprintf(out, "  %-14s %12.1f %12lld %12lld\n", p->name, p->mean, (long long)p->max, (long long)p->last);
+    }
+}
+
+// ============================================================================
+// CHROME TRACE
+// ============================================================================
+
+int profile_event_count() {
+    return g_profile.event_count;
+}
+
+int profile_dropped_count() {
+    return g_profile.dropped;
+}
+
+// Names are literals from the engine; quotes and backslashes are escaped anyway
+static void profile_write_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/*
+ * Trace Event Format: zones are complete events (ph "X") with ts and dur
+ * in microseconds, counters are "C" events, each track is a process named
+ * by a metadata event. Everything is on one thread per process.
+ */
+bool profile_write_chrome_trace(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"scene\"}}");
+    for (int i = 0; i < g_profile.event_count; i++) {
+        const ProfileEvent* e = &g_profile.events[i];
+        double ts = (double)(e->start_ns - g_profile.epoch_ns) * 1e-3;
+        fprintf(f, ",\n{\"name\":");
+        switch (e->kind) {
+            case PROFILE_EVENT_ZONE:
+                profile_write_string(f, e->name);
+                fprintf(f, ",\"cat\":\"step\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":0}",
+                        ts, (double)e->dur_ns * 1e-3, e->track);
+                break;
+            case PROFILE_EVENT_COUNTER:
+                profile_write_string(f, e->name);
+                fprintf(f, ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,\"args\":{\"value\":%lld}}",
+                        ts, e->track, (long long)e->value);
+                break;
+            case PROFILE_EVENT_TRACK:
+                fprintf(f, "\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":", e->track);
+                profile_write_string(f, e->name);
+                fprintf(f, "}}");
+                break;
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return fclose(f) == 0;
+}
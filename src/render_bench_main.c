@@ -0,0 +1,271 @@
+/*
+ * Offscreen renderer benchmark.
+ *
+ * Creates a GL context without a window (EGL on Mesa's surfaceless
+ * platform, so llvmpipe works on machines without a GPU), steps a standard
+ * bench scene, and draws its snapshot into a framebuffer object with each
+ * render path, with frustum culling and sphere LODs off and on. Reports CPU
+ * submission time, frame time up to glFinish, draw calls, triangles and
+ * culled counts per frame.
+ */
+#define GL_GLEXT_PROTOTYPES
+#include "bench.h"
+#include "renderer.h"
+#include "timer.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    EGLDisplay display;
+    EGLContext context;
+    GLuint framebuffer;
+    GLuint color;
+    GLuint depth;
+} OffscreenContext;
+
+static void print_usage(const char* prog) {
+    printf("usage: %s [options]\n", prog);
+    printf("  --scene NAME           standard bench scene to draw (default particle_fountain)\n");
+    printf("  --steps N              steps before capturing the snapshot (default 120)\n");
+    printf("  --trails               give every body a motion trail\n");
+    printf("  --frames N             frames timed per render path (default 100)\n");
+    printf("  --size W H             framebuffer size (default 1280 720)\n");
+    printf("  --path NAME            immediate | instanced (default both)\n");
+    printf("  --cull on|off          only with culling and LODs on or off (default both)\n");
+    printf("  --camera outside|inside  view the whole world from outside, or look along -z\n");
+    printf("                         from its center (default outside)\n");
+    printf("  --image PREFIX         write each run's last frame to PREFIX_<path>_<cull>.ppm\n");
+}
+
+// Compatibility-profile context on the surfaceless platform, drawing into an FBO
+static bool offscreen_create(OffscreenContext* ctx, int width, int height) {
+    memset(ctx, 0, sizeof(OffscreenContext));
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    ctx->display = get_platform_display
+        ? get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL)
+        : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (ctx->display == EGL_NO_DISPLAY || !eglInitialize(ctx->display, NULL, NULL)) return false;
+    if (!eglBindAPI(EGL_OPENGL_API)) return false;
+
+    const EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = NULL;
+    EGLint configs = 0;
+    eglChooseConfig(ctx->display, config_attribs, &config, 1, &configs);
+    ctx->context = eglCreateContext(ctx->display, configs > 0 ? config : (EGLConfig)0, EGL_NO_CONTEXT, NULL);
+    if (ctx->context == EGL_NO_CONTEXT) return false;
+    if (!eglMakeCurrent(ctx->display, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx->context)) return false;
+
+    glGenFramebuffers(1, &ctx->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx->framebuffer);
+    glGenRenderbuffers(1, &ctx->color);
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx->color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ctx->color);
+    glGenRenderbuffers(1, &ctx->depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx->depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, ctx->depth);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void offscreen_destroy(OffscreenContext* ctx) {
+    if (ctx->framebuffer) {
+        GLuint renderbuffers[2] = { ctx->color, ctx->depth };
+        glDeleteRenderbuffers(2, renderbuffers);
+        glDeleteFramebuffers(1, &ctx->framebuffer);
+    }
+    if (ctx->display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(ctx->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (ctx->context != EGL_NO_CONTEXT) eglDestroyContext(ctx->display, ctx->context);
+        eglTerminate(ctx->display);
+    }
+}
+
+// Outside the world, above it, looking at its center; or at the center looking along -z
+static void place_camera(float world_size, bool inside) {
+    float h = world_size / 2.0f;
+    g_camera.pos = inside ? (Vec3){ 0.0f, 0.0f, 0.0f } : (Vec3){ 0.0f, 0.6f * h, 1.8f * h };
+    g_camera.yaw = -90.0f;
+    g_camera.pitch = inside ? 0.0f : -RAD2DEG(atan2f(g_camera.pos.y, g_camera.pos.z));
+    renderer_update_camera_mouse(0.0f, 0.0f);
+}
+
+// Binary PPM, top row first
+static bool write_ppm(const char* path, const unsigned char* pixels, int width, int height) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    for (int y = height - 1; y >= 0; y--) {
+        for (int x = 0; x < width; x++) fwrite(&pixels[((size_t)y * width + x) * 4], 1, 3, f);
+    }
+    return fclose(f) == 0;
+}
+
+// Pixels that differ from the clear color; the frame is saved if image is set
+static int covered_pixels(int width, int height, const char* image) {
+    unsigned char* pixels = malloc((size_t)width * height * 4);
+    if (!pixels) return -1;
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    if (image && !write_ppm(image, pixels, width, height)) fprintf(stderr, "failed to write '%s'\n", image);
+    unsigned char clear[4];
+    GLfloat c[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, c);
+    for (int k = 0; k < 4; k++) clear[k] = (unsigned char)lrintf(c[k] * 255.0f);
+    int covered = 0;
+    for (int i = 0; i < width * height; i++) {
+        if (memcmp(&pixels[i * 4], clear, 3) != 0) covered++;
+    }
+    free(pixels);
+    return covered;
+}
+
+static void run_path(RenderPath path, bool cull, const RenderSnapshot* snap, int frames, int width, int height,
+                     const char* image_prefix) {
+    if (!renderer_set_path(path)) {
+        printf("%-10s unavailable in this context\n", renderer_path_name(path));
+        return;
+    }
+    renderer_set_culling(cull);
+    // Warm-up: buffer allocation and shader compilation happen here
+    for (int f = 0; f < 3; f++) renderer_render_snapshot(snap);
+    glFinish();
+
+    uint64_t submit_ns = 0;
+    uint64_t start = timer_now_ns();
+    for (int f = 0; f < frames; f++) {
+        renderer_render_snapshot(snap);
+        submit_ns += renderer_stats()->submit_ns;
+        glFinish();
+    }
+    double frame_ns = (double)(timer_now_ns() - start) / frames;
+
+    char image[512];
+    if (image_prefix) {
+        snprintf(image, sizeof(image), "%s_%s_%s.ppm", image_prefix, renderer_path_name(path), cull ? "cull" : "all");
+    }
+    const RenderStats* s = renderer_stats();
+    printf("%-10s %-4s %9.3f ms/frame | submit %8.3f ms | draw calls %6d | triangles %8ld | covered px %d\n",
+           renderer_path_name(path), cull ? "cull" : "all", frame_ns * 1e-6, (double)submit_ns / frames * 1e-6,
+           s->draw_calls, s->triangles, covered_pixels(width, height, image_prefix ? image : NULL));
+    printf("%15s bodies %6d drawn %6d culled | trails %6d culled | particles %7d drawn %7d culled | nodes tested %d\n",
+           "", s->bodies, s->bodies_culled, s->trails_culled, s->particles, s->particles_culled, s->cull_nodes_tested);
+    printf("%15s sphere LODs", "");
+    for (int l = 0; l < RENDERER_SPHERE_LODS; l++) {
+        printf(" %d:%d", renderer_sphere_segments(l), s->lod_spheres[l]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    const char* scene_name = "particle_fountain";
+    int steps = 120;
+    int frames = 100;
+    int width = 1280, height = 720;
+    int only_path = -1;
+    int only_cull = -1;
+    bool inside = false;
+    bool trails = false;
+    const char* image_prefix = NULL;
+    float dt = 1.0f / 60.0f;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_next = i + 1 < argc;
+        if (strcmp(arg, "--scene") == 0 && has_next) {
+            scene_name = argv[++i];
+        } else if (strcmp(arg, "--steps") == 0 && has_next) {
+            steps = atoi(argv[++i]);
+        } else if (strcmp(arg, "--trails") == 0) {
+            trails = true;
+        } else if (strcmp(arg, "--frames") == 0 && has_next) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--size") == 0 && i + 2 < argc) {
+            width = atoi(argv[++i]);
+            height = atoi(argv[++i]);
+        } else if (strcmp(arg, "--path") == 0 && has_next) {
+            const char* name = argv[++i];
+            if (strcmp(name, "immediate") == 0) only_path = RENDER_PATH_IMMEDIATE;
+            else if (strcmp(name, "instanced") == 0) only_path = RENDER_PATH_INSTANCED;
+            else {
+                fprintf(stderr, "unknown render path '%s'\n", name);
+                return 1;
+            }
+        } else if (strcmp(arg, "--cull") == 0 && has_next) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "on") == 0) only_cull = 1;
+            else if (strcmp(mode, "off") == 0) only_cull = 0;
+            else {
+                fprintf(stderr, "unknown culling mode '%s'\n", mode);
+                return 1;
+            }
+        } else if (strcmp(arg, "--camera") == 0 && has_next) {
+            const char* place = argv[++i];
+            if (strcmp(place, "inside") == 0) inside = true;
+            else if (strcmp(place, "outside") == 0) inside = false;
+            else {
+                fprintf(stderr, "unknown camera placement '%s'\n", place);
+                return 1;
+            }
+        } else if (strcmp(arg, "--image") == 0 && has_next) {
+            image_prefix = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    const BenchSceneParams* found = bench_find_scene(scene_name);
+    if (!found) {
+        fprintf(stderr, "unknown scene '%s'\n", scene_name);
+        return 1;
+    }
+    BenchSceneParams workload = *found;
+    workload.trails = trails;
+    const BenchSceneParams* params = &workload;
+
+    OffscreenContext ctx;
+    if (!offscreen_create(&ctx, width, height)) {
+        fprintf(stderr, "no offscreen GL context (EGL surfaceless)\n");
+        offscreen_destroy(&ctx);
+        return 1;
+    }
+    printf("%s | %s | %dx%d\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION),
+           width, height);
+
+    Scene* scene = malloc(sizeof(Scene));
+    if (!scene) return 1;
+    BenchResult result;
+    bench_build_scene(scene, params);
+    bench_run(scene, params, steps, dt, &result);
+    RenderSnapshot snap;
+    memset(&snap, 0, sizeof(RenderSnapshot));
+    render_snapshot_capture(&snap, scene, NULL);
+    printf("%s after %d steps: %d bodies, %d trails, %d particles, %d cull nodes\n", params->name, steps,
+           snap.body_count, snap.trail_count, snap.particle_count, snap.cull_node_count);
+
+    renderer_init();
+    renderer_resize(width, height);
+    place_camera(snap.world_size, inside);
+    for (int p = RENDER_PATH_IMMEDIATE; p <= RENDER_PATH_INSTANCED; p++) {
+        if (only_path >= 0 && only_path != p) continue;
+        for (int cull = 0; cull <= 1; cull++) {
+            if (only_cull < 0 || only_cull == cull) {
+                run_path((RenderPath)p, cull, &snap, frames, width, height, image_prefix);
+            }
+        }
+    }
+
+    render_snapshot_free(&snap);
+    scene_destroy(scene);
+    free(scene);
+    offscreen_destroy(&ctx);
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include "render_snapshot.h"
+#include "mem.h"
+#include "timer.h"
+#include <math.h>
+#include <string.h>
+
+void render_snapshot_free(RenderSnapshot* snap) {
+    mem_free(snap->prev_position);
+    mem_free(snap->prev_orientation);
+    mem_free(snap->position);
+    mem_free(snap->orientation);
+    mem_free(snap->color);
+    mem_free(snap->radius);
+    mem_free(snap->shape);
+    mem_free(snap->half_extents);
+    mem_free(snap->trail_body);
+    mem_free(snap->trail);
+    mem_free(snap->trail_bounds);
+    mem_free(snap->cull_nodes);
+    mem_free(snap->cull_bodies);
+    mem_free(snap->cull_taken);
+    mem_free(snap->particle_position);
+    mem_free(snap->particle_color);
+    mem_free(snap->particle_alpha);
+    memset(snap, 0, sizeof(RenderSnapshot));
+}
+
+// Realloc that leaves the old block in place (and clears ok) on failure
+static void* render_snapshot_grow(void* array, size_t size, int capacity, bool* ok) {
+    void* grown = mem_realloc(array, (size_t)capacity * size);
+    if (grown) return grown;
+    *ok = false;
+    return array;
+}
+
+// Arrays that did grow keep their larger block; capacity only moves once all have
+static bool render_snapshot_reserve_bodies(RenderSnapshot* snap, int count) {
+    if (count <= snap->body_capacity) return true;
+    int capacity = snap->body_capacity ? snap->body_capacity : 64;
+    while (capacity < count) capacity *= 2;
+    bool ok = true;
+    snap->prev_position = render_snapshot_grow(snap->prev_position, sizeof(Vec3), capacity, &ok);
+    snap->prev_orientation = render_snapshot_grow(snap->prev_orientation, sizeof(Quat), capacity, &ok);
+    snap->position = render_snapshot_grow(snap->position, sizeof(Vec3), capacity, &ok);
+    snap->orientation = render_snapshot_grow(snap->orientation, sizeof(Quat), capacity, &ok);
+    snap->color = render_snapshot_grow(snap->color, sizeof(Vec3), capacity, &ok);
+    snap->radius = render_snapshot_grow(snap->radius, sizeof(float), capacity, &ok);
+    snap->shape = render_snapshot_grow(snap->shape, sizeof(uint8_t), capacity, &ok);
+    snap->half_extents = render_snapshot_grow(snap->half_extents, sizeof(Vec3), capacity, &ok);
+    snap->cull_bodies = render_snapshot_grow(snap->cull_bodies, sizeof(int), capacity, &ok);
+    snap->cull_taken = render_snapshot_grow(snap->cull_taken, sizeof(uint8_t), capacity, &ok);
+    if (ok) snap->body_capacity = capacity;
+    return ok;
+}
+
+static bool render_snapshot_reserve_trails(RenderSnapshot* snap, int count) {
+    if (count <= snap->trail_capacity) return true;
+    int capacity = snap->trail_capacity ? snap->trail_capacity : 16;
+    while (capacity < count) capacity *= 2;
+    bool ok = true;
+    snap->trail_body = render_snapshot_grow(snap->trail_body, sizeof(int), capacity, &ok);
+    snap->trail = render_snapshot_grow(snap->trail, TRAIL_LENGTH * sizeof(Vec3), capacity, &ok);
+    snap->trail_bounds = render_snapshot_grow(snap->trail_bounds, sizeof(AABB), capacity, &ok);
+    if (ok) snap->trail_capacity = capacity;
+    return ok;
+}
+
+static bool render_snapshot_reserve_particles(RenderSnapshot* snap, int count) {
+    if (count <= snap->particle_capacity) return true;
+    int capacity = snap->particle_capacity ? snap->particle_capacity : 256;
+    while (capacity < count) capacity *= 2;
+    bool ok = true;
+    snap->particle_position = render_snapshot_grow(snap->particle_position, sizeof(Vec3), capacity, &ok);
+    snap->particle_color = render_snapshot_grow(snap->particle_color, sizeof(Vec3), capacity, &ok);
+    snap->particle_alpha = render_snapshot_grow(snap->particle_alpha, sizeof(float), capacity, &ok);
+    if (ok) snap->particle_capacity = capacity;
+    return ok;
+}
+
+static AABB render_aabb_empty() {
+    return (AABB){ { INFINITY, INFINITY, INFINITY }, { -INFINITY, -INFINITY, -INFINITY } };
+}
+
+static AABB render_aabb_union(AABB a, AABB b) {
+    return (AABB){ { fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z) },
+                   { fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z) } };
+}
+
+static AABB render_aabb_sphere(AABB box, Vec3 c, float r) {
+    return render_aabb_union(box, (AABB){ { c.x - r, c.y - r, c.z - r }, { c.x + r, c.y + r, c.z + r } });
+}
+
+// Appends node's subtree in pre-order; returns its index, or -1 if it has no bodies left to list
+static int render_snapshot_add_node(RenderSnapshot* snap, const OctreeNode* node, int* body_cursor) {
+    if (snap->cull_node_count == snap->cull_node_capacity) {
+        int capacity = snap->cull_node_capacity ? snap->cull_node_capacity * 2 : 64;
+        RenderCullNode* nodes = mem_realloc(snap->cull_nodes, capacity * sizeof(RenderCullNode));
+        if (!nodes) return -1;
+        snap->cull_nodes = nodes;
+        snap->cull_node_capacity = capacity;
+    }
+    int index = snap->cull_node_count++;
+    int body_first = *body_cursor;
+    AABB bounds = render_aabb_empty();
+
+    if (node->is_leaf) {
+        for (int k = 0; k < node->body_count; k++) {
+            int b = node->bodies[k];
+            if (b >= snap->body_count || snap->cull_taken[b]) continue;
+            snap->cull_taken[b] = 1;
+            snap->cull_bodies[(*body_cursor)++] = b;
+            float r = snap->radius[b] * RENDER_AXIS_SCALE;
+            bounds = render_aabb_sphere(render_aabb_sphere(bounds, snap->prev_position[b], r), snap->position[b], r);
+        }
+    } else {
+        for (int o = 0; o < 8; o++) {
+            int child = render_snapshot_add_node(snap, node->children[o], body_cursor);
+            if (child >= 0) bounds = render_aabb_union(bounds, snap->cull_nodes[child].bounds);
+        }
+    }
+
+    if (*body_cursor == body_first) {
+        snap->cull_node_count = index;  // Empty subtree: drop it
+        return -1;
+    }
+    snap->cull_nodes[index] = (RenderCullNode){ bounds, snap->cull_node_count, body_first, *body_cursor, node->is_leaf };
+    return index;
+}
+
+// Bodies the octree does not list go into one extra leaf
+static void render_snapshot_build_cull(RenderSnapshot* snap, const Scene* scene) {
+    snap->cull_node_count = 0;
+    const OctreeNode* root = scene->collision.octree;
+    if (scene->collision.broadphase != BROADPHASE_OCTREE || !root || snap->body_count == 0) return;
+
+    memset(snap->cull_taken, 0, snap->body_count);
+    int cursor = 0;
+    render_snapshot_add_node(snap, root, &cursor);
+    if (cursor == snap->body_count) return;
+
+    int first = cursor;
+    AABB bounds = render_aabb_empty();
+    for (int b = 0; b < snap->body_count; b++) {
+        if (snap->cull_taken[b]) continue;
+        snap->cull_bodies[cursor++] = b;
+        float r = snap->radius[b] * RENDER_AXIS_SCALE;
+        bounds = render_aabb_sphere(render_aabb_sphere(bounds, snap->prev_position[b], r), snap->position[b], r);
+    }
+    RenderCullNode rest = { bounds, snap->cull_node_count + 1, first, cursor, true };
+    if (snap->cull_node_count < snap->cull_node_capacity) snap->cull_nodes[snap->cull_node_count++] = rest;
+    else snap->cull_node_count = 0;  // Out of memory: cull body by body
+}
+
+// Out of memory, only what fits in the snapshot's storage is captured
+void render_snapshot_capture(RenderSnapshot* snap, const Scene* scene, const SceneStepper* stepper) {
+    const BodyStore* bodies = &scene->bodies;
+    int n = bodies->count;
+    if (!render_snapshot_reserve_bodies(snap, n)) n = snap->body_capacity;
+    snap->body_count = n;
+    if (n > 0) {  // The arrays are NULL until first grown
+        memcpy(snap->position, bodies->position, n * sizeof(Vec3));
+        memcpy(snap->orientation, bodies->orientation, n * sizeof(Quat));
+        memcpy(snap->radius, bodies->radius, n * sizeof(float));
+        memcpy(snap->shape, bodies->shape, n * sizeof(uint8_t));
+        memcpy(snap->half_extents, bodies->half_extents, n * sizeof(Vec3));
+    }
+    for (int i = 0; i < n; i++) {
+        if (stepper) {
+            stepper_body_previous(stepper, scene, i, &snap->prev_position[i], &snap->prev_orientation[i]);
+        } else {
+            snap->prev_position[i] = bodies->position[i];
+            snap->prev_orientation[i] = bodies->orientation[i];
+        }
+        snap->color[i] = bodies->visuals[i].color;
+    }
+    render_snapshot_build_cull(snap, scene);
+
+    const TrailStore* trails = &scene->trails;
+    render_snapshot_reserve_trails(snap, trails->count);
+    snap->trail_count = 0;
+    for (int t = 0; t < trails->count && snap->trail_count < snap->trail_capacity; t++) {
+        int body = body_store_index(bodies, trails->body[t]);
+        if (body < 0 || body >= n) continue;
+        int k = snap->trail_count++;
+        Vec3* trail = &snap->trail[(size_t)k * TRAIL_LENGTH];
+        trail_store_read(trails, t, trail);
+        AABB bounds = render_aabb_empty();
+        for (int p = 0; p < TRAIL_LENGTH; p++) bounds = render_aabb_sphere(bounds, trail[p], 0.0f);
+        snap->trail_body[k] = body;
+        snap->trail_bounds[k] = bounds;
+    }
+
+    const ParticleStore* particles = &scene->particles;
+    int m = particles->count;
+    if (!render_snapshot_reserve_particles(snap, m)) m = snap->particle_capacity;
+    snap->particle_count = m;
+    if (m > 0) {
+        memcpy(snap->particle_position, particles->position, m * sizeof(Vec3));
+        memcpy(snap->particle_color, particles->color, m * sizeof(Vec3));
+    }
+    for (int i = 0; i < m; i++) snap->particle_alpha[i] = particles->life[i] / particles->max_life[i];
+
+    snap->sequence = stepper ? stepper->steps : scene->stats.steps;
+    snap->step_dt = stepper ? 1.0f / stepper->step_hz : 0.0f;
+    snap->alpha = stepper ? stepper->alpha : 1.0f;
+    snap->world_size = scene->world_size;
+    snap->checksum = 0;
+    snap->published_ns = timer_now_ns();
+}
+
+static uint64_t render_hash_bytes(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+uint64_t render_snapshot_checksum(const RenderSnapshot* snap) {
+    size_t n = (size_t)snap->body_count;
+    size_t m = (size_t)snap->particle_count;
+    size_t t = (size_t)snap->trail_count;
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = render_hash_bytes(h, &snap->sequence, sizeof(snap->sequence));
+    h = render_hash_bytes(h, &snap->step_dt, sizeof(snap->step_dt));
+    h = render_hash_bytes(h, &snap->alpha, sizeof(snap->alpha));
+    h = render_hash_bytes(h, &snap->world_size, sizeof(snap->world_size));
+    h = render_hash_bytes(h, &snap->body_count, sizeof(snap->body_count));
+    h = render_hash_bytes(h, snap->prev_position, n * sizeof(Vec3));
+    h = render_hash_bytes(h, snap->prev_orientation, n * sizeof(Quat));
+    h = render_hash_bytes(h, snap->position, n * sizeof(Vec3));
+    h = render_hash_bytes(h, snap->orientation, n * sizeof(Quat));
+    h = render_hash_bytes(h, snap->color, n * sizeof(Vec3));
+    h = render_hash_bytes(h, snap->radius, n * sizeof(float));
+    h = render_hash_bytes(h, snap->shape, n * sizeof(uint8_t));
+    h = render_hash_bytes(h, snap->half_extents, n * sizeof(Vec3));
+    h = render_hash_bytes(h, &snap->trail_count, sizeof(snap->trail_count));
+    h = render_hash_bytes(h, snap->trail_body, t * sizeof(int));
+    h = render_hash_bytes(h, snap->trail, t * TRAIL_LENGTH * sizeof(Vec3));
+    h = render_hash_bytes(h, snap->trail_bounds, t * sizeof(AABB));
+    h = render_hash_bytes(h, &snap->cull_node_count, sizeof(snap->cull_node_count));
+    for (int i = 0; i < snap->cull_node_count; i++) {
+        const RenderCullNode* node = &snap->cull_nodes[i];
+        h = render_hash_bytes(h, &node->bounds, sizeof(AABB));
+        h = render_hash_bytes(h, &node->next, sizeof(int));
+        h = render_hash_bytes(h, &node->body_first, sizeof(int));
+        h = render_hash_bytes(h, &node->body_end, sizeof(int));
+    }
+    if (snap->cull_node_count > 0) h = render_hash_bytes(h, snap->cull_bodies, n * sizeof(int));
+    h = render_hash_bytes(h, &snap->particle_count, sizeof(snap->particle_count));
+    h = render_hash_bytes(h, snap->particle_position, m * sizeof(Vec3));
+    h = render_hash_bytes(h, snap->particle_color, m * sizeof(Vec3));
+    h = render_hash_bytes(h, snap->particle_alpha, m * sizeof(float));
+    return h;
+}
+
+float render_snapshot_alpha(const RenderSnapshot* snap, uint64_t now_ns) {
+    if (snap->step_dt <= 0.0f) return 1.0f;
+    float elapsed = now_ns > snap->published_ns ? (float)((now_ns - snap->published_ns) * 1e-9) : 0.0f;
+    float a = snap->alpha + elapsed / snap->step_dt;
+    return a < 1.0f ? a : 1.0f;
+}
+
+void render_snapshot_body_transform(const RenderSnapshot* snap, int index, float alpha, Vec3* position, Quat* orientation) {
+    *position = vec3_lerp(snap->prev_position[index], snap->position[index], alpha);
+    *orientation = quat_nlerp(snap->prev_orientation[index], snap->orientation[index], alpha);
+}
+
+// ============================================================================
+// TRIPLE BUFFER
+// ============================================================================
+
+void render_buffer_init(RenderTripleBuffer* buffer) {
+    memset(buffer, 0, sizeof(RenderTripleBuffer));
+    buffer->back = 0;
+    atomic_init(&buffer->middle, 1u);
+    buffer->front = 2;
+}
+
+void render_buffer_free(RenderTripleBuffer* buffer) {
+    for (int i = 0; i < 3; i++) render_snapshot_free(&buffer->slots[i]);
+}
+
+RenderSnapshot* render_buffer_back(RenderTripleBuffer* buffer) {
+    return &buffer->slots[buffer->back];
+}
+
+// Release: the consumer that takes this slot sees everything written to it
+void render_buffer_publish(RenderTripleBuffer* buffer) {
+    unsigned int old = atomic_exchange_explicit(&buffer->middle, (unsigned int)buffer->back | RENDER_BUFFER_FRESH,
+                                                memory_order_acq_rel);
+    buffer->back = (int)(old & 3u);
+    buffer->published++;
+}
+
+const RenderSnapshot* render_buffer_acquire(RenderTripleBuffer* buffer) {
+    if (atomic_load_explicit(&buffer->middle, memory_order_relaxed) & RENDER_BUFFER_FRESH) {
+        unsigned int old = atomic_exchange_explicit(&buffer->middle, (unsigned int)buffer->front, memory_order_acq_rel);
+        buffer->front = (int)(old & 3u);
+        buffer->acquired++;
+    }
+    const RenderSnapshot* snap = &buffer->slots[buffer->front];
+    return snap->published_ns != 0 ? snap : NULL;
+}
@@ -1,9 +1,26 @@
 #include "renderer.h"
-#include <GL/glut.h>
+#include "renderer_instanced.h"
+#include <GL/glu.h>
 #include "collision.h" // For OctreeNode definition
+#include "mem.h"
+#include "timer.h"
+#include <string.h>
 
 Camera g_camera;
 
+static GLUquadric* g_quadric;
+static bool g_instanced_available;
+static RenderPath g_render_path = RENDER_PATH_IMMEDIATE;
+static RenderStats g_render_stats;
+static RenderVisibility g_visibility;
+static int g_visibility_body_capacity;
+static int g_visibility_trail_capacity;
+static int g_visibility_particle_capacity;
+static bool g_culling = true;
+static float g_viewport_height = 1.0f;
+
+static const int g_sphere_segments[RENDERER_SPHERE_LODS] = { 16, 10, 6, 4 };
+
 void renderer_init() {
     g_camera.pos = (Vec3){0, 10, 40};
     g_camera.yaw = -90.0f;
@@ -25,6 +42,40 @@ void renderer_init() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glClearColor(0.1f, 0.12f, 0.15f, 1.0f);
+    
+    if (!g_quadric) g_quadric = gluNewQuadric();
+    g_instanced_available = renderer_instanced_init();
+    g_render_path = g_instanced_available ? RENDER_PATH_INSTANCED : RENDER_PATH_IMMEDIATE;
+}
+
+bool renderer_set_path(RenderPath path) {
+    if (path == RENDER_PATH_INSTANCED && !g_instanced_available) return false;
+    g_render_path = path;
+    return true;
+}
+
+RenderPath renderer_path() {
+    return g_render_path;
+}
+
+const char* renderer_path_name(RenderPath path) {
+    return path == RENDER_PATH_INSTANCED ? "instanced" : "immediate";
+}
+
+const RenderStats* renderer_stats() {
+    return &g_render_stats;
+}
+
+void renderer_set_culling(bool enabled) {
+    g_culling = enabled;
+}
+
+bool renderer_culling() {
+    return g_culling;
+}
+
+int renderer_sphere_segments(int lod) {
+    return g_sphere_segments[lod];
 }
 
 void renderer_resize(int w, int h) {
@@ -33,8 +84,9 @@ void renderer_resize(int w, int h) {
     glViewport(0,0,w,h);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluPerspective(45.0f, aspect, 0.1f, 500.0f);
+    gluPerspective(RENDERER_FOV_Y, aspect, RENDERER_NEAR, RENDERER_FAR);
     glMatrixMode(GL_MODELVIEW);
+    g_viewport_height = (float)h;
 }
 
 void renderer_update_camera_vectors() {
@@ -63,11 +115,36 @@ void renderer_update_camera_keyboard(bool* keys, float dt) {
     if(keys['d']) g_camera.pos = vec3_add(g_camera.pos, vec3_scale(g_camera.right, vel));
 }
 
-void draw_body(const RigidBody* b) {
+// [-1, 1]³
+static void draw_unit_cube() {
+    glBegin(GL_QUADS);
+    for(int axis=0; axis<3; axis++) {
+        for(int sign=-1; sign<=1; sign+=2) {
+            float n[3] = {0, 0, 0};
+            n[axis] = (float)sign;
+            glNormal3fv(n);
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+            const float corners[4][2] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+            for(int k=0; k<4; k++) {
+                float p[3];
+                p[axis] = (float)sign;
+                p[u] = corners[sign > 0 ? k : 3 - k][0];
+                p[v] = corners[sign > 0 ? k : 3 - k][1];
+                glVertex3fv(p);
+            }
+        }
+    }
+    glEnd();
+}
+
+void draw_body(const RenderSnapshot* snap, int index, Vec3 position, Quat orientation, int lod) {
+    Vec3 color = snap->color[index];
+    float radius = snap->radius[index];
+    
     glPushMatrix();
     
     // 1. Transform Matrix from Position & Quaternion
-    Mat4 transform = mat4_from_quat_pos(b->orientation, b->position);
+    Mat4 transform = mat4_from_quat_pos(orientation, position);
     
     // OpenGL expects column-major, and our logic might be row-major,
     // but the `mat4_from_quat_pos` output was designed for logic.
@@ -81,52 +158,259 @@ void draw_body(const RigidBody* b) {
     
     glMultMatrixf(m);
 
-    // 2. Draw Sphere
-    glColor3f(b->color.x, b->color.y, b->color.z);
-    glutSolidSphere(b->radius, 16, 16);
+    // 2. Draw Shape
+    glColor3f(color.x, color.y, color.z);
+    if (snap->shape[index] == SHAPE_BOX) {
+        Vec3 h = snap->half_extents[index];
+        glPushMatrix();
+        glScalef(h.x, h.y, h.z);
+        draw_unit_cube();
+        glPopMatrix();
+        g_render_stats.draw_calls++;
+    } else {
+        int segments = g_sphere_segments[lod];
+        gluSphere(g_quadric, radius, segments, segments);
+        g_render_stats.draw_calls += segments; // One strip per stack
+    }
     
     // 3. Draw Local Axes to visualize rotation
     glDisable(GL_LIGHTING);
     glBegin(GL_LINES);
-    glColor3f(1,0,0); glVertex3f(0,0,0); glVertex3f(b->radius*1.5f, 0, 0);
-    glColor3f(0,1,0); glVertex3f(0,0,0); glVertex3f(0, b->radius*1.5f, 0);
-    glColor3f(0,0,1); glVertex3f(0,0,0); glVertex3f(0, 0, b->radius*1.5f);
+    float axis = radius * RENDER_AXIS_SCALE;
+    glColor3f(1,0,0); glVertex3f(0,0,0); glVertex3f(axis, 0, 0);
+    glColor3f(0,1,0); glVertex3f(0,0,0); glVertex3f(0, axis, 0);
+    glColor3f(0,0,1); glVertex3f(0,0,0); glVertex3f(0, 0, axis);
     glEnd();
+    g_render_stats.draw_calls++;
     glEnable(GL_LIGHTING);
     
     glPopMatrix();
-    
-    // 4. Draw Trail (World Space)
+}
+
+// World space, fading in from the oldest point; every trail in one block of segments
+void draw_trails(const RenderSnapshot* snap, const RenderVisibility* vis) {
+    if (vis->trail_count == 0) return;
     glDisable(GL_LIGHTING);
     glLineWidth(1.0f);
-    glBegin(GL_LINE_STRIP);
-    for(int i=0; i<TRAIL_LENGTH; i++) {
-        int idx = (b->trail_head + i) % TRAIL_LENGTH;
-        float alpha = (float)i/TRAIL_LENGTH;
-        glColor4f(b->color.x, b->color.y, b->color.z, alpha);
-        glVertex3f(b->trail[idx].x, b->trail[idx].y, b->trail[idx].z);
+    glBegin(GL_LINES);
+    for(int k=0; k<vis->trail_count; k++) {
+        int t = vis->trails[k];
+        Vec3 color = snap->color[snap->trail_body[t]];
+        const Vec3* trail = &snap->trail[(size_t)t * TRAIL_LENGTH];
+        for(int i=1; i<TRAIL_LENGTH; i++) {
+            glColor4f(color.x, color.y, color.z, (float)(i-1)/TRAIL_LENGTH);
+            glVertex3f(trail[i-1].x, trail[i-1].y, trail[i-1].z);
+            glColor4f(color.x, color.y, color.z, (float)i/TRAIL_LENGTH);
+            glVertex3f(trail[i].x, trail[i].y, trail[i].z);
+        }
     }
     glEnd();
+    g_render_stats.draw_calls++;
     glEnable(GL_LIGHTING);
 }
 
-void draw_particles(const Scene* scene) {
+void draw_particles(const RenderSnapshot* snap, const RenderVisibility* vis) {
     glDisable(GL_LIGHTING);
     glPointSize(3.0f);
     glBegin(GL_POINTS);
-    for(int i=0; i<MAX_PARTICLES; i++) {
-        const Particle* p = &scene->particles[i];
-        if(p->active) {
-            float alpha = p->life / p->max_life;
-            glColor4f(p->color.x, p->color.y, p->color.z, alpha);
-            glVertex3f(p->position.x, p->position.y, p->position.z);
-        }
+    for(int k=0; k<vis->particle_count; k++) {
+        int i = vis->particles[k];
+        Vec3 c = snap->particle_color[i], x = snap->particle_position[i];
+        glColor4f(c.x, c.y, c.z, snap->particle_alpha[i]);
+        glVertex3f(x.x, x.y, x.z);
     }
     glEnd();
+    g_render_stats.draw_calls++;
     glEnable(GL_LIGHTING);
 }
 
-void renderer_render_scene(const Scene* scene) {
+static void draw_aabb_wire(AABB b) {
+    glBegin(GL_LINES);
+    for(int i=0; i<4; i++) {
+        // Edges along x, y and z at the four combinations of the other two axes
+        float u = (i & 1) ? b.max.y : b.min.y, v = (i & 2) ? b.max.z : b.min.z;
+        glVertex3f(b.min.x, u, v); glVertex3f(b.max.x, u, v);
+        u = (i & 1) ? b.max.x : b.min.x; v = (i & 2) ? b.max.z : b.min.z;
+        glVertex3f(u, b.min.y, v); glVertex3f(u, b.max.y, v);
+        u = (i & 1) ? b.max.x : b.min.x; v = (i & 2) ? b.max.y : b.min.y;
+        glVertex3f(u, v, b.min.z); glVertex3f(u, v, b.max.z);
+    }
+    glEnd();
+}
+
+static void draw_octree_node(const OctreeNode* node) {
+    if(!node) return;
+    if(node->is_leaf) {
+        if(node->body_count == 0) return;
+        glColor4f(0.2f, 0.8f, 0.3f, 0.35f);
+        draw_aabb_wire(node->bounds);
+        return;
+    }
+    for(int o=0; o<8; o++) draw_octree_node(node->children[o]);
+}
+
+// Wireframe of the occupied octree leaves
+void renderer_debug_octree(struct OctreeNode* node) {
+    glDisable(GL_LIGHTING);
+    draw_octree_node(node);
+    glEnable(GL_LIGHTING);
+}
+
+// ============================================================================
+// CULLING
+// ============================================================================
+
+static bool visibility_reserve(int bodies, int trails, int particles) {
+    RenderVisibility* vis = &g_visibility;
+    if (bodies > g_visibility_body_capacity) {
+        int capacity = g_visibility_body_capacity ? g_visibility_body_capacity : 64;
+        while (capacity < bodies) capacity *= 2;
+        int* list = mem_realloc(vis->bodies, capacity * sizeof(int));
+        if (list) vis->bodies = list;
+        Vec3* position = mem_realloc(vis->position, capacity * sizeof(Vec3));
+        if (position) vis->position = position;
+        Quat* orientation = mem_realloc(vis->orientation, capacity * sizeof(Quat));
+        if (orientation) vis->orientation = orientation;
+        uint8_t* lod = mem_realloc(vis->lod, capacity * sizeof(uint8_t));
+        if (lod) vis->lod = lod;
+        if (!list || !position || !orientation || !lod) return false;
+        g_visibility_body_capacity = capacity;
+    }
+    if (trails > g_visibility_trail_capacity) {
+        int capacity = g_visibility_trail_capacity ? g_visibility_trail_capacity : 16;
+        while (capacity < trails) capacity *= 2;
+        int* list = mem_realloc(vis->trails, capacity * sizeof(int));
+        if (!list) return false;
+        vis->trails = list;
+        g_visibility_trail_capacity = capacity;
+    }
+    if (particles > g_visibility_particle_capacity) {
+        int capacity = g_visibility_particle_capacity ? g_visibility_particle_capacity : 256;
+        while (capacity < particles) capacity *= 2;
+        int* list = mem_realloc(vis->particles, capacity * sizeof(int));
+        if (!list) return false;
+        vis->particles = list;
+        g_visibility_particle_capacity = capacity;
+    }
+    return true;
+}
+
+// P V as the GL state holds it after gluLookAt
+static void view_frustum(Frustum* frustum) {
+    float p[16], v[16], clip[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, p);
+    glGetFloatv(GL_MODELVIEW_MATRIX, v);
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            clip[c * 4 + r] = p[r] * v[c * 4] + p[4 + r] * v[c * 4 + 1] + p[8 + r] * v[c * 4 + 2] + p[12 + r] * v[c * 4 + 3];
+        }
+    }
+    frustum_from_matrix(frustum, clip);
+}
+
+// Finest level whose threshold r_px reaches; boxes keep level 0
+static uint8_t sphere_lod(const RenderSnapshot* snap, int index, Vec3 position, float pixels_per_unit) {
+    static const float thresholds[RENDERER_SPHERE_LODS] = RENDERER_LOD_PIXELS;
+    if (snap->shape[index] == SHAPE_BOX) return 0;
+    float d = sqrtf(vec3_dist_sq(position, g_camera.pos));
+    if (d <= snap->radius[index]) return 0;
+    float r_px = snap->radius[index] * pixels_per_unit / d;
+    uint8_t lod = 0;
+    while (lod + 1 < RENDERER_SPHERE_LODS && r_px < thresholds[lod]) lod++;
+    return lod;
+}
+
+// Appends body i if its axes' sphere at x⃗ is in view (test) or unconditionally
+static void visibility_add_body(const RenderSnapshot* snap, const Frustum* frustum, int i, float alpha,
+                                bool test, float pixels_per_unit) {
+    RenderVisibility* vis = &g_visibility;
+    Vec3 x;
+    Quat q;
+    render_snapshot_body_transform(snap, i, alpha, &x, &q);
+    if (test && !frustum_test_sphere(frustum, x, snap->radius[i] * RENDER_AXIS_SCALE)) return;
+    int k = vis->body_count++;
+    vis->bodies[k] = i;
+    vis->position[k] = x;
+    vis->orientation[k] = q;
+    vis->lod[k] = frustum ? sphere_lod(snap, i, x, pixels_per_unit) : 0;
+}
+
+/*
+ * build_visibility
+ * With a snapshot hierarchy, a node outside the frustum skips its subtree,
+ * one inside accepts every body under it untested, and a straddling leaf
+ * tests its bodies one by one. Without one, every body is tested. Trails
+ * are tested by their bounds and particles as points.
+ */
+static void build_visibility(const RenderSnapshot* snap, float alpha) {
+    RenderVisibility* vis = &g_visibility;
+    vis->body_count = vis->trail_count = vis->particle_count = 0;
+    if (!visibility_reserve(snap->body_count, snap->trail_count, snap->particle_count)) return;
+
+    if (!g_culling) {
+        for (int i = 0; i < snap->body_count; i++) visibility_add_body(snap, NULL, i, alpha, false, 0.0f);
+        for (int t = 0; t < snap->trail_count; t++) vis->trails[vis->trail_count++] = t;
+        for (int i = 0; i < snap->particle_count; i++) vis->particles[vis->particle_count++] = i;
+        return;
+    }
+
+    Frustum frustum;
+    view_frustum(&frustum);
+    float pixels_per_unit = 0.5f * g_viewport_height / tanf(DEG2RAD(RENDERER_FOV_Y) * 0.5f);
+    if (snap->cull_node_count > 0) {
+        int node = 0;
+        while (node < snap->cull_node_count) {
+            const RenderCullNode* n = &snap->cull_nodes[node];
+            g_render_stats.cull_nodes_tested++;
+            FrustumResult result = frustum_test_aabb(&frustum, n->bounds);
+            if (result == FRUSTUM_OUTSIDE) {
+                node = n->next;
+                continue;
+            }
+            if (result == FRUSTUM_INSIDE || n->leaf) {
+                for (int k = n->body_first; k < n->body_end; k++) {
+                    visibility_add_body(snap, &frustum, snap->cull_bodies[k], alpha, result != FRUSTUM_INSIDE,
+                                        pixels_per_unit);
+                }
+                node = n->next;
+                continue;
+            }
+            node++;
+        }
+    } else {
+        for (int i = 0; i < snap->body_count; i++) visibility_add_body(snap, &frustum, i, alpha, true, pixels_per_unit);
+    }
+
+    for (int t = 0; t < snap->trail_count; t++) {
+        if (frustum_test_aabb(&frustum, snap->trail_bounds[t]) != FRUSTUM_OUTSIDE) vis->trails[vis->trail_count++] = t;
+    }
+    for (int i = 0; i < snap->particle_count; i++) {
+        if (frustum_test_point(&frustum, snap->particle_position[i])) vis->particles[vis->particle_count++] = i;
+    }
+}
+
+// Triangles submitted for the visible bodies, and spheres per LOD
+static void count_body_stats(const RenderSnapshot* snap, const RenderVisibility* vis) {
+    for (int k = 0; k < vis->body_count; k++) {
+        if (snap->shape[vis->bodies[k]] == SHAPE_BOX) {
+            g_render_stats.triangles += 12;
+        } else {
+            int segments = g_sphere_segments[vis->lod[k]];
+            g_render_stats.lod_spheres[vis->lod[k]]++;
+            g_render_stats.triangles += 2L * segments * segments;
+        }
+    }
+    g_render_stats.bodies = vis->body_count;
+    g_render_stats.bodies_culled = snap->body_count - vis->body_count;
+    g_render_stats.particles = vis->particle_count;
+    g_render_stats.particles_culled = snap->particle_count - vis->particle_count;
+    g_render_stats.trail_vertices = vis->trail_count * TRAIL_LENGTH;
+    g_render_stats.trails_culled = snap->trail_count - vis->trail_count;
+}
+
+void renderer_render_snapshot(const RenderSnapshot* snap) {
+    uint64_t start = timer_now_ns();
+    memset(&g_render_stats, 0, sizeof(RenderStats));
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
@@ -136,25 +420,35 @@ void renderer_render_scene(const Scene* scene) {
               g_camera.pos.y + g_camera.front.y,
               g_camera.pos.z + g_camera.front.z,
               g_camera.up.x, g_camera.up.y, g_camera.up.z);
+    
+    if (!snap) return;
               
     // Draw Floor Grid
     glDisable(GL_LIGHTING);
     glColor3f(0.3f, 0.3f, 0.3f);
     glBegin(GL_LINES);
-    float sz = scene->world_size/2.0f;
+    float sz = snap->world_size/2.0f;
     for(float i=-sz; i<=sz; i+=2.0f) {
         glVertex3f(i, -sz, -sz); glVertex3f(i, -sz, sz);
         glVertex3f(-sz, -sz, i); glVertex3f(sz, -sz, i);
     }
     glEnd();
     glEnable(GL_LIGHTING);
+    g_render_stats.draw_calls++;
     
-    // Draw Bodies
-    for(int i=0; i<scene->body_count; i++) {
-        draw_body(&scene->bodies[i]);
+    float alpha = render_snapshot_alpha(snap, timer_now_ns());
+    const RenderVisibility* vis = &g_visibility;
+    build_visibility(snap, alpha);
+    count_body_stats(snap, vis);
+    if (g_render_path == RENDER_PATH_INSTANCED) {
+        renderer_instanced_draw(snap, vis, &g_render_stats);
+    } else {
+        // Draw Bodies
+        for(int k=0; k<vis->body_count; k++) {
+            draw_body(snap, vis->bodies[k], vis->position[k], vis->orientation[k], vis->lod[k]);
+        }
+        draw_trails(snap, vis);
+        draw_particles(snap, vis);
     }
-    
-    draw_particles(scene);
-    
-    glutSwapBuffers();
-}
\ No newline at end of file
+    g_render_stats.submit_ns = timer_now_ns() - start;
+}
@@ -0,0 +1,472 @@
+#define GL_GLEXT_PROTOTYPES
+#include "renderer_instanced.h"
+#include "mem.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// Vertex attribute locations
+enum {
+    ATTR_VERTEX,
+    ATTR_NORMAL,
+    ATTR_AXIS_COLOR,
+    ATTR_CENTER,                // Per instance from here on
+    ATTR_ORIENTATION,
+    ATTR_SCALE,
+    ATTR_COLOR,
+};
+
+// One body. Spheres come first in the buffer, grouped by LOD, then boxes.
+typedef struct {
+    float center[4];            // x⃗, bounding radius (axis length)
+    float orientation[4];       // q as (x, y, z, w)
+    float scale[3];             // r for spheres, half extents for boxes
+    float color[3];
+} Instance;
+
+// Trail and particle vertex
+typedef struct {
+    float position[3];
+    float color[4];
+} StreamVertex;
+
+typedef struct {
+    GLuint program;
+    GLint u_lit;
+
+    GLuint sphere_vbo[RENDERER_SPHERE_LODS];    // Unit spheres, position = normal
+    GLuint sphere_ibo[RENDERER_SPHERE_LODS];
+    int sphere_index_count[RENDERER_SPHERE_LODS];
+    GLuint cube_vbo;            // [-1, 1]³ with face normals
+    int cube_vertex_count;
+    GLuint axes_vbo;            // Three unit lines with colors
+
+    GLuint instance_vbo;
+    Instance* instances;
+    int instance_capacity;
+
+    GLuint stream_vbo;
+    StreamVertex* stream;
+    int stream_capacity;
+
+    // glMultiDrawArrays ranges, one per visible trail
+    GLint* trail_first;
+    GLsizei* trail_count;
+    int trail_capacity;
+} InstancedRenderer;
+
+static InstancedRenderer g_instanced;
+
+/*
+ * Lighting matches the fixed-function path: GL_COLOR_MATERIAL with the
+ * global and light-0 ambient terms plus light-0 diffuse. Normals of scaled
+ * boxes are divided by the scale, the inverse transpose of a diagonal scale.
+ */
+static const char* g_vertex_shader =
+    "#version 120\n"
+    "attribute vec3 a_vertex;\n"
+    "attribute vec3 a_normal;\n"
+    "attribute vec3 a_axis_color;\n"
+    "attribute vec4 a_center;\n"
+    "attribute vec4 a_orientation;\n"
+    "attribute vec3 a_scale;\n"
+    "attribute vec3 a_color;\n"
+    "uniform float u_lit;\n"
+    "varying vec4 v_color;\n"
+    "vec3 rotate(vec4 q, vec3 v) {\n"
+    "    vec3 t = 2.0 * cross(q.xyz, v);\n"
+    "    return v + q.w * t + cross(q.xyz, t);\n"
+    "}\n"
+    "void main() {\n"
+    "    if (u_lit > 0.5) {\n"
+    "        vec3 p = a_center.xyz + rotate(a_orientation, a_vertex * a_scale);\n"
+    "        vec3 n = normalize(gl_NormalMatrix * rotate(a_orientation, a_normal / a_scale));\n"
+    "        vec3 eye = (gl_ModelViewMatrix * vec4(p, 1.0)).xyz;\n"
+    "        vec3 l = normalize(gl_LightSource[0].position.xyz - eye);\n"
+    "        vec3 light = gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb\n"
+    "                   + gl_LightSource[0].diffuse.rgb * max(dot(n, l), 0.0);\n"
+    "        v_color = vec4(min(a_color * light, 1.0), 1.0);\n"
+    "        gl_Position = gl_ModelViewProjectionMatrix * vec4(p, 1.0);\n"
+    "    } else {\n"
+    "        vec3 p = a_center.xyz + rotate(a_orientation, a_vertex * a_center.w);\n"
+    "        v_color = vec4(a_axis_color, 1.0);\n"
+    "        gl_Position = gl_ModelViewProjectionMatrix * vec4(p, 1.0);\n"
+    "    }\n"
+    "}\n";
+
+static const char* g_fragment_shader =
+    "#version 120\n"
+    "varying vec4 v_color;\n"
+    "void main() {\n"
+    "    gl_FragColor = v_color;\n"
+    "}\n";
+
+static GLuint instanced_compile(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "instanced renderer: shader: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint instanced_link() {
+    GLuint vs = instanced_compile(GL_VERTEX_SHADER, g_vertex_shader);
+    GLuint fs = instanced_compile(GL_FRAGMENT_SHADER, g_fragment_shader);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glBindAttribLocation(program, ATTR_VERTEX, "a_vertex");
+    glBindAttribLocation(program, ATTR_NORMAL, "a_normal");
+    glBindAttribLocation(program, ATTR_AXIS_COLOR, "a_axis_color");
+    glBindAttribLocation(program, ATTR_CENTER, "a_center");
+    glBindAttribLocation(program, ATTR_ORIENTATION, "a_orientation");
+    glBindAttribLocation(program, ATTR_SCALE, "a_scale");
+    glBindAttribLocation(program, ATTR_COLOR, "a_color");
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        fprintf(stderr, "instanced renderer: link: %s\n", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// ============================================================================
+// MESHES
+// ============================================================================
+
+// Interleaved position and normal
+static void instanced_build_sphere(int lod) {
+    const int slices = renderer_sphere_segments(lod), stacks = slices;
+    int vertex_count = (slices + 1) * (stacks + 1);
+    float* vertices = mem_malloc(vertex_count * 6 * sizeof(float));
+    GLushort* indices = mem_malloc(slices * stacks * 6 * sizeof(GLushort));
+    if (!vertices || !indices) {
+        mem_free(vertices);
+        mem_free(indices);
+        return;
+    }
+
+    float* v = vertices;
+    for (int j = 0; j <= stacks; j++) {
+        float phi = PI * j / stacks;
+        for (int i = 0; i <= slices; i++) {
+            float theta = 2.0f * PI * i / slices;
+            float n[3] = { sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta) };
+            for (int k = 0; k < 3; k++) v[k] = v[3 + k] = n[k];
+            v += 6;
+        }
+    }
+    int count = 0;
+    for (int j = 0; j < stacks; j++) {
+        for (int i = 0; i < slices; i++) {
+            GLushort a = (GLushort)(j * (slices + 1) + i), b = (GLushort)(a + slices + 1);
+            GLushort quad[6] = { a, b, (GLushort)(a + 1), (GLushort)(a + 1), b, (GLushort)(b + 1) };
+            memcpy(&indices[count], quad, sizeof(quad));
+            count += 6;
+        }
+    }
+
+    glGenBuffers(1, &g_instanced.sphere_vbo[lod]);
+    glBindBuffer(GL_ARRAY_BUFFER, g_instanced.sphere_vbo[lod]);
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * 6 * sizeof(float), vertices, GL_STATIC_DRAW);
+    glGenBuffers(1, &g_instanced.sphere_ibo[lod]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_instanced.sphere_ibo[lod]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLushort), indices, GL_STATIC_DRAW);
+    g_instanced.sphere_index_count[lod] = count;
+    mem_free(vertices);
+    mem_free(indices);
+}
+
+// Two triangles per face of [-1, 1]³
+static void instanced_build_cube() {
+    float vertices[36 * 6];
+    float* v = vertices;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int u = (axis + 1) % 3, w = (axis + 2) % 3;
+            // Corners counter-clockwise seen from outside
+            float corners[4][2] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+            int order[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int k = 0; k < 6; k++) {
+                const float* c = corners[sign > 0 ? order[k] : order[5 - k]];
+                float p[3], n[3] = { 0, 0, 0 };
+                p[axis] = (float)sign;
+                p[u] = c[0];
+                p[w] = c[1];
+                n[axis] = (float)sign;
+                memcpy(v, p, sizeof(p));
+                memcpy(v + 3, n, sizeof(n));
+                v += 6;
+            }
+        }
+    }
+    glGenBuffers(1, &g_instanced.cube_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, g_instanced.cube_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    g_instanced.cube_vertex_count = 36;
+}
+
+// Position and color; scaled by r in the shader, RENDER_AXIS_SCALE r long
+static void instanced_build_axes() {
+    const float vertices[6 * 6] = {
+        0, 0, 0,    1, 0, 0,   RENDER_AXIS_SCALE, 0, 0,  1, 0, 0,
+        0, 0, 0,    0, 1, 0,   0, RENDER_AXIS_SCALE, 0,  0, 1, 0,
+        0, 0, 0,    0, 0, 1,   0, 0, RENDER_AXIS_SCALE,  0, 0, 1,
+    };
+    glGenBuffers(1, &g_instanced.axes_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, g_instanced.axes_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+}
+
+// GL_VERSION starts with "major.minor"
+static bool instanced_supported() {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2) return false;
+    return major > 3 || (major == 3 && minor >= 3);
+}
+
+bool renderer_instanced_init() {
+    renderer_instanced_free();
+    if (!instanced_supported()) return false;
+    g_instanced.program = instanced_link();
+    if (!g_instanced.program) return false;
+    g_instanced.u_lit = glGetUniformLocation(g_instanced.program, "u_lit");
+
+    for (int lod = 0; lod < RENDERER_SPHERE_LODS; lod++) instanced_build_sphere(lod);
+    instanced_build_cube();
+    instanced_build_axes();
+    glGenBuffers(1, &g_instanced.instance_vbo);
+    glGenBuffers(1, &g_instanced.stream_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    for (int lod = 0; lod < RENDERER_SPHERE_LODS; lod++) {
+        if (g_instanced.sphere_index_count[lod] == 0) return false;
+    }
+    return true;
+}
+
+void renderer_instanced_free() {
+    if (g_instanced.program) {
+        GLuint buffers[4] = { g_instanced.cube_vbo, g_instanced.axes_vbo, g_instanced.instance_vbo,
+                              g_instanced.stream_vbo };
+        glDeleteBuffers(4, buffers);
+        glDeleteBuffers(RENDERER_SPHERE_LODS, g_instanced.sphere_vbo);
+        glDeleteBuffers(RENDERER_SPHERE_LODS, g_instanced.sphere_ibo);
+        glDeleteProgram(g_instanced.program);
+    }
+    mem_free(g_instanced.instances);
+    mem_free(g_instanced.stream);
+    mem_free(g_instanced.trail_first);
+    mem_free(g_instanced.trail_count);
+    memset(&g_instanced, 0, sizeof(InstancedRenderer));
+}
+
+// ============================================================================
+// DRAWING
+// ============================================================================
+
+static bool instanced_reserve(int bodies, int trails, int stream_vertices) {
+    InstancedRenderer* r = &g_instanced;
+    if (bodies > r->instance_capacity) {
+        int capacity = r->instance_capacity ? r->instance_capacity : 64;
+        while (capacity < bodies) capacity *= 2;
+        Instance* instances = mem_realloc(r->instances, capacity * sizeof(Instance));
+        if (!instances) return false;
+        r->instances = instances;
+        r->instance_capacity = capacity;
+    }
+    if (trails > r->trail_capacity) {
+        int capacity = r->trail_capacity ? r->trail_capacity : 16;
+        while (capacity < trails) capacity *= 2;
+        GLint* first = mem_realloc(r->trail_first, capacity * sizeof(GLint));
+        if (first) r->trail_first = first;
+        GLsizei* count = mem_realloc(r->trail_count, capacity * sizeof(GLsizei));
+        if (count) r->trail_count = count;
+        if (!first || !count) return false;
+        for (int i = r->trail_capacity; i < capacity; i++) {
+            r->trail_first[i] = i * TRAIL_LENGTH;
+            r->trail_count[i] = TRAIL_LENGTH;
+        }
+        r->trail_capacity = capacity;
+    }
+    if (stream_vertices > r->stream_capacity) {
+        int capacity = r->stream_capacity ? r->stream_capacity : 1024;
+        while (capacity < stream_vertices) capacity *= 2;
+        StreamVertex* stream = mem_realloc(r->stream, capacity * sizeof(StreamVertex));
+        if (!stream) return false;
+        r->stream = stream;
+        r->stream_capacity = capacity;
+    }
+    return true;
+}
+
+// Counting sort by LOD: first[l] is where level l starts, first[LODS] the boxes
+static void instanced_fill(const RenderSnapshot* snap, const RenderVisibility* vis,
+                           int first[RENDERER_SPHERE_LODS + 1]) {
+    int n = vis->body_count;
+    int next[RENDERER_SPHERE_LODS + 1] = { 0 };
+    for (int k = 0; k < n; k++) {
+        int level = snap->shape[vis->bodies[k]] == SHAPE_BOX ? RENDERER_SPHERE_LODS : vis->lod[k];
+        next[level]++;
+    }
+    for (int l = 0, start = 0; l <= RENDERER_SPHERE_LODS; l++) {
+        int count = next[l];
+        first[l] = next[l] = start;
+        start += count;
+    }
+    for (int k = 0; k < n; k++) {
+        int i = vis->bodies[k];
+        bool box = snap->shape[i] == SHAPE_BOX;
+        Instance* inst = &g_instanced.instances[next[box ? RENDERER_SPHERE_LODS : vis->lod[k]]++];
+        Vec3 x = vis->position[k];
+        Quat q = vis->orientation[k];
+        float r = snap->radius[i];
+        Vec3 s = box ? snap->half_extents[i] : (Vec3){ r, r, r };
+        Vec3 c = snap->color[i];
+        *inst = (Instance){ { x.x, x.y, x.z, r }, { q.x, q.y, q.z, q.w }, { s.x, s.y, s.z }, { c.x, c.y, c.z } };
+    }
+
+    // Trails oldest first, fading in; then particles
+    StreamVertex* v = g_instanced.stream;
+    for (int k = 0; k < vis->trail_count; k++) {
+        int i = vis->trails[k];
+        const Vec3* trail = &snap->trail[(size_t)i * TRAIL_LENGTH];
+        Vec3 c = snap->color[snap->trail_body[i]];
+        for (int t = 0; t < TRAIL_LENGTH; t++) {
+            *v++ = (StreamVertex){ { trail[t].x, trail[t].y, trail[t].z }, { c.x, c.y, c.z, (float)t / TRAIL_LENGTH } };
+        }
+    }
+    for (int k = 0; k < vis->particle_count; k++) {
+        int i = vis->particles[k];
+        Vec3 x = snap->particle_position[i], c = snap->particle_color[i];
+        *v++ = (StreamVertex){ { x.x, x.y, x.z }, { c.x, c.y, c.z, snap->particle_alpha[i] } };
+    }
+}
+
+static void instanced_attribute(GLuint location, int size, GLsizei stride, size_t offset, GLuint divisor) {
+    glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, stride, (const void*)offset);
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, divisor);
+}
+
+// Per-instance attributes starting at instance first
+static void instanced_bind_instances(int first) {
+    glBindBuffer(GL_ARRAY_BUFFER, g_instanced.instance_vbo);
+    size_t base = (size_t)first * sizeof(Instance);
+    instanced_attribute(ATTR_CENTER, 4, sizeof(Instance), base + offsetof(Instance, center), 1);
+    instanced_attribute(ATTR_ORIENTATION, 4, sizeof(Instance), base + offsetof(Instance, orientation), 1);
+    instanced_attribute(ATTR_SCALE, 3, sizeof(Instance), base + offsetof(Instance, scale), 1);
+    instanced_attribute(ATTR_COLOR, 3, sizeof(Instance), base + offsetof(Instance, color), 1);
+}
+
+// Position plus normal (meshes) or color (axes)
+static void instanced_bind_mesh(GLuint vbo, GLuint second) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    instanced_attribute(ATTR_VERTEX, 3, 6 * sizeof(float), 0, 0);
+    instanced_attribute(second, 3, 6 * sizeof(float), 3 * sizeof(float), 0);
+}
+
+static void instanced_unbind() {
+    for (GLuint a = ATTR_VERTEX; a <= ATTR_COLOR; a++) {
+        glVertexAttribDivisor(a, 0);
+        glDisableVertexAttribArray(a);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void renderer_instanced_draw(const RenderSnapshot* snap, const RenderVisibility* vis, RenderStats* stats) {
+    InstancedRenderer* r = &g_instanced;
+    int n = vis->body_count;
+    int trails = vis->trail_count;
+    int trail_vertices = trails * TRAIL_LENGTH;
+    int particles = vis->particle_count;
+    if (!instanced_reserve(n, trails, trail_vertices + particles)) return;
+    int first[RENDERER_SPHERE_LODS + 1];
+    instanced_fill(snap, vis, first);
+
+    // Orphaned each frame, so the driver need not wait on last frame's draws
+    glBindBuffer(GL_ARRAY_BUFFER, r->instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, n * sizeof(Instance), r->instances, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, r->stream_vbo);
+    glBufferData(GL_ARRAY_BUFFER, (trail_vertices + particles) * sizeof(StreamVertex), r->stream, GL_STREAM_DRAW);
+
+    // Bodies, lit
+    glUseProgram(r->program);
+    glUniform1f(r->u_lit, 1.0f);
+    for (int lod = 0; lod < RENDERER_SPHERE_LODS; lod++) {
+        int count = first[lod + 1] - first[lod];
+        if (count == 0) continue;
+        instanced_bind_mesh(r->sphere_vbo[lod], ATTR_NORMAL);
+        instanced_bind_instances(first[lod]);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, r->sphere_ibo[lod]);
+        glDrawElementsInstanced(GL_TRIANGLES, r->sphere_index_count[lod], GL_UNSIGNED_SHORT, NULL, count);
+        stats->draw_calls++;
+    }
+    int boxes = first[RENDERER_SPHERE_LODS];
+    if (boxes < n) {
+        instanced_bind_mesh(r->cube_vbo, ATTR_NORMAL);
+        instanced_bind_instances(boxes);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, r->cube_vertex_count, n - boxes);
+        stats->draw_calls++;
+    }
+
+    // Local axes
+    if (n > 0) {
+        glUniform1f(r->u_lit, 0.0f);
+        glDisableVertexAttribArray(ATTR_NORMAL);
+        instanced_bind_mesh(r->axes_vbo, ATTR_AXIS_COLOR);
+        instanced_bind_instances(0);
+        glDrawArraysInstanced(GL_LINES, 0, 6, n);
+        stats->draw_calls++;
+    }
+    instanced_unbind();
+    glUseProgram(0);
+
+    // Trails and particles from the stream buffer, fixed function
+    glDisable(GL_LIGHTING);
+    glBindBuffer(GL_ARRAY_BUFFER, r->stream_vbo);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(StreamVertex), (const void*)offsetof(StreamVertex, position));
+    glColorPointer(4, GL_FLOAT, sizeof(StreamVertex), (const void*)offsetof(StreamVertex, color));
+    if (trails > 0) {
+        glLineWidth(1.0f);
+        glMultiDrawArrays(GL_LINE_STRIP, r->trail_first, r->trail_count, trails);
+        stats->draw_calls++;
+    }
+    if (particles > 0) {
+        glPointSize(3.0f);
+        glDrawArrays(GL_POINTS, trail_vertices, particles);
+        stats->draw_calls++;
+    }
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnable(GL_LIGHTING);
+}
@@ -1,135 +1,321 @@
 #include "scene.h"
 #include "collision.h"
-#include <stdlib.h>
+#include "timer.h"
+#include "mem.h"
+#include "profile.h"
 #include <stdio.h>
+#include <string.h>
 
 void scene_init(Scene* scene) {
-    scene->body_count = 0;
-    scene->particle_count = 0;
+    body_store_init(&scene->bodies, 64);
+    trail_store_init(&scene->trails);
+    particle_store_init(&scene->particles);
+    scene->particle_rng = 1;
+    scene->particle_collision = (ParticleCollisionSettings){ true, 0.3f, 0.2f };
+    scene->emitters = NULL;
+    scene->emitter_count = 0;
+    scene->emitter_capacity = 0;
     scene->gravity = (Vec3){0, -9.81f, 0};
     scene->gravity_enabled = true;
     scene->time_scale = 1.0f;
     scene->world_size = 30.0f;
-    
-    // Initialize particles to inactive
-    for(int i=0; i<MAX_PARTICLES; i++) scene->particles[i].active = false;
+    collision_system_init(&scene->collision, scene->world_size);
+    scene->pool = NULL;
+    scene->sleep = (SleepSettings){ true, 0.2f, 0.25f, 0.5f };
+    scene->sleeping_count = 0;
+    scene_reset_stats(scene);
 }
 
 void scene_reset(Scene* scene) {
-    scene->body_count = 0;
-    scene->particle_count = 0;
+    body_store_clear(&scene->bodies);
+    trail_store_clear(&scene->trails);
+    particle_store_clear(&scene->particles);
+    scene->emitter_count = 0;
+    collision_system_clear(&scene->collision);
+}
+
+void scene_destroy(Scene* scene) {
+    collision_system_cleanup(&scene->collision);
+    body_store_free(&scene->bodies);
+    trail_store_free(&scene->trails);
+    thread_pool_destroy(scene->pool);
+    scene->pool = NULL;
+    particle_store_free(&scene->particles);
+    mem_free(scene->emitters);
+    scene->emitters = NULL;
+    scene->emitter_count = 0;
+    scene->emitter_capacity = 0;
+}
+
+BodyHandle scene_add_body(Scene* scene, RigidBody body) {
+    int index = body_store_add(&scene->bodies, &body);
+    if (index < 0) return BODY_HANDLE_NULL;
+    BodyHandle handle = body_store_handle(&scene->bodies, index);
+    if (body.trail && trail_store_add(&scene->trails, handle, body.position) < 0) {
+        scene->bodies.flags[index] &= (uint8_t)~BODY_FLAG_TRAIL;
+    }
+    return handle;
+}
+
+// The last body takes the removed body's index; handles stay valid
+bool scene_remove_body(Scene* scene, BodyHandle handle) {
+    int index = body_store_index(&scene->bodies, handle);
+    if (index < 0) return false;
+    if (scene->bodies.flags[index] & BODY_FLAG_TRAIL) trail_store_remove(&scene->trails, handle);
+    collision_system_remove_body(&scene->collision, &scene->bodies, index);
+    body_store_remove(&scene->bodies, index);
+    return true;
+}
+
+int scene_body_index(const Scene* scene, BodyHandle handle) {
+    return body_store_index(&scene->bodies, handle);
+}
+
+bool scene_add_force(Scene* scene, BodyHandle handle, Vec3 force) {
+    int index = body_store_index(&scene->bodies, handle);
+    if (index < 0) return false;
+    body_store_add_force(&scene->bodies, index, force);
+    return true;
+}
+
+// τ⃗ += r⃗ × F⃗ about the body's center
+bool scene_add_force_at_point(Scene* scene, BodyHandle handle, Vec3 force, Vec3 point) {
+    int index = body_store_index(&scene->bodies, handle);
+    if (index < 0) return false;
+    Vec3 r = vec3_sub(point, scene->bodies.position[index]);
+    body_store_add_force(&scene->bodies, index, force);
+    body_store_add_torque(&scene->bodies, index, vec3_cross(r, force));
+    return true;
+}
+
+bool scene_add_torque(Scene* scene, BodyHandle handle, Vec3 torque) {
+    int index = body_store_index(&scene->bodies, handle);
+    if (index < 0) return false;
+    body_store_add_torque(&scene->bodies, index, torque);
+    return true;
+}
+
+bool scene_get_body(const Scene* scene, int index, RigidBody* out) {
+    if (index < 0 || index >= scene->bodies.count) return false;
+    body_store_read(&scene->bodies, index, out);
+    return true;
+}
+
+void scene_set_body(Scene* scene, int index, const RigidBody* body) {
+    if (index < 0 || index >= scene->bodies.count) return;
+    uint8_t trail = scene->bodies.flags[index] & BODY_FLAG_TRAIL;
+    body_store_write(&scene->bodies, index, body);
+    scene->bodies.flags[index] = (uint8_t)((scene->bodies.flags[index] & ~BODY_FLAG_TRAIL) | trail);
+    scene_set_trail(scene, body_store_handle(&scene->bodies, index), body->trail);
+}
+
+bool scene_set_trail(Scene* scene, BodyHandle handle, bool enabled) {
+    BodyStore* bodies = &scene->bodies;
+    int index = body_store_index(bodies, handle);
+    if (index < 0) return false;
+    bool has_trail = (bodies->flags[index] & BODY_FLAG_TRAIL) != 0;
+    if (enabled && !has_trail) {
+        if (trail_store_add(&scene->trails, handle, bodies->position[index]) < 0) return false;
+        bodies->flags[index] |= BODY_FLAG_TRAIL;
+    } else if (!enabled && has_trail) {
+        trail_store_remove(&scene->trails, handle);
+        bodies->flags[index] &= (uint8_t)~BODY_FLAG_TRAIL;
+    }
+    return true;
+}
+
+// 1 (or less) runs every phase on the calling thread; 0 = one per CPU
+void scene_set_thread_count(Scene* scene, int threads) {
+    thread_pool_destroy(scene->pool);
+    scene->pool = NULL;
+    if (threads != 1) scene->pool = thread_pool_create(threads);
+    scene->collision.pool = scene->pool;
+}
+
+void scene_wake_all(Scene* scene) {
+    for(int i=0; i<scene->bodies.count; i++) body_store_wake(&scene->bodies, i);
+    scene->sleeping_count = 0;
+}
+
+void scene_reset_stats(Scene* scene) {
+    memset(&scene->stats, 0, sizeof(SceneStats));
 }
 
-void scene_add_body(Scene* scene, RigidBody body) {
-    if (scene->body_count < MAX_BODIES) {
-        scene->bodies[scene->body_count++] = body;
+const char* scene_phase_name(ScenePhase phase) {
+    switch (phase) {
+        case SCENE_PHASE_FORCES:    return "forces";
+        case SCENE_PHASE_INTEGRATE: return "integrate";
+        case SCENE_PHASE_COLLISION: return "collision";
+        case SCENE_PHASE_PARTICLES: return "particles";
+        case SCENE_PHASE_PARTICLE_COLLISION: return "p-collide";
+        default:                    return "?";
     }
 }
 
 void scene_update_particles(Scene* scene, float dt) {
-    for(int i=0; i<MAX_PARTICLES; i++) {
-        if (!scene->particles[i].active) continue;
-        
-        Particle* p = &scene->particles[i];
-        p->life -= dt;
-        
-        if (p->life <= 0) {
-            p->active = false;
-            continue;
-        }
-        
-        p->position = vec3_add(p->position, vec3_scale(p->velocity, dt));
-        p->velocity = vec3_add(p->velocity, vec3_scale(scene->gravity, dt * 0.5f)); // Light gravity
+    for(int e=0; e<scene->emitter_count; e++) {
+        emitter_update(&scene->emitters[e], &scene->particles, dt);
     }
+    particle_store_update(&scene->particles, scene->pool, scene->gravity, dt);
+}
+
+// fmix32 of the scene's particle state and the emitter index; never 0
+static uint32_t scene_emitter_seed(const Scene* scene, int index) {
+    uint32_t h = scene->particle_rng ^ (0x9E3779B9u * (uint32_t)(index + 1));
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h ? h : 1u;
+}
+
+// Returns the emitter's index; it can be changed through scene->emitters
+int scene_add_emitter(Scene* scene, Emitter emitter) {
+    if (scene->emitter_count == scene->emitter_capacity) {
+        int capacity = scene->emitter_capacity ? scene->emitter_capacity * 2 : 4;
+        Emitter* emitters = mem_realloc(scene->emitters, capacity * sizeof(Emitter));
+        if (!emitters) return -1;
+        scene->emitters = emitters;
+        scene->emitter_capacity = capacity;
+    }
+    // Unseeded emitters would all start from the same stream
+    if (emitter.rng == 0) emitter.rng = scene_emitter_seed(scene, scene->emitter_count);
+    scene->emitters[scene->emitter_count] = emitter;
+    return scene->emitter_count++;
 }
 
 void scene_spawn_explosion(Scene* scene, Vec3 pos, int count) {
-    int spawned = 0;
-    for(int i=0; i<MAX_PARTICLES && spawned < count; i++) {
-        if (!scene->particles[i].active) {
-            Particle* p = &scene->particles[i];
-            p->active = true;
-            p->position = pos;
-            p->max_life = 0.5f + ((float)rand()/RAND_MAX); // 0.5 to 1.5s
-            p->life = p->max_life;
-            
-            // Random sphere velocity
-            float theta = ((float)rand()/RAND_MAX) * 2 * PI;
-            float phi = ((float)rand()/RAND_MAX) * PI;
-            float speed = 5.0f + ((float)rand()/RAND_MAX) * 10.0f;
-            
-            p->velocity.x = speed * sinf(phi) * cosf(theta);
-            p->velocity.y = speed * cosf(phi);
-            p->velocity.z = speed * sinf(phi) * sinf(theta);
-            
-            p->color = (Vec3){1.0f, 0.5f + ((float)rand()/RAND_MAX)*0.5f, 0.0f}; // Orange-ish
-            spawned++;
+    if (count <= 0) return;
+    
+    // Wake resting bodies near the blast
+    BodyStore* bodies = &scene->bodies;
+    for(int i=0; i<bodies->count; i++) {
+        if (!(bodies->flags[i] & BODY_FLAG_SLEEPING)) continue;
+        if (vec3_mag_sq(vec3_sub(bodies->position[i], pos)) < EXPLOSION_WAKE_RADIUS * EXPLOSION_WAKE_RADIUS) {
+            body_store_wake(bodies, i);
         }
     }
+    
+    ParticleSpawn spawn = particle_spawn_explosion();
+    particle_store_emit(&scene->particles, pos, count, &spawn, &scene->particle_rng);
 }
 
 // Global collision resolution helper
-void resolve_scene_collisions(Scene* scene) {
-    // Brute force narrow phase over Octree would be complex to wire here fully without
-    // exposing Octree iterators.
-    // For this demonstration, we'll do an O(N^2) loop but optimized by ignoring sleeping bodies
-    // In a real huge codebase, we'd iterate the Octree leaves.
+void resolve_scene_collisions(Scene* scene, float dt) {
+    CollisionSystem* sys = &scene->collision;
+    float h = scene->world_size / 2.0f;
+    if (sys->world_bounds.max.x != h) collision_system_set_world_size(sys, scene->world_size);
     
-    for(int i=0; i<scene->body_count; i++) {
-        for(int j=i+1; j<scene->body_count; j++) {
-            RigidBody* A = &scene->bodies[i];
-            RigidBody* B = &scene->bodies[j];
-            
-            if (A->is_static && B->is_static) continue;
-            
-            Contact c;
-            if (collision_detect_sphere_sphere(A, B, &c)) {
-                collision_resolve(&c);
-                // Maybe spawn particles on hard hits?
-                float rel_vel = vec3_magnitude(vec3_sub(A->velocity, B->velocity));
-                if (rel_vel > 5.0f) {
-                    // scene_spawn_explosion(scene, c.point, 5); // Avoid recursive chaos for now
-                }
-            }
-        }
+    // Fast bodies are swept back to their first impact, then the broad phase
+    // (octree by default) feeds the sphere-sphere narrow phase. The walls of
+    // world_size are static planes whose contacts go through the solver.
+    collision_system_update(sys, &scene->bodies, dt);
+}
+
+// --- Parallel per-body phases ---
+// Each range touches only its own bodies, so the split does not affect results.
+
+typedef struct {
+    Scene* scene;
+    float dt;
+} SceneRangeJob;
+
+static void scene_apply_gravity_range(void* user, int begin, int end) {
+    SceneRangeJob* job = user;
+    BodyStore* bodies = &job->scene->bodies;
+    Vec3 gravity = job->scene->gravity;
+    for(int i=begin; i<end; i++) {
+        if (bodies->flags[i] & (BODY_FLAG_STATIC | BODY_FLAG_SLEEPING)) continue;
+        Vec3 g_force = vec3_scale(gravity, bodies->mass[i]);
+        bodies->force_accumulator[i] = vec3_add(bodies->force_accumulator[i], g_force);
+    }
+}
+
+static void scene_integrate_range(void* user, int begin, int end) {
+    SceneRangeJob* job = user;
+    physics_integrate_store(&job->scene->bodies, begin, end, job->dt);
+}
+
+// Rest timers, then island-wise deactivation
+static void scene_update_sleep(Scene* scene, float dt) {
+    BodyStore* bodies = &scene->bodies;
+    const SleepSettings* s = &scene->sleep;
+    if (!s->enabled) {
+        if (scene->sleeping_count > 0) scene_wake_all(scene);
+        return;
     }
     
-    // World Boundaries
-    float limit = scene->world_size / 2.0f;
-    for(int i=0; i<scene->body_count; i++) {
-        RigidBody* b = &scene->bodies[i];
-        if (b->is_static) continue;
-        
-        float e = b->restitution;
-        if (b->position.y - b->radius < -limit) {
-            b->position.y = -limit + b->radius;
-            b->velocity.y *= -e;
-            // Floor friction
-            b->velocity.x *= 0.95f; b->velocity.z *= 0.95f;
-        }
-        // ... (other walls omitted for brevity in this specific snippet, but imply box)
+    float lin_sq = s->linear_threshold * s->linear_threshold;
+    float ang_sq = s->angular_threshold * s->angular_threshold;
+    for(int i=0; i<bodies->count; i++) {
+        if (bodies->flags[i] & (BODY_FLAG_STATIC | BODY_FLAG_SLEEPING)) continue;
+        bool resting = vec3_mag_sq(bodies->velocity[i]) < lin_sq &&
+                       vec3_mag_sq(bodies->angular_velocity[i]) < ang_sq;
+        bodies->sleep_timer[i] = resting ? bodies->sleep_timer[i] + dt : 0.0f;
     }
+    scene->sleeping_count = collision_system_update_sleep(&scene->collision, bodies, s->time_to_sleep);
 }
 
 void scene_update(Scene* scene, float dt) {
     dt *= scene->time_scale;
+    SceneStats* stats = &scene->stats;
+    uint64_t allocations = mem_allocation_count();
+    uint64_t t0 = timer_now_ns();
+    
+    // Keep the integration's SIMD blocks to one shape each
+    if (scene->bodies.shape_unsorted && body_store_sort_by_shape(&scene->bodies)) {
+        collision_system_forget_bodies(&scene->collision);
+    }
+
+    int count = scene->bodies.count;
+    SceneRangeJob job = { scene, dt };
     
     // 1. Forces
-    for(int i=0; i<scene->body_count; i++) {
-        if (!scene->bodies[i].is_static && scene->gravity_enabled) {
-            Vec3 g_force = vec3_scale(scene->gravity, scene->bodies[i].mass);
-            physics_add_force(&scene->bodies[i], g_force);
-        }
+    if (scene->gravity_enabled) {
+        thread_pool_parallel_for(scene->pool, 0, count, SCENE_PARALLEL_GRAIN, scene_apply_gravity_range, &job);
     }
+    uint64_t t1 = timer_now_ns();
     
     // 2. Integration
-    for(int i=0; i<scene->body_count; i++) {
-        physics_integrate(&scene->bodies[i], dt);
-    }
+    thread_pool_parallel_for(scene->pool, 0, count, SCENE_PARALLEL_GRAIN, scene_integrate_range, &job);
+    trail_store_sample(&scene->trails, &scene->bodies);
+    uint64_t t2 = timer_now_ns();
     
     // 3. Collision
-    resolve_scene_collisions(scene);
+    resolve_scene_collisions(scene, dt);
+    scene_update_sleep(scene, dt);
+    uint64_t t3 = timer_now_ns();
     
     // 4. Particles
     scene_update_particles(scene, dt);
+    uint64_t t4 = timer_now_ns();
+    
+    // 5. Particles against the bodies' final positions
+    collision_system_collide_particles(&scene->collision, &scene->bodies, &scene->particles, &scene->particle_collision);
+    uint64_t t5 = timer_now_ns();
+    
+    stats->phase_ns[SCENE_PHASE_FORCES]    += t1 - t0;
+    stats->phase_ns[SCENE_PHASE_INTEGRATE] += t2 - t1;
+    stats->phase_ns[SCENE_PHASE_COLLISION] += t3 - t2;
+    stats->phase_ns[SCENE_PHASE_PARTICLES] += t4 - t3;
+    stats->phase_ns[SCENE_PHASE_PARTICLE_COLLISION] += t5 - t4;
+    stats->steps++;
+    
+    // Counted process-wide: other threads allocating meanwhile show up here
+    stats->last_allocations = mem_allocation_count() - allocations;
+    stats->allocations += stats->last_allocations;
+    
+    PROFILE_SPAN("step", t0, t5);
+    PROFILE_SPAN(scene_phase_name(SCENE_PHASE_FORCES), t0, t1);
+    PROFILE_SPAN(scene_phase_name(SCENE_PHASE_INTEGRATE), t1, t2);
+    PROFILE_SPAN(scene_phase_name(SCENE_PHASE_COLLISION), t2, t3);
+    PROFILE_SPAN(scene_phase_name(SCENE_PHASE_PARTICLES), t3, t4);
+    PROFILE_SPAN(scene_phase_name(SCENE_PHASE_PARTICLE_COLLISION), t4, t5);
+    PROFILE_COUNTER("pairs tested", scene->collision.pairs.count);
+    PROFILE_COUNTER("contacts", scene->collision.contact_count);
+    PROFILE_COUNTER("bodies awake", count - scene->sleeping_count);
+    PROFILE_COUNTER("particles alive", scene->particles.count);
+    PROFILE_COUNTER("allocations", stats->last_allocations);
+    PROFILE_FRAME_END();
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200809L
+#include "sim_thread.h"
+#include "mem.h"
+#include "timer.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    SimCommandFn fn;
+    void* user;
+} SimCommand;
+
+struct SimThread {
+    Scene* scene;
+    SceneStepper* stepper;
+    SimThreadSettings settings;
+    RenderTripleBuffer buffer;
+    pthread_t thread;
+    atomic_bool stop;
+    atomic_bool finished;
+    atomic_uint_fast64_t published;
+
+    // Single-producer ring: the display thread advances head, this thread tail
+    SimCommand commands[SIM_THREAD_MAX_COMMANDS];
+    atomic_uint command_head;
+    atomic_uint command_tail;
+};
+
+static void sim_thread_run_commands(SimThread* sim) {
+    unsigned int tail = atomic_load_explicit(&sim->command_tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&sim->command_head, memory_order_acquire);
+    for (; tail != head; tail++) {
+        SimCommand* c = &sim->commands[tail % SIM_THREAD_MAX_COMMANDS];
+        c->fn(sim->scene, c->user);
+    }
+    atomic_store_explicit(&sim->command_tail, tail, memory_order_release);
+}
+
+static void sim_thread_publish(SimThread* sim) {
+    RenderSnapshot* snap = render_buffer_back(&sim->buffer);
+    render_snapshot_capture(snap, sim->scene, sim->stepper);
+    if (sim->settings.checksum) snap->checksum = render_snapshot_checksum(snap);
+    render_buffer_publish(&sim->buffer);
+    atomic_store_explicit(&sim->published, sim->buffer.published, memory_order_relaxed);
+}
+
+static void sim_thread_sleep(float seconds) {
+    if (seconds <= 0.0f) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (float)ts.tv_sec) * 1e9f);
+    nanosleep(&ts, NULL);
+}
+
+static void* sim_thread_main(void* arg) {
+    SimThread* sim = arg;
+    SceneStepper* stepper = sim->stepper;
+    uint64_t last = timer_now_ns();
+
+    // The initial state, so there is something to draw before the first step
+    sim_thread_publish(sim);
+    while (!atomic_load_explicit(&sim->stop, memory_order_relaxed)) {
+        if (sim->settings.step_limit > 0 && stepper->steps >= sim->settings.step_limit) break;
+        sim_thread_run_commands(sim);
+
+        if (sim->settings.free_run) {
+            stepper_step(stepper, sim->scene);
+            sim_thread_publish(sim);
+            continue;
+        }
+
+        uint64_t now = timer_now_ns();
+        float frame_dt = (float)((now - last) * 1e-9);
+        last = now;
+        if (stepper_advance(stepper, sim->scene, frame_dt) > 0) sim_thread_publish(sim);
+
+        // Until the accumulator pays for the next step
+        sim_thread_sleep((1.0f - stepper->alpha) / stepper->step_hz);
+    }
+    atomic_store(&sim->finished, true);
+    return NULL;
+}
+
+SimThread* sim_thread_start(Scene* scene, SceneStepper* stepper, const SimThreadSettings* settings) {
+    SimThread* sim = mem_calloc(1, sizeof(SimThread));
+    if (!sim) return NULL;
+    sim->scene = scene;
+    sim->stepper = stepper;
+    if (settings) sim->settings = *settings;
+    render_buffer_init(&sim->buffer);
+    atomic_init(&sim->stop, false);
+    atomic_init(&sim->finished, false);
+    atomic_init(&sim->published, 0);
+    atomic_init(&sim->command_head, 0u);
+    atomic_init(&sim->command_tail, 0u);
+
+    if (pthread_create(&sim->thread, NULL, sim_thread_main, sim) != 0) {
+        render_buffer_free(&sim->buffer);
+        mem_free(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+void sim_thread_stop(SimThread* sim) {
+    if (!sim) return;
+    atomic_store(&sim->stop, true);
+    pthread_join(sim->thread, NULL);
+    // Commands posted after the last step still apply
+    sim_thread_run_commands(sim);
+    render_buffer_free(&sim->buffer);
+    mem_free(sim);
+}
+
+const RenderSnapshot* sim_thread_acquire(SimThread* sim) {
+    return render_buffer_acquire(&sim->buffer);
+}
+
+// Fails when the ring is full (the simulation thread is far behind)
+bool sim_thread_post(SimThread* sim, SimCommandFn fn, void* user) {
+    unsigned int head = atomic_load_explicit(&sim->command_head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&sim->command_tail, memory_order_acquire);
+    if (head - tail == SIM_THREAD_MAX_COMMANDS) return false;
+    sim->commands[head % SIM_THREAD_MAX_COMMANDS] = (SimCommand){ fn, user };
+    atomic_store_explicit(&sim->command_head, head + 1, memory_order_release);
+    return true;
+}
+
+bool sim_thread_finished(const SimThread* sim) {
+    return atomic_load(&sim->finished);
+}
+
+uint64_t sim_thread_published(const SimThread* sim) {
+    return atomic_load(&sim->published);
+}
+
+uint64_t sim_thread_acquired(const SimThread* sim) {
+    return sim->buffer.acquired;
+}
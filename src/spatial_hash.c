@@ -0,0 +1,197 @@
+#include "spatial_hash.h"
+#include "mem.h"
+#include <math.h>
+#include <string.h>
+
+// Half of the 26 neighbours: together with the own cell, every adjacent
+// pair of cells is visited from exactly one side.
+static const int k_forward_neighbors[13][3] = {
+    { 1, 0, 0},
+    {-1, 1, 0}, { 0, 1, 0}, { 1, 1, 0},
+    {-1,-1, 1}, { 0,-1, 1}, { 1,-1, 1},
+    {-1, 0, 1}, { 0, 0, 1}, { 1, 0, 1},
+    {-1, 1, 1}, { 0, 1, 1}, { 1, 1, 1}
+};
+
+static inline int spatial_hash_bucket(const SpatialHash* grid, int x, int y, int z) {
+    unsigned int h = ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u);
+    return (int)(h & (unsigned int)(grid->table_size - 1));
+}
+
+void spatial_hash_init(SpatialHash* grid) {
+    memset(grid, 0, sizeof(SpatialHash));
+}
+
+void spatial_hash_free(SpatialHash* grid) {
+    mem_free(grid->bucket_start);
+    mem_free(grid->sorted_body);
+    mem_free(grid->sorted_cell);
+    mem_free(grid->sorted_sphere);
+    mem_free(grid->body_bucket);
+    memset(grid, 0, sizeof(SpatialHash));
+}
+
+// Realloc that leaves the old block in place (and clears ok) on failure
+static void* spatial_hash_grow(void* array, size_t size, int capacity, bool* ok) {
+    void* grown = mem_realloc(array, (size_t)capacity * size);
+    if (grown) return grown;
+    *ok = false;
+    return array;
+}
+
+// Arrays that did grow keep their larger block; capacities only move once all have
+static bool spatial_hash_reserve(SpatialHash* grid, int count) {
+    if (count > grid->body_capacity) {
+        int capacity = count + count / 2;
+        bool ok = true;
+        grid->sorted_body = spatial_hash_grow(grid->sorted_body, sizeof(int), capacity, &ok);
+        grid->sorted_cell = spatial_hash_grow(grid->sorted_cell, 3 * sizeof(int), capacity, &ok);
+        grid->sorted_sphere = spatial_hash_grow(grid->sorted_sphere, 4 * sizeof(float), capacity, &ok);
+        grid->body_bucket = spatial_hash_grow(grid->body_bucket, sizeof(int), capacity, &ok);
+        if (!ok) return false;
+        grid->body_capacity = capacity;
+    }
+
+    // Load factor ≤ 0.5
+    int table_size = 64;
+    while (table_size < count * 2) table_size <<= 1;
+    if (table_size > grid->table_capacity) {
+        int* start = mem_realloc(grid->bucket_start, (table_size + 1) * sizeof(int));
+        if (!start) return false;
+        grid->bucket_start = start;
+        grid->table_capacity = table_size;
+    }
+    grid->table_size = table_size;
+    return true;
+}
+
+/*
+ * spatial_hash_build
+ * Counting sort of bodies into hash buckets:
+ * 1. count bodies per bucket, 2. exclusive prefix sum, 3. scatter.
+ */
+bool spatial_hash_build(SpatialHash* grid, const Vec3* position, const float* radius, int count, float cell_size) {
+    if (!spatial_hash_reserve(grid, count)) {
+        grid->body_count = 0;
+        return false;
+    }
+    grid->body_count = count;
+
+    float max_radius = 0.0f;
+    for (int i = 0; i < count; i++) max_radius = fmaxf(max_radius, radius[i]);
+    grid->cell_size = fmaxf(cell_size, 2.0f * max_radius);
+    if (grid->cell_size <= 0.0f) grid->cell_size = 1.0f;
+    grid->inv_cell_size = 1.0f / grid->cell_size;
+
+    int* start = grid->bucket_start;
+    memset(start, 0, (grid->table_size + 1) * sizeof(int));
+
+    // 1. Histogram (shifted by one so the prefix sum is exclusive in place)
+    for (int i = 0; i < count; i++) {
+        Vec3 p = position[i];
+        int b = spatial_hash_bucket(grid,
+                                    (int)floorf(p.x * grid->inv_cell_size),
+                                    (int)floorf(p.y * grid->inv_cell_size),
+                                    (int)floorf(p.z * grid->inv_cell_size));
+        grid->body_bucket[i] = b;
+        start[b + 1]++;
+    }
+
+    // 2. Prefix sum
+    for (int b = 0; b < grid->table_size; b++) start[b + 1] += start[b];
+
+    // 3. Scatter; start[b] is used as the write cursor and restored below.
+    // Spheres are copied alongside so pair tests never touch the bodies.
+    for (int i = 0; i < count; i++) {
+        int slot = start[grid->body_bucket[i]]++;
+        Vec3 p = position[i];
+        grid->sorted_body[slot] = i;
+        grid->sorted_sphere[slot * 4 + 0] = p.x;
+        grid->sorted_sphere[slot * 4 + 1] = p.y;
+        grid->sorted_sphere[slot * 4 + 2] = p.z;
+        grid->sorted_sphere[slot * 4 + 3] = radius[i];
+        grid->sorted_cell[slot * 3 + 0] = (int)floorf(p.x * grid->inv_cell_size);
+        grid->sorted_cell[slot * 3 + 1] = (int)floorf(p.y * grid->inv_cell_size);
+        grid->sorted_cell[slot * 3 + 2] = (int)floorf(p.z * grid->inv_cell_size);
+    }
+    for (int b = grid->table_size; b > 0; b--) start[b] = start[b - 1];
+    start[0] = 0;
+    return true;
+}
+
+static inline bool spatial_hash_same_cell(const int* cell, int x, int y, int z) {
+    return cell[0] == x && cell[1] == y && cell[2] == z;
+}
+
+// AABB overlap of two bounding spheres: |Δx|, |Δy|, |Δz| ≤ r_a + r_b
+static inline void spatial_hash_test(const SpatialHash* grid, int s, int t, PairList* out) {
+    const float* A = &grid->sorted_sphere[s * 4];
+    const float* B = &grid->sorted_sphere[t * 4];
+    float r = A[3] + B[3];
+    if (fabsf(A[0] - B[0]) <= r && fabsf(A[1] - B[1]) <= r && fabsf(A[2] - B[2]) <= r) {
+        pair_list_push(out, grid->sorted_body[s], grid->sorted_body[t]);
+    }
+}
+
+void spatial_hash_find_pairs(const SpatialHash* grid, PairList* out) {
+    const int* start = grid->bucket_start;
+
+    for (int s = 0; s < grid->body_count; s++) {
+        int a = grid->sorted_body[s];
+        const int* cell = &grid->sorted_cell[s * 3];
+        int cx = cell[0], cy = cell[1], cz = cell[2];
+
+        // Own cell: only entries after this one (the bucket may hold other cells)
+        int end = start[grid->body_bucket[a] + 1];
+        for (int t = s + 1; t < end; t++) {
+            if (spatial_hash_same_cell(&grid->sorted_cell[t * 3], cx, cy, cz)) {
+                spatial_hash_test(grid, s, t, out);
+            }
+        }
+
+        // Forward neighbours
+        for (int n = 0; n < 13; n++) {
+            int nx = cx + k_forward_neighbors[n][0];
+            int ny = cy + k_forward_neighbors[n][1];
+            int nz = cz + k_forward_neighbors[n][2];
+            int b = spatial_hash_bucket(grid, nx, ny, nz);
+            for (int t = start[b]; t < start[b + 1]; t++) {
+                if (spatial_hash_same_cell(&grid->sorted_cell[t * 3], nx, ny, nz)) {
+                    spatial_hash_test(grid, s, t, out);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * spatial_hash_query_point
+ * A sphere containing p has its center within r ≤ cell_size / 2 of p, so
+ * it was binned in p's cell or a neighbour on the side of p's nearer half
+ * along each axis: 8 cells. The 2r window leaves room for bodies that
+ * moved after the build.
+ */
+int spatial_hash_query_point(const SpatialHash* grid, Vec3 p, int* results, int max) {
+    if (grid->body_count == 0) return 0;
+    const int* start = grid->bucket_start;
+    float fx = p.x * grid->inv_cell_size, fy = p.y * grid->inv_cell_size, fz = p.z * grid->inv_cell_size;
+    int cx = (int)floorf(fx), cy = (int)floorf(fy), cz = (int)floorf(fz);
+    int sx = fx - cx < 0.5f ? -1 : 1, sy = fy - cy < 0.5f ? -1 : 1, sz = fz - cz < 0.5f ? -1 : 1;
+    int count = 0;
+
+    for (int n = 0; n < 8; n++) {
+        int x = cx + ((n & 1) ? sx : 0);
+        int y = cy + ((n & 2) ? sy : 0);
+        int z = cz + ((n & 4) ? sz : 0);
+        int b = spatial_hash_bucket(grid, x, y, z);
+        for (int t = start[b]; t < start[b + 1]; t++) {
+            if (!spatial_hash_same_cell(&grid->sorted_cell[t * 3], x, y, z)) continue;
+            const float* S = &grid->sorted_sphere[t * 4];
+            float r = 2.0f * S[3];
+            if (fabsf(S[0] - p.x) > r || fabsf(S[1] - p.y) > r || fabsf(S[2] - p.z) > r) continue;
+            if (count == max) return count;
+            results[count++] = grid->sorted_body[t];
+        }
+    }
+    return count;
+}
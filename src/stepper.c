@@ -0,0 +1,108 @@
+#include "stepper.h"
+#include "mem.h"
+#include <string.h>
+
+void stepper_init(SceneStepper* stepper, float step_hz, int substeps, int max_steps_per_frame) {
+    memset(stepper, 0, sizeof(SceneStepper));
+    stepper->step_hz = step_hz > 0.0f ? step_hz : STEPPER_DEFAULT_HZ;
+    stepper->substeps = substeps > 0 ? substeps : 1;
+    stepper->max_steps_per_frame = max_steps_per_frame > 0 ? max_steps_per_frame : STEPPER_DEFAULT_MAX_STEPS;
+}
+
+void stepper_free(SceneStepper* stepper) {
+    mem_free(stepper->prev_position);
+    mem_free(stepper->prev_orientation);
+    mem_free(stepper->prev_generation);
+    memset(stepper, 0, sizeof(SceneStepper));
+}
+
+// Grows the per-slot arrays; on failure the old capacity (and contents) stay
+static bool stepper_reserve(SceneStepper* stepper, int slot_count) {
+    if (slot_count <= stepper->prev_capacity) return true;
+    int capacity = stepper->prev_capacity ? stepper->prev_capacity : 64;
+    while (capacity < slot_count) capacity *= 2;
+    Vec3* position = mem_realloc(stepper->prev_position, capacity * sizeof(Vec3));
+    if (position) stepper->prev_position = position;
+    Quat* orientation = mem_realloc(stepper->prev_orientation, capacity * sizeof(Quat));
+    if (orientation) stepper->prev_orientation = orientation;
+    uint32_t* generation = mem_realloc(stepper->prev_generation, capacity * sizeof(uint32_t));
+    if (generation) stepper->prev_generation = generation;
+    if (!position || !orientation || !generation) return false;
+    // Unwritten entries must not match a live handle
+    for (int s = stepper->prev_capacity; s < capacity; s++) stepper->prev_generation[s] = UINT32_MAX;
+    stepper->prev_capacity = capacity;
+    return true;
+}
+
+// Copies every body's transform into its slot's entry. Out of memory, bodies
+// in slots past the old capacity are skipped and drawn unblended.
+static void stepper_save_transforms(SceneStepper* stepper, const Scene* scene) {
+    const BodyStore* bodies = &scene->bodies;
+    stepper_reserve(stepper, bodies->slot_count);
+    
+    for (int i = 0; i < bodies->count; i++) {
+        BodyHandle h = body_store_handle(bodies, i);
+        if (h.slot >= (uint32_t)stepper->prev_capacity) continue;
+        stepper->prev_position[h.slot] = bodies->position[i];
+        stepper->prev_orientation[h.slot] = bodies->orientation[i];
+        stepper->prev_generation[h.slot] = h.generation;
+    }
+}
+
+int stepper_advance(SceneStepper* stepper, Scene* scene, float frame_dt) {
+    float step_dt = 1.0f / stepper->step_hz;
+    if (frame_dt > 0.0f) stepper->accumulator += frame_dt;
+    
+    int steps = (int)(stepper->accumulator * stepper->step_hz);
+    if (steps > stepper->max_steps_per_frame) {
+        // Spiral-of-death guard: keep only the fractional remainder
+        stepper->dropped_steps += steps - stepper->max_steps_per_frame;
+        stepper->accumulator -= (float)(steps - stepper->max_steps_per_frame) * step_dt;
+        steps = stepper->max_steps_per_frame;
+    }
+    
+    float sub_dt = step_dt / stepper->substeps;
+    for (int s = 0; s < steps; s++) {
+        // Only the state before the final step is needed for interpolation
+        if (s == steps - 1) stepper_save_transforms(stepper, scene);
+        for (int k = 0; k < stepper->substeps; k++) scene_update(scene, sub_dt);
+        stepper->accumulator -= step_dt;
+    }
+    if (stepper->accumulator < 0.0f) stepper->accumulator = 0.0f;
+    
+    stepper->steps += steps;
+    stepper->alpha = stepper->accumulator * stepper->step_hz;
+    if (stepper->alpha > 1.0f) stepper->alpha = 1.0f;
+    return steps;
+}
+
+void stepper_step(SceneStepper* stepper, Scene* scene) {
+    float sub_dt = 1.0f / (stepper->step_hz * stepper->substeps);
+    stepper_save_transforms(stepper, scene);
+    for (int k = 0; k < stepper->substeps; k++) scene_update(scene, sub_dt);
+    stepper->steps++;
+    stepper->alpha = stepper->accumulator * stepper->step_hz;
+    if (stepper->alpha > 1.0f) stepper->alpha = 1.0f;
+}
+
+void stepper_body_previous(const SceneStepper* stepper, const Scene* scene, int index, Vec3* position, Quat* orientation) {
+    const BodyStore* bodies = &scene->bodies;
+    BodyHandle h = body_store_handle(bodies, index);
+    if (h.slot >= (uint32_t)stepper->prev_capacity || stepper->prev_generation[h.slot] != h.generation) {
+        *position = bodies->position[index];
+        *orientation = bodies->orientation[index];
+        return;
+    }
+    *position = stepper->prev_position[h.slot];
+    *orientation = stepper->prev_orientation[h.slot];
+}
+
+void stepper_body_transform(const SceneStepper* stepper, const Scene* scene, int index, Vec3* position, Quat* orientation) {
+    Vec3 prev_position;
+    Quat prev_orientation;
+    stepper_body_previous(stepper, scene, index, &prev_position, &prev_orientation);
+    
+    float a = stepper->alpha;
+    *position = vec3_lerp(prev_position, scene->bodies.position[index], a);
+    *orientation = quat_nlerp(prev_orientation, scene->bodies.orientation[index], a);
+}
@@ -0,0 +1,375 @@
+#include "sweep_prune.h"
+#include "mem.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// PAIR SET
+// ============================================================================
+
+static inline uint32_t sap_pair_hash(int a, int b) {
+    uint64_t key = ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+// Slot holding (a, b), or the empty slot where it would go
+static int sap_find_slot(const SweepPrune* sap, int a, int b) {
+    uint32_t mask = (uint32_t)sap->slot_count - 1;
+    uint32_t s = sap_pair_hash(a, b) & mask;
+    while (sap->pair_slots[s] >= 0) {
+        const BodyPair* p = &sap->pairs[sap->pair_slots[s]];
+        if (p->a == a && p->b == b) break;
+        s = (s + 1) & mask;
+    }
+    return (int)s;
+}
+
+// A table of the same size is rebuilt in place. False if a new one could
+// not be allocated; the old table is kept and still indexes every pair.
+static bool sap_rehash(SweepPrune* sap, int slot_count) {
+    if (slot_count != sap->slot_count) {
+        int* slots = mem_malloc(slot_count * sizeof(int));
+        if (!slots) return false;
+        mem_free(sap->pair_slots);
+        sap->pair_slots = slots;
+        sap->slot_count = slot_count;
+    }
+    memset(sap->pair_slots, 0xff, slot_count * sizeof(int));
+    for (int i = 0; i < sap->pair_count; i++) {
+        sap->pair_slots[sap_find_slot(sap, sap->pairs[i].a, sap->pairs[i].b)] = i;
+    }
+    return true;
+}
+
+// A pair that cannot be stored sets lost_pair, so the next update rebuilds
+static void sap_pair_add(SweepPrune* sap, int a, int b) {
+    if (a > b) { int t = a; a = b; b = t; }
+
+    // Keep load factor ≤ 0.5; past it, at least one slot must stay empty
+    if ((sap->pair_count + 1) * 2 > sap->slot_count &&
+        !sap_rehash(sap, sap->slot_count ? sap->slot_count * 2 : 256) &&
+        sap->pair_count + 1 >= sap->slot_count) {
+        sap->lost_pair = true;
+        return;
+    }
+    int s = sap_find_slot(sap, a, b);
+    if (sap->pair_slots[s] >= 0) return;
+
+    if (sap->pair_count == sap->pair_capacity) {
+        int capacity = sap->pair_capacity ? sap->pair_capacity * 2 : 128;
+        BodyPair* pairs = mem_realloc(sap->pairs, capacity * sizeof(BodyPair));
+        if (!pairs) {
+            sap->lost_pair = true;
+            return;
+        }
+        sap->pairs = pairs;
+        sap->pair_capacity = capacity;
+    }
+    sap->pair_slots[s] = sap->pair_count;
+    sap->pairs[sap->pair_count++] = (BodyPair){a, b};
+    if (sap->on_pair) sap->on_pair(sap->user, a, b, true);
+}
+
+static void sap_pair_remove(SweepPrune* sap, int a, int b) {
+    if (sap->pair_count == 0) return;
+    if (a > b) { int t = a; a = b; b = t; }
+
+    uint32_t mask = (uint32_t)sap->slot_count - 1;
+    int s = sap_find_slot(sap, a, b);
+    int index = sap->pair_slots[s];
+    if (index < 0) return;
+
+    // Backward-shift deletion keeps probe sequences intact without tombstones
+    uint32_t hole = (uint32_t)s;
+    uint32_t next = (hole + 1) & mask;
+    while (sap->pair_slots[next] >= 0) {
+        const BodyPair* p = &sap->pairs[sap->pair_slots[next]];
+        uint32_t home = sap_pair_hash(p->a, p->b) & mask;
+        // Move the entry into the hole unless its home lies in (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            sap->pair_slots[hole] = sap->pair_slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    sap->pair_slots[hole] = -1;
+
+    // Swap-remove from the dense list
+    int last = --sap->pair_count;
+    if (index != last) {
+        BodyPair moved = sap->pairs[last];
+        sap->pairs[index] = moved;
+        sap->pair_slots[sap_find_slot(sap, moved.a, moved.b)] = index;
+    }
+
+    if (sap->on_pair) sap->on_pair(sap->user, a, b, false);
+}
+
+bool sweep_prune_has_pair(const SweepPrune* sap, int a, int b) {
+    if (sap->slot_count == 0) return false;
+    if (a > b) { int t = a; a = b; b = t; }
+    return sap->pair_slots[sap_find_slot(sap, a, b)] >= 0;
+}
+
+// ============================================================================
+// ENDPOINTS
+// ============================================================================
+
+static inline float sap_axis(Vec3 v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+// Order by value; on ties min endpoints come first so touching boxes
+// (closed intervals, as in aabb_overlap) count as overlapping.
+static inline bool sap_endpoint_less(SapEndpoint a, SapEndpoint b) {
+    return a.value < b.value || (a.value == b.value && a.is_max < b.is_max);
+}
+
+static int sap_endpoint_compare(const void* pa, const void* pb) {
+    SapEndpoint a = *(const SapEndpoint*)pa;
+    SapEndpoint b = *(const SapEndpoint*)pb;
+    if (sap_endpoint_less(a, b)) return -1;
+    if (sap_endpoint_less(b, a)) return 1;
+    return a.body - b.body;
+}
+
+void sweep_prune_init(SweepPrune* sap) {
+    memset(sap, 0, sizeof(SweepPrune));
+}
+
+void sweep_prune_free(SweepPrune* sap) {
+    for (int axis = 0; axis < 3; axis++) mem_free(sap->endpoints[axis]);
+    mem_free(sap->boxes);
+    mem_free(sap->remap);
+    mem_free(sap->owner);
+    mem_free(sap->active);
+    mem_free(sap->pairs);
+    mem_free(sap->pair_slots);
+    memset(sap, 0, sizeof(SweepPrune));
+}
+
+void sweep_prune_set_callback(SweepPrune* sap, SapPairCallback callback, void* user) {
+    sap->on_pair = callback;
+    sap->user = user;
+}
+
+void sweep_prune_clear(SweepPrune* sap) {
+    while (sap->pair_count > 0) {
+        BodyPair p = sap->pairs[sap->pair_count - 1];
+        sap_pair_remove(sap, p.a, p.b);
+    }
+    sap->body_count = 0;
+    sap->pending_removals = 0;
+    sap->lost_pair = false;
+}
+
+// Realloc that leaves the old block in place (and clears ok) on failure
+static void* sap_grow(void* array, size_t size, int capacity, bool* ok) {
+    void* grown = mem_realloc(array, (size_t)capacity * size);
+    if (grown) return grown;
+    *ok = false;
+    return array;
+}
+
+// Arrays that did grow keep their larger block; capacity only moves once all have
+static bool sap_reserve(SweepPrune* sap, int count) {
+    if (count <= sap->body_capacity) return true;
+    int capacity = count + count / 2;
+    bool ok = true;
+    for (int axis = 0; axis < 3; axis++) {
+        sap->endpoints[axis] = sap_grow(sap->endpoints[axis], 2 * sizeof(SapEndpoint), capacity, &ok);
+    }
+    sap->boxes = sap_grow(sap->boxes, sizeof(AABB), capacity, &ok);
+    sap->remap = sap_grow(sap->remap, sizeof(int), capacity, &ok);
+    sap->owner = sap_grow(sap->owner, sizeof(int), capacity, &ok);
+    sap->active = sap_grow(sap->active, sizeof(int), capacity, &ok);
+    if (ok) sap->body_capacity = capacity;
+    return ok;
+}
+
+/*
+ * Insertion sort of one axis.
+ * Moving endpoint e left past p flips their order, which changes the
+ * overlap of the two bodies on this axis only in two cases:
+ *   e = min, p = max → the intervals start overlapping (add if all axes overlap)
+ *   e = max, p = min → the intervals separate (remove)
+ */
+static void sap_sort_axis(SweepPrune* sap, int axis) {
+    SapEndpoint* ep = sap->endpoints[axis];
+    int n = 2 * sap->body_count;
+
+    for (int i = 1; i < n; i++) {
+        SapEndpoint e = ep[i];
+        int j = i - 1;
+        while (j >= 0 && sap_endpoint_less(e, ep[j])) {
+            SapEndpoint p = ep[j];
+            if (!e.is_max && p.is_max) {
+                if (aabb_overlap(sap->boxes[e.body], sap->boxes[p.body])) sap_pair_add(sap, e.body, p.body);
+            } else if (e.is_max && !p.is_max) {
+                sap_pair_remove(sap, e.body, p.body);
+            }
+            ep[j + 1] = p;
+            j--;
+            sap->swaps++;
+        }
+        ep[j + 1] = e;
+    }
+}
+
+// Initial population: sort every axis, then one sweep along x
+static void sap_build(SweepPrune* sap) {
+    int n = 2 * sap->body_count;
+    for (int axis = 0; axis < 3; axis++) {
+        qsort(sap->endpoints[axis], n, sizeof(SapEndpoint), sap_endpoint_compare);
+    }
+
+    int* active = sap->active;
+    int active_count = 0;
+    const SapEndpoint* ep = sap->endpoints[0];
+    for (int i = 0; i < n; i++) {
+        int body = ep[i].body;
+        if (!ep[i].is_max) {
+            for (int k = 0; k < active_count; k++) {
+                if (aabb_overlap(sap->boxes[body], sap->boxes[active[k]])) sap_pair_add(sap, body, active[k]);
+            }
+            active[active_count++] = body;
+        } else {
+            for (int k = 0; k < active_count; k++) {
+                if (active[k] == body) {
+                    active[k] = active[--active_count];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// ============================================================================
+// REMOVAL
+// ============================================================================
+
+void sweep_prune_remove(SweepPrune* sap, int index, int last) {
+    int tracked = sap->body_count;
+    if (index >= tracked) return; // Neither body has endpoints yet
+
+    if (sap->pending_removals == 0) {
+        for (int i = 0; i < tracked; i++) {
+            sap->remap[i] = i;
+            sap->owner[i] = i;
+        }
+    }
+    sap->pending_removals++;
+
+    int dead = sap->owner[index];
+    int moved = last < tracked ? sap->owner[last] : -1;
+    if (dead >= 0) sap->remap[dead] = -1;
+    if (index != last) {
+        if (moved >= 0) sap->remap[moved] = index;
+        sap->owner[index] = moved;
+    }
+    if (last < tracked) sap->owner[last] = -1;
+}
+
+/*
+ * Drops the pairs and endpoints of removed bodies and renames the survivors.
+ * Returns the number of bodies left in the endpoint arrays; current indices
+ * below count that no survivor maps to are marked in owner as -1.
+ */
+static int sap_apply_removals(SweepPrune* sap) {
+    const int* remap = sap->remap;
+    int tracked = sap->body_count;
+
+    for (int i = sap->pair_count - 1; i >= 0; i--) {
+        BodyPair p = sap->pairs[i];
+        if (remap[p.a] < 0 || remap[p.b] < 0) sap_pair_remove(sap, p.a, p.b);
+    }
+    for (int i = 0; i < sap->pair_count; i++) {
+        int a = remap[sap->pairs[i].a], b = remap[sap->pairs[i].b];
+        sap->pairs[i] = (a < b) ? (BodyPair){a, b} : (BodyPair){b, a};
+    }
+    if (sap->slot_count) sap_rehash(sap, sap->slot_count);
+
+    int kept = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        SapEndpoint* ep = sap->endpoints[axis];
+        kept = 0;
+        for (int i = 0; i < 2 * tracked; i++) {
+            int body = remap[ep[i].body];
+            if (body < 0) continue;
+            ep[kept] = ep[i];
+            ep[kept].body = body;
+            kept++;
+        }
+    }
+
+    sap->pending_removals = 0;
+    return kept / 2;
+}
+
+bool sweep_prune_update(SweepPrune* sap, const Vec3* position, const float* radius, int count) {
+    int tracked = sap->body_count;
+    int owned = 0;              // Indices below this have a valid owner entry
+    if (sap->pending_removals) {
+        owned = tracked;
+        tracked = sap_apply_removals(sap);
+    }
+
+    // Bodies removed without notification invalidate the indices, and a
+    // lost pair leaves the set incomplete
+    if (count < tracked || sap->lost_pair) {
+        sweep_prune_clear(sap);
+        tracked = 0;
+        owned = 0;
+    }
+    if (!sap_reserve(sap, count)) {
+        sweep_prune_clear(sap);
+        return false;
+    }
+    sap->swaps = 0;
+
+    for (int i = 0; i < count; i++) {
+        sap->boxes[i] = aabb_from_sphere(position[i], radius[i]);
+    }
+
+    int old_count = tracked;
+    sap->body_count = count;
+
+    if (old_count == 0) {
+        for (int axis = 0; axis < 3; axis++) {
+            for (int i = 0; i < count; i++) {
+                sap->endpoints[axis][2 * i + 0] = (SapEndpoint){ sap_axis(sap->boxes[i].min, axis), i, 0 };
+                sap->endpoints[axis][2 * i + 1] = (SapEndpoint){ sap_axis(sap->boxes[i].max, axis), i, 1 };
+            }
+        }
+        sap_build(sap);
+        return true;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        SapEndpoint* ep = sap->endpoints[axis];
+
+        // Refresh values in their old order
+        for (int i = 0; i < 2 * old_count; i++) {
+            const AABB* box = &sap->boxes[ep[i].body];
+            ep[i].value = sap_axis(ep[i].is_max ? box->max : box->min, axis);
+        }
+
+        // New bodies enter at the far end, i.e. overlapping nothing, and are
+        // sorted into place by the same swaps as everything else. After
+        // removals they may also sit at indices vacated by removed bodies.
+        int n = 2 * old_count;
+        for (int i = owned ? 0 : old_count; i < count; i++) {
+            if (i < owned && sap->owner[i] >= 0) continue;
+            ep[n++] = (SapEndpoint){ sap_axis(sap->boxes[i].min, axis), i, 0 };
+            ep[n++] = (SapEndpoint){ sap_axis(sap->boxes[i].max, axis), i, 1 };
+        }
+    }
+
+    // All boxes are current before any axis is sorted, so the overlap test
+    // at each swap sees this frame's state on every axis.
+    for (int axis = 0; axis < 3; axis++) sap_sort_axis(sap, axis);
+    return true;
+}
@@ -0,0 +1,254 @@
+#define _POSIX_C_SOURCE 200809L
+#include "thread_pool.h"
+#include "mem.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    int begin;
+    int end;
+} PoolRange;
+
+// Owner pops at bottom, thieves take from top
+typedef struct {
+    pthread_mutex_t lock;
+    PoolRange* ranges;
+    int top;
+    int bottom;
+    int capacity;
+} WorkDeque;
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+} WorkerArg;
+
+struct ThreadPool {
+    int thread_count;
+    pthread_t* threads;         // thread_count - 1 workers
+    WorkerArg* args;
+    WorkDeque* deques;          // One per participant, 0 = caller
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // New job or shutdown
+    pthread_cond_t done;        // Last worker left the job
+    unsigned long generation;   // Jobs started
+    int busy;                   // Workers still inside the current job
+    bool shutdown;
+
+    // Current job
+    ThreadPoolRangeFn fn;
+    void* user;
+
+    atomic_int steals;
+};
+
+// ============================================================================
+// DEQUES
+// ============================================================================
+
+// False if the deque could not grow; it is left empty
+static bool deque_reset(WorkDeque* d, int capacity) {
+    d->top = 0;
+    d->bottom = 0;
+    if (capacity > d->capacity) {
+        PoolRange* ranges = mem_realloc(d->ranges, capacity * sizeof(PoolRange));
+        if (!ranges) return false;
+        d->ranges = ranges;
+        d->capacity = capacity;
+    }
+    return true;
+}
+
+static bool deque_pop_bottom(WorkDeque* d, PoolRange* out) {
+    bool found = false;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) {
+        *out = d->ranges[--d->bottom];
+        found = true;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+static bool deque_steal_top(WorkDeque* d, PoolRange* out) {
+    bool found = false;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) {
+        *out = d->ranges[d->top++];
+        found = true;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+// ============================================================================
+// WORKERS
+// ============================================================================
+
+// Runs ranges until every deque is empty. No ranges are added during a job,
+// so one failed pass over all deques means the worker is done.
+static void pool_work(ThreadPool* pool, int self) {
+    PoolRange r;
+    for (;;) {
+        if (deque_pop_bottom(&pool->deques[self], &r)) {
+            pool->fn(pool->user, r.begin, r.end);
+            continue;
+        }
+
+        bool stole = false;
+        for (int k = 1; k < pool->thread_count && !stole; k++) {
+            int victim = (self + k) % pool->thread_count;
+            stole = deque_steal_top(&pool->deques[victim], &r);
+        }
+        if (!stole) return;
+
+        atomic_fetch_add_explicit(&pool->steals, 1, memory_order_relaxed);
+        pool->fn(pool->user, r.begin, r.end);
+    }
+}
+
+static void* pool_worker_main(void* p) {
+    WorkerArg* arg = p;
+    ThreadPool* pool = arg->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_work(pool, arg->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+// ============================================================================
+// POOL
+// ============================================================================
+
+int thread_pool_cpu_count() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+ThreadPool* thread_pool_create(int threads) {
+    if (threads <= 0) threads = thread_pool_cpu_count();
+    if (threads > THREAD_POOL_MAX_THREADS) threads = THREAD_POOL_MAX_THREADS;
+
+    ThreadPool* pool = mem_calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+    pool->thread_count = threads;
+    pool->deques = mem_calloc(threads, sizeof(WorkDeque));
+    pool->threads = mem_calloc(threads, sizeof(pthread_t));
+    pool->args = mem_calloc(threads, sizeof(WorkerArg));
+    if (!pool->deques || !pool->threads || !pool->args) {
+        mem_free(pool->deques);
+        mem_free(pool->threads);
+        mem_free(pool->args);
+        mem_free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    atomic_init(&pool->steals, 0);
+
+    for (int i = 0; i < threads; i++) pthread_mutex_init(&pool->deques[i].lock, NULL);
+    for (int i = 1; i < threads; i++) {
+        pool->args[i] = (WorkerArg){ pool, i };
+        if (pthread_create(&pool->threads[i], NULL, pool_worker_main, &pool->args[i]) != 0) {
+            // Run with the workers started so far; destroy sees only their deques
+            for (int d = i; d < threads; d++) pthread_mutex_destroy(&pool->deques[d].lock);
+            pool->thread_count = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->thread_count; i++) pthread_join(pool->threads[i], NULL);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        mem_free(pool->deques[i].ranges);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    mem_free(pool->deques);
+    mem_free(pool->threads);
+    mem_free(pool->args);
+    mem_free(pool);
+}
+
+int thread_pool_size(const ThreadPool* pool) {
+    return pool ? pool->thread_count : 1;
+}
+
+int thread_pool_steal_count(const ThreadPool* pool) {
+    return pool ? atomic_load(&((ThreadPool*)pool)->steals) : 0;
+}
+
+void thread_pool_parallel_for(ThreadPool* pool, int begin, int end, int grain, ThreadPoolRangeFn fn, void* user) {
+    if (end <= begin) return;
+    if (grain < 1) grain = 1;
+    int ranges = (end - begin + grain - 1) / grain;
+    if (!pool || pool->thread_count == 1 || ranges == 1) {
+        fn(user, begin, end);
+        return;
+    }
+
+    // Contiguous blocks per deque keep neighbouring bodies on one core; the
+    // owner pops its block back to front, thieves take from the front.
+    int threads = pool->thread_count;
+    for (int t = 0; t < threads; t++) {
+        WorkDeque* d = &pool->deques[t];
+        int first = (int)((long)ranges * t / threads);
+        int last = (int)((long)ranges * (t + 1) / threads);
+        if (!deque_reset(d, last - first)) {
+            // Out of memory: no worker has been woken yet, so run it here
+            fn(user, begin, end);
+            return;
+        }
+        for (int r = first; r < last; r++) {
+            int b = begin + r * grain;
+            int e = b + grain < end ? b + grain : end;
+            d->ranges[d->bottom++] = (PoolRange){ b, e };
+        }
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->user = user;
+    pool->busy = threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_work(pool, 0);
+
+    // Workers may still be finishing stolen ranges
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
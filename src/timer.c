@@ -0,0 +1,9 @@
+#define _POSIX_C_SOURCE 199309L
+#include "timer.h"
+#include <time.h>
+
+uint64_t timer_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,101 @@
+#include "trail_store.h"
+#include "mem.h"
+#include <string.h>
+
+void trail_store_init(TrailStore* store) {
+    memset(store, 0, sizeof(TrailStore));
+    store->interval = TRAIL_SAMPLE_INTERVAL;
+}
+
+void trail_store_free(TrailStore* store) {
+    mem_free(store->body);
+    mem_free(store->head);
+    mem_free(store->points);
+    mem_free(store->trail_of_slot);
+    memset(store, 0, sizeof(TrailStore));
+}
+
+// Storage is kept
+void trail_store_clear(TrailStore* store) {
+    for (int t = 0; t < store->count; t++) store->trail_of_slot[store->body[t].slot] = -1;
+    store->count = 0;
+    store->countdown = 0;
+}
+
+static bool trail_store_reserve(TrailStore* store, int count) {
+    if (count <= store->capacity) return true;
+    int capacity = store->capacity ? store->capacity * 2 : 16;
+    while (capacity < count) capacity *= 2;
+    BodyHandle* body = mem_realloc(store->body, capacity * sizeof(BodyHandle));
+    if (body) store->body = body;
+    int* head = mem_realloc(store->head, capacity * sizeof(int));
+    if (head) store->head = head;
+    Vec3* points = mem_realloc(store->points, (size_t)capacity * TRAIL_LENGTH * sizeof(Vec3));
+    if (points) store->points = points;
+    if (!body || !head || !points) return false;
+    store->capacity = capacity;
+    return true;
+}
+
+// Covers handle slots [0, slot]
+static bool trail_store_reserve_slots(TrailStore* store, uint32_t slot) {
+    if (slot < (uint32_t)store->slot_capacity) return true;
+    int capacity = store->slot_capacity ? store->slot_capacity * 2 : 64;
+    while ((uint32_t)capacity <= slot) capacity *= 2;
+    int* trail_of_slot = mem_realloc(store->trail_of_slot, capacity * sizeof(int));
+    if (!trail_of_slot) return false;
+    for (int s = store->slot_capacity; s < capacity; s++) trail_of_slot[s] = -1;
+    store->trail_of_slot = trail_of_slot;
+    store->slot_capacity = capacity;
+    return true;
+}
+
+int trail_store_add(TrailStore* store, BodyHandle body, Vec3 position) {
+    if (!trail_store_reserve_slots(store, body.slot) || !trail_store_reserve(store, store->count + 1)) return -1;
+    int t = store->count++;
+    store->trail_of_slot[body.slot] = t;
+    store->body[t] = body;
+    store->head[t] = 0;
+    Vec3* ring = &store->points[(size_t)t * TRAIL_LENGTH];
+    for (int k = 0; k < TRAIL_LENGTH; k++) ring[k] = position;
+    return t;
+}
+
+bool trail_store_remove(TrailStore* store, BodyHandle body) {
+    if (body.slot >= (uint32_t)store->slot_capacity) return false;
+    int t = store->trail_of_slot[body.slot];
+    if (t < 0 || t >= store->count) return false;
+    if (store->body[t].slot != body.slot || store->body[t].generation != body.generation) return false;
+
+    store->trail_of_slot[body.slot] = -1;
+    int last = --store->count;
+    if (t != last) {
+        store->body[t] = store->body[last];
+        store->head[t] = store->head[last];
+        memcpy(&store->points[(size_t)t * TRAIL_LENGTH], &store->points[(size_t)last * TRAIL_LENGTH],
+               TRAIL_LENGTH * sizeof(Vec3));
+        store->trail_of_slot[store->body[t].slot] = t;
+    }
+    return true;
+}
+
+// Static bodies keep their collapsed trail
+void trail_store_sample(TrailStore* store, const BodyStore* bodies) {
+    if (store->count == 0) return;
+    if (store->countdown-- > 0) return;
+    store->countdown = (store->interval > 1 ? store->interval : 1) - 1;
+
+    for (int t = 0; t < store->count; t++) {
+        int i = body_store_index(bodies, store->body[t]);
+        if (i < 0 || (bodies->flags[i] & BODY_FLAG_STATIC)) continue;
+        store->points[(size_t)t * TRAIL_LENGTH + store->head[t]] = bodies->position[i];
+        store->head[t] = (store->head[t] + 1) % TRAIL_LENGTH;
+    }
+}
+
+void trail_store_read(const TrailStore* store, int trail, Vec3* out) {
+    const Vec3* ring = &store->points[(size_t)trail * TRAIL_LENGTH];
+    int head = store->head[trail];
+    memcpy(out, &ring[head], (TRAIL_LENGTH - head) * sizeof(Vec3));
+    memcpy(&out[TRAIL_LENGTH - head], ring, head * sizeof(Vec3));
+}
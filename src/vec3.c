@@ -96,6 +96,19 @@ Quat quat_normalize(Quat q) {
     return quat_identity();
 }
 
+// q and -q are the same rotation; flip b onto a's hemisphere before blending
+Quat quat_nlerp(Quat a, Quat b, float t) {
+    float dot = a.w*b.w + a.x*b.x + a.y*b.y + a.z*b.z;
+    float s = dot < 0.0f ? -t : t;
+    Quat r = {
+        a.w + (b.w*s - a.w*t),
+        a.x + (b.x*s - a.x*t),
+        a.y + (b.y*s - a.y*t),
+        a.z + (b.z*s - a.z*t)
+    };
+    return quat_normalize(r);
+}
+
 // Rotate vector v by quaternion q
 // v' = q v q* (where v is treated as pure imaginary quaternion)
 Vec3 quat_rotate_vec(Quat q, Vec3 v) {
@@ -140,6 +153,14 @@ Mat3 mat3_zero() {
     return (Mat3){{{0}}};
 }
 
+Mat3 mat3_mul(Mat3 a, Mat3 b) {
+    Mat3 r;
+    for(int i=0; i<3; i++)
+        for(int j=0; j<3; j++)
+            r.m[i][j] = a.m[i][0]*b.m[0][j] + a.m[i][1]*b.m[1][j] + a.m[i][2]*b.m[2][j];
+    return r;
+}
+
 Vec3 mat3_mul_vec(Mat3 m, Vec3 v) {
     return (Vec3){
         m.m[0][0]*v.x + m.m[0][1]*v.y + m.m[0][2]*v.z,
@@ -156,6 +177,25 @@ Mat3 mat3_transpose(Mat3 m) {
     return r;
 }
 
+// (R D Rᵀ)ᵢⱼ = Σₖ Rᵢₖ dₖ Rⱼₖ; the result is symmetric
+Mat3 mat3_rotate_diagonal(Mat3 r, Vec3 d) {
+    Mat3 res;
+    for(int i=0; i<3; i++) {
+        Vec3 rd = { r.m[i][0] * d.x, r.m[i][1] * d.y, r.m[i][2] * d.z };
+        for(int j=i; j<3; j++) {
+            res.m[i][j] = rd.x * r.m[j][0] + rd.y * r.m[j][1] + rd.z * r.m[j][2];
+            res.m[j][i] = res.m[i][j];
+        }
+    }
+    return res;
+}
+
+float mat3_det(Mat3 m) {
+    return m.m[0][0] * (m.m[1][1] * m.m[2][2] - m.m[2][1] * m.m[1][2]) -
+           m.m[0][1] * (m.m[1][0] * m.m[2][2] - m.m[1][2] * m.m[2][0]) +
+           m.m[0][2] * (m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0]);
+}
+
 Mat3 mat3_inverse(Mat3 m) {
     float det = m.m[0][0] * (m.m[1][1] * m.m[2][2] - m.m[2][1] * m.m[1][2]) -
                 m.m[0][1] * (m.m[1][0] * m.m[2][2] - m.m[1][2] * m.m[2][0]) +
@@ -184,6 +224,26 @@ Mat4 mat4_identity() {
     return m;
 }
 
+Mat4 mat4_translate(Vec3 t) {
+    Mat4 m = mat4_identity();
+    m.m[0][3] = t.x; m.m[1][3] = t.y; m.m[2][3] = t.z;
+    return m;
+}
+
+Mat4 mat4_scale(Vec3 s) {
+    Mat4 m = mat4_identity();
+    m.m[0][0] = s.x; m.m[1][1] = s.y; m.m[2][2] = s.z;
+    return m;
+}
+
+Mat4 mat4_mul(Mat4 a, Mat4 b) {
+    Mat4 r;
+    for(int i=0; i<4; i++)
+        for(int j=0; j<4; j++)
+            r.m[i][j] = a.m[i][0]*b.m[0][j] + a.m[i][1]*b.m[1][j] + a.m[i][2]*b.m[2][j] + a.m[i][3]*b.m[3][j];
+    return r;
+}
+
 Mat4 mat4_from_quat_pos(Quat q, Vec3 p) {
     Mat3 rot = quat_to_mat3(q);
     Mat4 res = {{{0}}};
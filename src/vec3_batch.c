@@ -0,0 +1,108 @@
+#include "vec3_batch.h"
+#include "simd.h"
+
+const char* simd_backend_name() {
+    return SIMD_BACKEND;
+}
+
+int simd_width() {
+    return SIMD_WIDTH;
+}
+
+void quat_batch_normalize(Quat* q, int n) {
+    int i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        quat_lanes_store(&q[i], quat_lanes_normalize(quat_lanes_load(&q[i])));
+    }
+    for (; i < n; i++) q[i] = quat_normalize(q[i]);
+}
+
+void quat_batch_integrate(Quat* q, const Vec3* w, float dt, int n) {
+    int i = 0;
+    Lanes half = lanes_set1(0.5f), dt_l = lanes_set1(dt);
+    Lanes zero = lanes_set1(0.0f);
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        QuatLanes qi = quat_lanes_load(&q[i]);
+        Vec3Lanes wi = vec3_lanes_load(&w[i]);
+        QuatLanes spin = quat_lanes_mul((QuatLanes){ zero, wi.x, wi.y, wi.z }, qi);
+        qi.w = lanes_add(qi.w, lanes_mul(lanes_mul(spin.w, half), dt_l));
+        qi.x = lanes_add(qi.x, lanes_mul(lanes_mul(spin.x, half), dt_l));
+        qi.y = lanes_add(qi.y, lanes_mul(lanes_mul(spin.y, half), dt_l));
+        qi.z = lanes_add(qi.z, lanes_mul(lanes_mul(spin.z, half), dt_l));
+        quat_lanes_store(&q[i], quat_lanes_normalize(qi));
+    }
+    for (; i < n; i++) {
+        Quat spin = quat_mul((Quat){0, w[i].x, w[i].y, w[i].z}, q[i]);
+        q[i].w += spin.w * 0.5f * dt;
+        q[i].x += spin.x * 0.5f * dt;
+        q[i].y += spin.y * 0.5f * dt;
+        q[i].z += spin.z * 0.5f * dt;
+        q[i] = quat_normalize(q[i]);
+    }
+}
+
+void mat3_batch_inverse(Mat3* out, const Mat3* m, int n) {
+    int i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        Mat3Lanes mi = mat3_lanes_load(&m[i]);
+        mat3_lanes_store(&out[i], mat3_lanes_inverse(&mi));
+    }
+    for (; i < n; i++) out[i] = mat3_inverse(m[i]);
+}
+
+void mat3_batch_rotate_inertia(Mat3* out, const Quat* q, const Mat3* inv_body, int n) {
+    int i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        Mat3Lanes r = quat_lanes_to_mat3(quat_lanes_load(&q[i]));
+        Mat3Lanes ib = mat3_lanes_load(&inv_body[i]);
+        mat3_lanes_store(&out[i], mat3_lanes_similarity(&r, &ib));
+    }
+    for (; i < n; i++) {
+        Mat3 r = quat_to_mat3(q[i]);
+        out[i] = mat3_mul(mat3_mul(r, inv_body[i]), mat3_transpose(r));
+    }
+}
+
+int sphere_batch_overlap(const Vec3* position, const float* radius, const int* pairs, int n, uint8_t* hit) {
+    int hits = 0;
+    int i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        int ia[SIMD_WIDTH], ib[SIMD_WIDTH];
+        Vec3 pa[SIMD_WIDTH], pb[SIMD_WIDTH];
+        for (int l = 0; l < SIMD_WIDTH; l++) {
+            ia[l] = pairs[2 * (i + l)];
+            ib[l] = pairs[2 * (i + l) + 1];
+            pa[l] = position[ia[l]];
+            pb[l] = position[ib[l]];
+        }
+        Vec3Lanes a = vec3_lanes_load(pa), b = vec3_lanes_load(pb);
+        Lanes dx = lanes_sub(b.x, a.x), dy = lanes_sub(b.y, a.y), dz = lanes_sub(b.z, a.z);
+        Lanes dist_sq = lanes_add(lanes_add(lanes_mul(dx, dx), lanes_mul(dy, dy)), lanes_mul(dz, dz));
+        Lanes r = lanes_add(lanes_gather(radius, ia), lanes_gather(radius, ib));
+        int mask = lanes_movemask(lanes_lt(dist_sq, lanes_mul(r, r)));
+        for (int l = 0; l < SIMD_WIDTH; l++) {
+            hit[i + l] = (mask >> l) & 1;
+            hits += hit[i + l];
+        }
+    }
+    for (; i < n; i++) {
+        int a = pairs[2 * i], b = pairs[2 * i + 1];
+        float r = radius[a] + radius[b];
+        hit[i] = vec3_dist_sq(position[a], position[b]) < r * r;
+        hits += hit[i];
+    }
+    return hits;
+}
+
+// Each sphere is three multiplies and a compare; transposing Vec3s into
+// lanes costs more than that (bench --simd)
+int sphere_batch_plane(const Vec3* position, const float* radius, int n, Vec3 normal, float offset, uint8_t* hit) {
+    int hits = 0;
+    for (int i = 0; i < n; i++) {
+        Vec3 p = position[i];
+        uint8_t h = p.x * normal.x + p.y * normal.y + p.z * normal.z - radius[i] < offset;
+        hit[i] = h;
+        hits += h;
+    }
+    return hits;
+}